@@ -7,6 +7,7 @@
 #include "BookmarkBar.h"
 
 #include <Alert.h>
+#include <Bitmap.h>
 #include <Invoker.h>
 #include <OS.h>
 #include <Catalog.h>
@@ -25,9 +26,12 @@
 
 #include "tracker_private.h"
 
+#include "BookmarkManager.h"
 #include "BrowserWindow.h"
+#include "IconCache.h"
 #include "NavMenu.h"
 
+#include <new>
 #include <stdio.h>
 #include <vector>
 
@@ -39,14 +43,22 @@ const uint32 kDeleteMsg = 'dele';
 const uint32 kAskBookmarkNameMsg = 'askn';
 const uint32 kShowInTrackerMsg = 'otrk';
 const uint32 kRenameBookmarkMsg = 'rena';
+const uint32 kAskBookmarkTagsMsg = 'askt';
+const uint32 kSetBookmarkTagsMsg = 'tags';
 const uint32 kFolderMsg = 'fold';
 
 const uint32 kMsgInitialBookmarksLoaded = 'ibld';
 const uint32 kMsgBookmarksLoadingFinished = 'blfi';
 
+// Rough width of a bar item besides its label: icon, spacing and insets
+static const float kItemExtraWidth = B_MINI_ICON + 20;
+static const size_t kLoadBatchSize = 100;
+
 struct LoaderParams {
 	node_ref dirRef;
 	BMessenger target;
+	BFont font;
+	float width;
 };
 
 struct BookmarkItem {
@@ -80,7 +92,54 @@ CreateBookmarkItem(BEntry* entry, BHandler* handler)
 		BNodeInfo info(&node);
 		BMessage* message = new BMessage(B_REFS_RECEIVED);
 		message->AddRef("refs", &ref);
-		return new IconMenuItem(name, message, &info, B_MINI_ICON);
+
+		// The bookmarks of a site all carry its icon, it only needs to be
+		// decoded once for all of them.
+		BString url;
+		BString iconKey;
+		if (BookmarkManager::ReadURLAttr(node, url))
+			iconKey = IconCache::KeyForURL(url);
+		if (iconKey.IsEmpty())
+			return new IconMenuItem(name, message, &info, B_MINI_ICON);
+
+		IconCache::IconRef icon = IconCache::Default().Get(iconKey);
+		if (icon != NULL) {
+			return new IconMenuItem(name, message,
+				const_cast<BBitmap*>(icon.get()), B_MINI_ICON);
+		}
+
+		BBitmap* ownIcon = new(std::nothrow) BBitmap(
+			BRect(0, 0, B_MINI_ICON - 1, B_MINI_ICON - 1),
+			B_BITMAP_NO_SERVER_LINK, B_RGBA32);
+		if (ownIcon == NULL || ownIcon->InitCheck() != B_OK
+			|| info.GetIcon(ownIcon, B_MINI_ICON) != B_OK) {
+			// Without an icon of its own, the bookmark gets the one of its
+			// type
+			delete ownIcon;
+			return new IconMenuItem(name, message, &info, B_MINI_ICON);
+		}
+
+		IconCache::Default().Put(iconKey, ownIcon);
+		BMenuItem* item = new IconMenuItem(name, message, ownIcon, B_MINI_ICON);
+		delete ownIcon;
+		return item;
+	}
+}
+
+
+static void
+SendBookmarkItems(const BMessenger& target, std::vector<BookmarkItem*>* items,
+	bool visible)
+{
+	BMessage message(kMsgInitialBookmarksLoaded);
+	message.AddPointer("list", items);
+	message.AddBool("visible", visible);
+	if (target.SendMessage(&message) != B_OK) {
+		for (size_t i = 0; i < items->size(); i++) {
+			delete (*items)[i]->item;
+			delete (*items)[i];
+		}
+		delete items;
 	}
 }
 
@@ -92,49 +151,50 @@ LoadBookmarksThread(void* data)
 	BDirectory dir(&params->dirRef);
 	BEntry bookmark;
 
+	// The items which fit into the bar are sent on their own, so it can
+	// show them right away. The others only end up in the overflow menu,
+	// they are loaded with less urgency and in larger batches.
+	bool visible = true;
+	float width = 0;
+
 	std::vector<BookmarkItem*>* items = new std::vector<BookmarkItem*>();
-	items->reserve(100);
+	items->reserve(kLoadBatchSize);
 
 	while (dir.GetNextEntry(&bookmark, false) == B_OK) {
 		node_ref ref;
-		if (bookmark.GetNodeRef(&ref) == B_OK) {
-			BMenuItem* item = CreateBookmarkItem(&bookmark, NULL);
-			if (item) {
-				BookmarkItem* bookmarkItem = new BookmarkItem;
-				bookmarkItem->inode = ref.node;
-				bookmarkItem->item = item;
-				items->push_back(bookmarkItem);
-
-				if (items->size() >= 100) {
-					BMessage message(kMsgInitialBookmarksLoaded);
-					message.AddPointer("list", items);
-					if (params->target.SendMessage(&message) != B_OK) {
-						for (size_t i = 0; i < items->size(); i++) {
-							delete (*items)[i]->item;
-							delete (*items)[i];
-						}
-						delete items;
-					}
-					items = new std::vector<BookmarkItem*>();
-					items->reserve(100);
-				}
-			}
+		if (bookmark.GetNodeRef(&ref) != B_OK)
+			continue;
+
+		BMenuItem* item = CreateBookmarkItem(&bookmark, NULL);
+		if (item == NULL)
+			continue;
+
+		BookmarkItem* bookmarkItem = new BookmarkItem;
+		bookmarkItem->inode = ref.node;
+		bookmarkItem->item = item;
+		items->push_back(bookmarkItem);
+
+		if (visible) {
+			width += params->font.StringWidth(item->Label()) + kItemExtraWidth;
+			if (width <= params->width)
+				continue;
+		} else if (items->size() < kLoadBatchSize)
+			continue;
+
+		SendBookmarkItems(params->target, items, visible);
+		items = new std::vector<BookmarkItem*>();
+		items->reserve(kLoadBatchSize);
+
+		if (visible) {
+			visible = false;
+			set_thread_priority(find_thread(NULL), B_LOW_PRIORITY);
 		}
 	}
 
-	if (!items->empty()) {
-		BMessage message(kMsgInitialBookmarksLoaded);
-		message.AddPointer("list", items);
-		if (params->target.SendMessage(&message) != B_OK) {
-			for (size_t i = 0; i < items->size(); i++) {
-				delete (*items)[i]->item;
-				delete (*items)[i];
-			}
-			delete items;
-		}
-	} else {
+	if (!items->empty())
+		SendBookmarkItems(params->target, items, visible);
+	else
 		delete items;
-	}
 
 	params->target.SendMessage(kMsgBookmarksLoadingFinished);
 
@@ -158,6 +218,8 @@ BookmarkBar::BookmarkBar(const char* title, BHandler* target,
 	fPopUpMenu->AddItem(
 		new BMenuItem(B_TRANSLATE("Open in new tab"), new BMessage(kOpenNewTabMsg)));
 	fPopUpMenu->AddItem(new BMenuItem(B_TRANSLATE("Rename"), new BMessage(kAskBookmarkNameMsg)));
+	fPopUpMenu->AddItem(new BMenuItem(B_TRANSLATE("Edit tags" B_UTF8_ELLIPSIS),
+		new BMessage(kAskBookmarkTagsMsg)));
 	fPopUpMenu->AddItem(
 		new BMenuItem(B_TRANSLATE("Show in Tracker"), new BMessage(kShowInTrackerMsg)));
 	fPopUpMenu->AddItem(new BSeparatorItem());
@@ -193,11 +255,11 @@ BookmarkBar::MouseDown(BPoint where)
 				if (foundItem) {
 					BPoint screenWhere(where);
 					ConvertToScreen(&screenWhere);
-					if (ItemAt(fSelectedItemIndex)->Message()->what == kFolderMsg) {
-						// This is a directory item, disable "open in new tab"
-						fPopUpMenu->ItemAt(0)->SetEnabled(false);
-					} else
-						fPopUpMenu->ItemAt(0)->SetEnabled(true);
+					// Directory items can't be opened in a tab, nor tagged
+					bool isFolder
+						= ItemAt(fSelectedItemIndex)->Message()->what == kFolderMsg;
+					fPopUpMenu->ItemAt(0)->SetEnabled(!isFolder);
+					fPopUpMenu->FindItem(kAskBookmarkTagsMsg)->SetEnabled(!isFolder);
 
 					// Pop up the menu
 					fPopUpMenu->SetTargetForItems(this);
@@ -222,6 +284,11 @@ BookmarkBar::AttachedToWindow()
 	LoaderParams* params = new LoaderParams;
 	params->dirRef = fNodeRef;
 	params->target = BMessenger(this);
+	GetFont(&params->font);
+	// Before the first layout, the bar will be about as wide as the window
+	params->width = Bounds().Width();
+	if (params->width < 1)
+		params->width = Window()->Bounds().Width();
 
 	thread_id loader = spawn_thread(LoadBookmarksThread, "BookmarkLoader",
 		B_NORMAL_PRIORITY, params);
@@ -305,6 +372,12 @@ BookmarkBar::MessageReceived(BMessage* message)
 					delete data;
 				}
 				delete list;
+
+				// Lay out what fits into the bar without waiting for the rest
+				if (addedAny && message->GetBool("visible", false)) {
+					BRect rect = Bounds();
+					FrameResized(rect.Width(), rect.Height());
+				}
 			}
 			break;
 		}
@@ -568,6 +641,59 @@ BookmarkBar::MessageReceived(BMessage* message)
 			break;
 		}
 
+		case kAskBookmarkTagsMsg:
+		{
+			if (fSelectedItemIndex < 0 || fSelectedItemIndex >= CountItems())
+				break;
+
+			BMenuItem* selectedItem = ItemAt(fSelectedItemIndex);
+			entry_ref ref;
+			if (selectedItem->Message()->FindRef("refs", &ref) != B_OK)
+				break;
+
+			BString tags;
+			BNode node(&ref);
+			node.ReadAttrString("META:keyw", &tags);
+
+			BMessage* message = new BMessage(kSetBookmarkTagsMsg);
+			message->AddRef("refs", &ref);
+			// The tags are searched for when typing in the URL bar
+			PromptWindow* prompt = new PromptWindow(B_TRANSLATE("Edit tags"),
+				B_TRANSLATE("Tags:"),
+				B_TRANSLATE("Clear the field to remove all tags."), this,
+				message);
+			// Start from the current tags, so that accepting the prompt
+			// right away leaves them as they are. PromptWindow has no API
+			// for the initial text, its control is found by name.
+			BTextControl* control = dynamic_cast<BTextControl*>(
+				prompt->FindView("promptcontrol"));
+			if (control != NULL) {
+				control->SetText(tags.String());
+				control->TextView()->SelectAll();
+			}
+			prompt->Show();
+			prompt->CenterOnScreen();
+			break;
+		}
+		case kSetBookmarkTagsMsg:
+		{
+			entry_ref ref;
+			if (message->FindRef("refs", &ref) != B_OK)
+				break;
+
+			// Only an explicitly emptied field removes the tags
+			BString tags;
+			if (message->FindString("text", &tags) != B_OK)
+				break;
+			tags.Trim();
+			BNode node(&ref);
+			if (tags.IsEmpty())
+				node.RemoveAttr("META:keyw");
+			else
+				node.WriteAttrString("META:keyw", &tags);
+			break;
+		}
+
 		default:
 			BMenuBar::MessageReceived(message);
 			break;
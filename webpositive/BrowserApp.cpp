@@ -50,14 +50,24 @@
 
 #include <OS.h>
 
+#include "BookmarkIndex.h"
+#include "BookmarkManager.h"
+#include "BookmarkMonitor.h"
 #include "BrowserWindow.h"
 #include "BrowsingHistory.h"
+#include "ClosedTabStore.h"
 #include "DownloadWindow.h"
 #include "SettingsMessage.h"
 #include "SettingsWindow.h"
 #include "ConsoleWindow.h"
 #include "CookieWindow.h"
 #include "NetworkCookieJar.h"
+#include "PreviewCache.h"
+#include "SessionJournal.h"
+#include "TabDiscardPolicy.h"
+#include "TabRegistry.h"
+#include "SettingsKeys.h"
+#include "TabManager.h"
 #include "WebKitInfo.h"
 #include "WebPage.h"
 #include "WebSettings.h"
@@ -74,6 +84,7 @@ const char* kApplicationName = B_TRANSLATE_SYSTEM_NAME("WebPositive");
 static const uint32 PRELOAD_BROWSING_HISTORY = 'plbh';
 static const uint32 AUTO_SAVE_SESSION = 'assn';
 static const uint32 DOWNLOAD_QUIT_CONFIRMED = 'dlqc';
+static const char* kBookmarkIndexName = "BookmarkIndex";
 static char sCrashLogPath[B_PATH_NAME_LENGTH];
 
 
@@ -139,12 +150,18 @@ BrowserApp::BrowserApp()
 	fSettings(NULL),
 	fCookies(NULL),
 	fSession(NULL),
+	fSessionJournal(NULL),
+	fClosedTabStore(NULL),
+	fBookmarkIndex(NULL),
+	fBookmarkMonitor(NULL),
 	fContext(NULL),
 	fDownloadWindow(NULL),
 	fSettingsWindow(NULL),
 	fConsoleWindow(NULL),
 	fCookieWindow(NULL),
 	fAutoSaver(NULL),
+	fMemoryMonitor(NULL),
+	fTabRegistry(NULL),
 	fForceQuit(false)
 {
 #ifdef __i386__
@@ -196,17 +213,36 @@ BrowserApp::BrowserApp()
 		sessionStorePath.String());
 
 	// Crash-safe autosave recovery
-	BString autoSavePath = sessionStorePath;
-	autoSavePath << ".autosave";
 	BPath autoSaveFile;
-	if (find_directory(B_USER_SETTINGS_DIRECTORY, &autoSaveFile) == B_OK
-		&& autoSaveFile.Append(autoSavePath.String()) == B_OK) {
-		BEntry autoSaveEntry(autoSaveFile.Path());
-		if (autoSaveEntry.Exists()) {
-			// A crash occurred or unclean shutdown. Load the autosave.
-			delete fSession;
-			fSession = new SettingsMessage(B_USER_SETTINGS_DIRECTORY,
-				autoSavePath.String());
+	BPath journalFile;
+	if (find_directory(B_USER_SETTINGS_DIRECTORY, &autoSaveFile) == B_OK) {
+		autoSaveFile.Append(kApplicationName);
+		journalFile = autoSaveFile;
+		autoSaveFile.Append("Session.autosave");
+		journalFile.Append("Session.journal");
+	}
+	fSessionJournal = new SessionJournal(autoSaveFile, journalFile);
+	fTabRegistry = new TabRegistry();
+
+	BPath closedTabsFile;
+	if (find_directory(B_USER_SETTINGS_DIRECTORY, &closedTabsFile) == B_OK) {
+		closedTabsFile.Append(kApplicationName);
+		closedTabsFile.Append("ClosedTabs");
+	}
+	fClosedTabStore = new ClosedTabStore(closedTabsFile);
+	fClosedTabStore->Load();
+	ClosedTabStore::SetDefault(fClosedTabStore);
+
+	BMessage recoveredSession;
+	if (fSessionJournal->HasSession()
+		&& fSessionJournal->Recover(recoveredSession) == B_OK) {
+		// A crash occurred or unclean shutdown. Restore what the journal
+		// recorded instead of the last cleanly saved session.
+		fSession->MakeEmpty();
+		BMessage windowArchive;
+		for (int32 i = 0; recoveredSession.FindMessage("window", i,
+				&windowArchive) == B_OK; i++) {
+			fSession->AddMessage("window", &windowArchive);
 		}
 	}
 
@@ -234,7 +270,27 @@ BrowserApp::~BrowserApp()
 	delete fSettings;
 	delete fCookies;
 	delete fSession;
+	delete fSessionJournal;
 	delete fAutoSaver;
+	delete fMemoryMonitor;
+	delete fTabRegistry;
+	delete fClosedTabStore;
+
+	if (fBookmarkMonitor != NULL) {
+		fBookmarkMonitor->Stop();
+		if (Lock()) {
+			RemoveHandler(fBookmarkMonitor);
+			Unlock();
+		}
+		delete fBookmarkMonitor;
+	}
+	if (fBookmarkIndex != NULL && fBookmarkIndex->Lock()) {
+		// Only a complete index is worth keeping
+		if (fBookmarkIndex->IsReady() && fBookmarkIndexPath.InitCheck() == B_OK)
+			fBookmarkIndex->Save(fBookmarkIndexPath.Path());
+		fBookmarkIndex->Unlock();
+	}
+	delete fBookmarkIndex;
 }
 
 
@@ -319,6 +375,16 @@ BrowserApp::ReadyToRun()
 		mainSettingsPath.String());
 
 	fLastWindowFrame = fSettings->GetValue("window frame", fLastWindowFrame);
+
+	// Tab previews of all windows share a single memory budget (in KiB)
+	int32 previewBudget = fSettings->GetValue(kSettingsKeyPreviewCacheBudget,
+		(int32)(PreviewCache::kDefaultBudget / 1024));
+	if (fSettings->GetValue(kSettingsKeyLowRAMMode, false)) {
+		previewBudget /= 4;
+		PreviewCache::Snapshots().SetBudget(
+			PreviewCache::kLowRAMSnapshotBudget);
+	}
+	PreviewCache::Default().SetBudget((size_t)previewBudget * 1024);
 	BRect defaultDownloadWindowFrame(-10, -10, 365, 265);
 	BRect downloadWindowFrame = fSettings->GetValue("downloads window frame",
 		defaultDownloadWindowFrame);
@@ -352,13 +418,32 @@ BrowserApp::ReadyToRun()
 	fConsoleWindow = new ConsoleWindow(consoleWindowFrame);
 	fCookieWindow = new CookieWindow(cookieWindowFrame, fContext->GetCookieJar());
 
+	// Bookmarks are indexed in the background, and the index is kept
+	// current afterwards, so looking them up does not need the disk. The
+	// index saved on the last quit can be searched until then.
+	BPath bookmarkPath;
+	if (BookmarkManager::GetBookmarkPath(bookmarkPath) == B_OK) {
+		fBookmarkIndex = new BookmarkIndex();
+		bookmarkPath.GetParent(&fBookmarkIndexPath);
+		if (fBookmarkIndexPath.Append(kBookmarkIndexName) == B_OK)
+			fBookmarkIndex->Load(fBookmarkIndexPath.Path());
+		BookmarkIndex::SetDefault(fBookmarkIndex);
+		fBookmarkMonitor = new BookmarkMonitor(fBookmarkIndex);
+		AddHandler(fBookmarkMonitor);
+		fBookmarkMonitor->Start(bookmarkPath);
+	}
+
 	fInitialized = true;
 
 	int32 pagesCreated = 0;
 	bool fullscreen = false;
 
+	// Start recording this session. Windows report their tabs as they are
+	// restored below.
+	fSessionJournal->Start();
+
 	// Handle startup session / page
-	if (fSession->InitCheck() == B_OK) {
+	if (fSession->InitCheck() == B_OK || fSession->HasMessage("window")) {
 		const char* kSettingsKeyStartUpPolicy = "start up policy";
 		uint32 fStartUpPolicy = fSettings->GetValue(kSettingsKeyStartUpPolicy,
 			(uint32)ResumePriorSession);
@@ -374,22 +459,7 @@ BrowserApp::ReadyToRun()
 			BMessage archivedWindow;
 			for (int32 i = 0; fSession->FindMessage("window", i, &archivedWindow)
 				== B_OK; i++) {
-				BRect frame = archivedWindow.FindRect("window frame");
-				uint32 workspaces = B_CURRENT_WORKSPACE;
-				archivedWindow.FindUInt32("window workspaces", 0, &workspaces);
-				BString url;
-				archivedWindow.FindString("tab", 0, &url);
-				BrowserWindow* window = new BrowserWindow(frame, fSettings, url,
-					fContext, INTERFACE_ELEMENT_ALL, NULL, workspaces, false);
-
-				window->Show();
-				pagesCreated++;
-
-				for (int j = 1; archivedWindow.FindString("tab", j, &url)
-					== B_OK; j++) {
-					_CreateNewTab(window, url, false, true);
-					pagesCreated++;
-				}
+				_RestoreWindow(archivedWindow, pagesCreated);
 			}
 		}
 	}
@@ -407,9 +477,16 @@ BrowserApp::ReadyToRun()
 
 	PostMessage(PRELOAD_BROWSING_HISTORY);
 
+	// Periodically fold the session journal into a snapshot
 	BMessage autoSaveMessage(AUTO_SAVE_SESSION);
 	fAutoSaver = new BMessageRunner(be_app_messenger, &autoSaveMessage,
 		60000000); // 60 seconds
+
+	// Watch memory for all windows in one place; windows are only told to
+	// unload tabs once memory actually runs low.
+	BMessage memoryMessage(CHECK_MEMORY_PRESSURE);
+	fMemoryMonitor = new BMessageRunner(be_app_messenger, &memoryMessage,
+		5000000); // 5 seconds
 }
 
 
@@ -510,6 +587,11 @@ BrowserApp::MessageReceived(BMessage* message)
 	case WINDOW_CLOSED:
 		fWindowCount--;
 		message->FindRect("window frame", &fLastWindowFrame);
+		if (fWindowCount > 0 && !message->GetBool("private", false)
+			&& message->HasMessage("tab state")) {
+			// The last window is kept in the session instead
+			fClosedTabStore->AddWindow(*message, false);
+		}
 		if (fWindowCount <= 0) {
 			BMessage* message = new BMessage(B_QUIT_REQUESTED);
 			BMessage* detachedMessage = DetachCurrentMessage();
@@ -536,7 +618,69 @@ BrowserApp::MessageReceived(BMessage* message)
 		break;
 
 	case AUTO_SAVE_SESSION:
-		_SaveSession();
+		if (fSessionJournal->CountPendingRecords() > 0)
+			fSessionJournal->Compact();
+		break;
+
+	case CHECK_MEMORY_PRESSURE:
+		_CheckMemoryPressure();
+		break;
+
+	case REOPEN_CLOSED_WINDOW:
+	{
+		ClosedTabStore::Entry entry;
+		uint32 id;
+		bool found = message->FindUInt32("id", &id) == B_OK
+			? fClosedTabStore->Take(id, entry)
+			: fClosedTabStore->TakeLast(ClosedTabStore::kWindow, false, entry);
+		if (found && entry.kind == ClosedTabStore::kWindow) {
+			int32 pagesCreated = 0;
+			_RestoreWindow(entry.archive, pagesCreated);
+		}
+		break;
+	}
+
+	case COLLECT_TAB_SEARCH_ENTRIES:
+		// Every window answers the tab search on its own
+		for (int32 i = 0; BWindow* window = WindowAt(i); i++) {
+			if (dynamic_cast<BrowserWindow*>(window) != NULL)
+				window->PostMessage(message);
+		}
+		break;
+
+	case TAB_STATE_CHANGED:
+	{
+		TabDiscardPolicy::TabInfo tab;
+		tab.id = message->GetUInt32("tab", 0);
+		tab.lastActivation = message->GetInt64("last activation", 0);
+		tab.estimatedCost = message->GetUInt64("cost", 0);
+		tab.loaded = message->GetBool("loaded", false);
+		tab.current = message->GetBool("current", false);
+		tab.loading = message->GetBool("loading", false);
+		tab.pinned = message->GetBool("pinned", false);
+		tab.playingMedia = message->GetBool("playing media", false);
+		tab.dirtyForm = message->GetBool("dirty form", false);
+		fTabRegistry->Update(message->GetUInt32("window", 0), tab);
+		break;
+	}
+
+	case SessionJournal::kWindowClosed:
+		fTabRegistry->RemoveWindow(message->GetUInt32("window", 0));
+		fSessionJournal->Record(*message);
+		break;
+
+	case SessionJournal::kTabClosed:
+		fTabRegistry->Remove(message->GetUInt32("tab", 0));
+		fSessionJournal->Record(*message);
+		break;
+
+	case SessionJournal::kWindowOpened:
+	case SessionJournal::kWindowChanged:
+	case SessionJournal::kTabOpened:
+	case SessionJournal::kTabNavigated:
+	case SessionJournal::kTabMoved:
+	case SessionJournal::kTabSelected:
+		fSessionJournal->Record(*message);
 		break;
 
 	case DOWNLOAD_QUIT_CONFIRMED:
@@ -657,16 +801,8 @@ BrowserApp::QuitRequested()
 	if (cookieJar.Archive(&cookieArchive) == B_OK)
 		fCookies->SetValue("cookies", cookieArchive);
 
-	// Remove autosave file on clean exit
-	BString autoSavePath(kApplicationName);
-	autoSavePath << "/Session.autosave";
-	BPath autoSaveFile;
-	if (find_directory(B_USER_SETTINGS_DIRECTORY, &autoSaveFile) == B_OK
-		&& autoSaveFile.Append(autoSavePath.String()) == B_OK) {
-		BEntry autoSaveEntry(autoSaveFile.Path());
-		if (autoSaveEntry.Exists())
-			autoSaveEntry.Remove();
-	}
+	// Remove autosave snapshot and journal on clean exit
+	fSessionJournal->Discard();
 
 	return true;
 }
@@ -704,7 +840,25 @@ BrowserApp::_RefsReceived(BMessage* message, int32* _pagesCreated,
 	}
 
 	BString url;
+	int32 urlCount = 0;
 	for (int32 i = 0; message->FindString("url", i, &url) == B_OK; i++) {
+		if (i > 0 && window != NULL && window->Lock()) {
+			// Add the remaining pages (e.g. all bookmarks of a folder) as
+			// one batch, only the last of them ends up selected. The others
+			// are lazy tabs, which do not load until they are selected.
+			window->BeginTabBatch();
+			type_code type;
+			message->GetInfo("url", &type, &urlCount);
+			for (; message->FindString("url", i, &url) == B_OK; i++) {
+				bool select = i == urlCount - 1;
+				window->CreateNewTab(url, select, NULL, !select);
+				pagesCreated++;
+			}
+			window->CommitTabBatch();
+			window->Activate();
+			window->Unlock();
+			break;
+		}
 		window = _CreateNewPage(url, window, fullscreen, pagesCreated == 0);
 		pagesCreated++;
 	}
@@ -849,28 +1003,87 @@ BrowserApp::_ShowWindow(const BMessage* message, BWindow* window)
 }
 
 
+BrowserWindow*
+BrowserApp::_RestoreWindow(const BMessage& archivedWindow, int32& pagesCreated)
+{
+	BRect frame = archivedWindow.FindRect("window frame");
+	uint32 workspaces = B_CURRENT_WORKSPACE;
+	archivedWindow.FindUInt32("window workspaces", 0, &workspaces);
+	BString url;
+	BMessage tabState;
+	bool hasTabState = archivedWindow.FindMessage("tab state", 0,
+		&tabState) == B_OK;
+	if (hasTabState) {
+		// The window starts out loading the tab that was selected, all
+		// others are added around it without being loaded
+		archivedWindow.FindMessage("tab state",
+			archivedWindow.GetInt32("selected tab", 0), &tabState);
+		url = tabState.GetString("url", "");
+	} else
+		archivedWindow.FindString("tab", 0, &url);
+	BrowserWindow* window = new BrowserWindow(frame, fSettings, url,
+		fContext, INTERFACE_ELEMENT_ALL, NULL, workspaces, false);
+
+	if (hasTabState) {
+		// Restores titles, icons, pin state and colors of all tabs,
+		// but leaves all but the selected one unloaded.
+		if (window->Lock()) {
+			window->RestoreSession(archivedWindow);
+			pagesCreated += window->GetTabManager()->CountTabs();
+			window->Unlock();
+		}
+		window->Show();
+		return window;
+	}
+
+	window->Show();
+	pagesCreated++;
+
+	for (int j = 1; archivedWindow.FindString("tab", j, &url)
+		== B_OK; j++) {
+		_CreateNewTab(window, url, false, true);
+		pagesCreated++;
+	}
+	return window;
+}
+
+
 void
-BrowserApp::_SaveSession()
+BrowserApp::_CheckMemoryPressure()
 {
-	BString sessionStorePath = kApplicationName;
-	sessionStorePath << "/Session.autosave";
-	SettingsMessage autoSaveSession(B_USER_SETTINGS_DIRECTORY,
-		sessionStorePath.String());
+	system_info info;
+	if (get_system_info(&info) != B_OK)
+		return;
 
-	for (int32 i = 0; BWindow* window = WindowAt(i); i++) {
-		BrowserWindow* webWindow = dynamic_cast<BrowserWindow*>(window);
-		if (!webWindow)
-			continue;
-		if (!webWindow->Lock())
-			continue;
+	uint64 total = (uint64)info.max_pages * B_PAGE_SIZE;
+	uint64 used = (uint64)info.used_pages * B_PAGE_SIZE;
 
-		BMessage windowArchive;
-		webWindow->Archive(&windowArchive, true);
-		autoSaveSession.AddMessage("window", &windowArchive);
+	TabDiscardPolicy policy;
+	policy.SetTargetPercent(fSettings->GetValue(kSettingsKeyTabDiscardTarget,
+		(int32)TabDiscardPolicy::kDefaultTargetPercent));
 
-		webWindow->Unlock();
+	// In low RAM mode background tabs are not kept loaded at all
+	bool lowRAMMode = fSettings->GetValue(kSettingsKeyLowRAMMode, false);
+	if (!lowRAMMode && !policy.IsUnderPressure(used, total))
+		return;
+
+	// One budget for all windows: the least recently used tabs are
+	// unloaded first, whichever window they are in.
+	std::vector<TabRegistry::Victim> victims = fTabRegistry->SelectVictims(
+		policy, used, lowRAMMode ? 0 : policy.TargetBytes(total));
+	for (size_t i = 0; i < victims.size(); i++) {
+		for (int32 j = 0; BWindow* window = WindowAt(j); j++) {
+			BrowserWindow* browserWindow = dynamic_cast<BrowserWindow*>(window);
+			if (browserWindow == NULL
+				|| browserWindow->WindowId() != victims[i].windowId) {
+				continue;
+			}
+			BMessage discard(DISCARD_TAB);
+			discard.AddUInt32("tab", victims[i].tabId);
+			browserWindow->PostMessage(&discard);
+			break;
+		}
 	}
-	autoSaveSession.Save();
 }
 
 
@@ -32,14 +32,20 @@
 #include <Application.h>
 #include <Catalog.h>
 #include <NetworkCookieJar.h>
+#include <Path.h>
 #include <Rect.h>
 #include <UrlContext.h>
 
 
+class BookmarkIndex;
+class BookmarkMonitor;
 class ConsoleWindow;
 class CookieWindow;
 class DownloadWindow;
 class BrowserWindow;
+class ClosedTabStore;
+class SessionJournal;
+class TabRegistry;
 class SettingsMessage;
 class SettingsWindow;
 
@@ -75,6 +81,9 @@ private:
 									const BString& url, bool select, bool lazy = false);
 			void				_ShowWindow(const BMessage* message,
 									BWindow* window);
+			void				_CheckMemoryPressure();
+			BrowserWindow*		_RestoreWindow(const BMessage& archive,
+									int32& pagesCreated);
 
 private:
 			int					fWindowCount;
@@ -85,6 +94,11 @@ private:
 			SettingsMessage*	fSettings;
 			SettingsMessage*	fCookies;
 			SettingsMessage*	fSession;
+			SessionJournal*		fSessionJournal;
+			ClosedTabStore*		fClosedTabStore;
+			BookmarkIndex*		fBookmarkIndex;
+			BPath				fBookmarkIndexPath;
+			BookmarkMonitor*	fBookmarkMonitor;
 			BReference<BPrivate::Network::BUrlContext>	fContext;
 
 			DownloadWindow*		fDownloadWindow;
@@ -93,8 +107,9 @@ private:
 			CookieWindow*		fCookieWindow;
 
 			BMessageRunner*		fAutoSaver;
+			BMessageRunner*		fMemoryMonitor;
+			TabRegistry*		fTabRegistry;
 			bool				fForceQuit;
-			void				_SaveSession();
 };
 
 
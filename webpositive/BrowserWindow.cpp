@@ -90,22 +90,28 @@
 #include "BaseURL.h"
 #include "BitmapButton.h"
 #include "BookmarkBar.h"
+#include "BookmarkBulkWriter.h"
 #include "BrowserApp.h"
 #include "BrowserWebView.h"
 #include "BrowsingHistory.h"
+#include "ClosedTabStore.h"
 #include "CredentialsStorage.h"
 #include "IconButton.h"
+#include "IconCache.h"
+#include "LazyTabView.h"
 #include "NavMenu.h"
 #include "PageUserData.h"
 #include "PermissionsWindow.h"
 #include "NetworkWindow.h"
 #include "support/SafeStrerror.h"
+#include "SessionJournal.h"
 #include "SettingsKeys.h"
 #include "SettingsMessage.h"
 #include "SitePermissionsManager.h"
 #include "Sync.h"
 #include "TabManager.h"
 #include "TabSearchWindow.h"
+#include "ThumbnailScaler.h"
 #include "URLInputGroup.h"
 #include "WebPage.h"
 #include "WebSettings.h"
@@ -198,6 +204,22 @@ static const int32 kModifiers = B_SHIFT_KEY | B_COMMAND_KEY
 
 static const char* kBookmarkBarSubdir = "Bookmark bar";
 
+static const int32 kPreviewWidth = 200;
+static const int32 kPreviewHeight = 150;
+static const int32 kSnapshotDivisor = 2;
+	// discarded tabs are shown at half resolution while they reload
+static const bigtime_t kSnapshotOverlayTimeout = 15000000;
+	// after which a reloading tab shows the page, whether loaded or not
+static const int32 kMaxConcurrentWarmUps = 2;
+	// tabs loading ahead of being selected
+static const bigtime_t kWarmUpTimeout = 20000000;
+	// after which such a tab gives up its slot
+static const bigtime_t kWindowJournalDelay = 500000;
+	// a moved or resized window is journaled once it stays put this long
+
+static int32 sNextTabId = 1;
+static int32 sNextWindowId = 1;
+
 
 struct SyncParams {
 	BPath path;
@@ -219,8 +241,23 @@ struct FaviconLoadParams {
 };
 
 
+struct FaviconBatchLoadParams {
+	std::vector<std::pair<BPath, uint32> > icons;
+	BMessenger target;
+};
+
+
+struct PreviewScaleParams {
+	BBitmap* capture;
+	BMessenger target;
+	uint32 tabId;
+	bool snapshot;
+};
+
+
 struct PathActionParams {
 	BPath path;
+	BMessenger target;
 };
 
 
@@ -272,7 +309,8 @@ static status_t
 _ImportBookmarksThread(void* data)
 {
 	PathActionParams* params = static_cast<PathActionParams*>(data);
-	status_t status = BookmarkManager::ImportBookmarks(params->path);
+	status_t status = BookmarkManager::ImportBookmarks(params->path,
+		params->target, true);
 
 	if (status != B_OK) {
 		BString errorMsg(B_TRANSLATE("Failed to import bookmarks"));
@@ -306,6 +344,33 @@ _ExportCookiesThread(void* data)
 }
 
 
+static status_t
+faviconPathForURL(const BString& url, BPath& path)
+{
+	if (url.Length() == 0)
+		return B_BAD_VALUE;
+
+	if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) != B_OK)
+		return B_ERROR;
+
+	path.Append(kApplicationName);
+	path.Append("Favicons");
+
+	BUrl parsedUrl(url.String(), true);
+	if (!parsedUrl.IsValid() || parsedUrl.Host().Length() == 0)
+		return B_BAD_VALUE;
+
+	BString filename(parsedUrl.Host());
+	// Sanitize filename
+	filename.ToLower();
+	filename.ReplaceAll('/', '_');
+	filename.ReplaceAll(':', '_');
+
+	path.Append(filename.String());
+	return B_OK;
+}
+
+
 static status_t
 _SaveFaviconThread(void* data)
 {
@@ -358,12 +423,10 @@ _SaveFaviconThread(void* data)
 }
 
 
-static status_t
-_LoadFaviconThread(void* data)
+static void
+_ReadFaviconFile(const BPath& path, uint32 tabId, const BMessenger& target)
 {
-	FaviconLoadParams* params = static_cast<FaviconLoadParams*>(data);
-
-	BFile file(params->path.Path(), B_READ_ONLY);
+	BFile file(path.Path(), B_READ_ONLY);
 	if (file.InitCheck() == B_OK) {
 		int32 width, height;
 		if (file.Read(&width, sizeof(width)) == sizeof(width) &&
@@ -425,8 +488,8 @@ _LoadFaviconThread(void* data)
 						if (success) {
 							BMessage msg(FAVICON_LOADED);
 							if (icon->Archive(&msg) == B_OK) {
-								msg.AddUInt32("tabId", params->tabId);
-								params->target.SendMessage(&msg);
+								msg.AddUInt32("tabId", tabId);
+								target.SendMessage(&msg);
 							}
 						}
 						delete icon;
@@ -438,13 +501,113 @@ _LoadFaviconThread(void* data)
 					// We can't safely read legacy files because we don't know the original padding.
 					// Deleting the file forces a fresh fetch next time.
 					file.Unset();
-					BEntry entry(params->path.Path());
+					BEntry entry(path.Path());
 					entry.Remove();
 				}
 			}
 		}
 	}
+}
 
+
+static status_t
+_LoadFaviconThread(void* data)
+{
+	FaviconLoadParams* params = static_cast<FaviconLoadParams*>(data);
+	_ReadFaviconFile(params->path, params->tabId, params->target);
+	delete params;
+	return B_OK;
+}
+
+
+static status_t
+_LoadFaviconsThread(void* data)
+{
+	FaviconBatchLoadParams* params = static_cast<FaviconBatchLoadParams*>(data);
+	for (size_t i = 0; i < params->icons.size(); i++) {
+		_ReadFaviconFile(params->icons[i].first, params->icons[i].second,
+			params->target);
+	}
+	delete params;
+	return B_OK;
+}
+
+
+static void
+_LoadFavicons(FaviconBatchLoadParams* params)
+{
+	if (params == NULL)
+		return;
+	if (params->icons.empty()) {
+		delete params;
+		return;
+	}
+
+	thread_id thread = spawn_thread(_LoadFaviconsThread, "Load Favicons",
+		B_LOW_PRIORITY, params);
+	if (thread >= 0) {
+		if (resume_thread(thread) != B_OK) {
+			kill_thread(thread);
+			delete params;
+		}
+	} else
+		delete params;
+}
+
+
+static BBitmap*
+_ScaleCapture(const BBitmap* capture, int32 width, int32 height)
+{
+	// Use B_BITMAP_NO_SERVER_LINK for background thread safety
+	BBitmap* scaled = new(std::nothrow) BBitmap(
+		BRect(0, 0, width - 1, height - 1), B_BITMAP_NO_SERVER_LINK, B_RGB32);
+	if (scaled == NULL || scaled->InitCheck() != B_OK
+		|| ThumbnailScaler::Scale(static_cast<const uint8*>(capture->Bits()),
+			capture->Bounds().IntegerWidth() + 1,
+			capture->Bounds().IntegerHeight() + 1, capture->BytesPerRow(),
+			static_cast<uint8*>(scaled->Bits()), width, height,
+			scaled->BytesPerRow()) != B_OK) {
+		delete scaled;
+		return NULL;
+	}
+	return scaled;
+}
+
+
+static status_t
+_ScalePreviewThread(void* data)
+{
+	PreviewScaleParams* params = static_cast<PreviewScaleParams*>(data);
+	BBitmap* capture = params->capture;
+
+	BBitmap* thumbnail = _ScaleCapture(capture, kPreviewWidth, kPreviewHeight);
+	if (thumbnail != NULL) {
+		BMessage msg(PREVIEW_READY);
+		if (thumbnail->Archive(&msg) == B_OK) {
+			msg.AddUInt32("tabId", params->tabId);
+
+			// Also keep a larger snapshot, to stand in for the page should
+			// the tab get discarded.
+			if (params->snapshot) {
+				BBitmap* snapshot = _ScaleCapture(capture,
+					std::max((int32)1, (capture->Bounds().IntegerWidth() + 1)
+						/ kSnapshotDivisor),
+					std::max((int32)1, (capture->Bounds().IntegerHeight() + 1)
+						/ kSnapshotDivisor));
+				BMessage snapshotArchive;
+				if (snapshot != NULL
+					&& snapshot->Archive(&snapshotArchive) == B_OK) {
+					msg.AddMessage("snapshot", &snapshotArchive);
+				}
+				delete snapshot;
+			}
+
+			params->target.SendMessage(&msg);
+		}
+	}
+
+	delete thumbnail;
+	delete capture;
 	delete params;
 	return B_OK;
 }
@@ -637,12 +800,15 @@ BrowserWindow::BrowserWindow(BRect frame, SettingsMessage* appSettings, const BS
 	fLowRAMMode(false),
 	fTabSearchWindow(NULL),
 	fLastHistoryGeneration(0),
+	fLastClosedTabsGeneration(0),
 	fPermissionsWindow(NULL),
 	fNetworkWindow(NULL),
 	fIsPrivate(privateWindow),
+	fWindowId((uint32)atomic_add(&sNextWindowId, 1)),
+	fTabBatchDepth(0),
 	fButtonResetRunner(NULL),
-	fExpectingDomInspection(false),
-	fNextTabId(1)
+	fWindowJournalRunner(NULL),
+	fExpectingDomInspection(false)
 {
 	fFormSafetyHelper.reset(new FormSafetyHelper(this));
 
@@ -1060,6 +1226,7 @@ BrowserWindow::BrowserWindow(BRect frame, SettingsMessage* appSettings, const BS
 	if (fToolbarBottom)
 		_UpdateToolbarPlacement();
 
+	_JournalWindow(SessionJournal::kWindowOpened);
 	CreateNewTab(url, true, webView);
 	_ShowInterface(true);
 	_SetAutoHideInterfaceInFullscreen(fAppSettings->GetValue(
@@ -1125,9 +1292,6 @@ BrowserWindow::BrowserWindow(BRect frame, SettingsMessage* appSettings, const BS
 	}
 	unmodified.MakeEmpty();
 
-	BMessage memMsg(CHECK_MEMORY_PRESSURE);
-	fMemoryPressureRunner.reset(new BMessageRunner(BMessenger(this), &memMsg, 30000000)); // 30 seconds
-
 	be_app->PostMessage(WINDOW_OPENED);
 }
 
@@ -1137,7 +1301,7 @@ BrowserWindow::~BrowserWindow()
 	fAppSettings->RemoveListener(BMessenger(this));
 	fPulseRunner.reset();
 	fButtonResetRunner.reset();
-	fMemoryPressureRunner.reset();
+	fWindowJournalRunner.reset();
 	fSavePanel.reset();
 	fFormSafetyHelper.reset();
 	if (fPermissionsWindow) {
@@ -1157,7 +1321,6 @@ BrowserWindow::~BrowserWindow()
 
 	if (fTabSearchWindow) {
 		if (fTabSearchWindow->Lock()) {
-			fTabSearchWindow->SetTabManager(NULL);
 			fTabSearchWindow->Quit();
 			fTabSearchWindow = NULL;
 		}
@@ -1395,6 +1558,7 @@ BrowserWindow::MessageReceived(BMessage* message)
 				PathActionParams* params = new(std::nothrow) PathActionParams;
 				if (params != NULL) {
 					params->path = path;
+					params->target = BMessenger(this);
 					thread_id thread = spawn_thread(_ImportBookmarksThread,
 						"Import Bookmarks", B_NORMAL_PRIORITY, params);
 					if (thread >= 0) {
@@ -1806,8 +1970,11 @@ BrowserWindow::MessageReceived(BMessage* message)
 		case CLEAR_HISTORY_CONFIRMED:
 		{
 			int32 which;
-			if (message->FindInt32("which", &which) == B_OK && which == 0)
+			if (message->FindInt32("which", &which) == B_OK && which == 0) {
 				BrowsingHistory::DefaultInstance()->Clear();
+				if (ClosedTabStore::Default() != NULL)
+					ClosedTabStore::Default()->Clear();
+			}
 			break;
 		}
 
@@ -1833,19 +2000,7 @@ BrowserWindow::MessageReceived(BMessage* message)
 				if (message->FindString("url", &url) == B_OK
 					&& message->FindUInt32("tabId", &tabId) == B_OK) {
 
-					// Find view by ID
-					BWebView* view = NULL;
-					for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
-						BWebView* tab = dynamic_cast<BWebView*>(fTabManager->ViewForTab(i));
-						if (tab) {
-							PageUserData* userData = static_cast<PageUserData*>(tab->GetUserData());
-							if (userData && userData->Id() == tabId) {
-								view = tab;
-								break;
-							}
-						}
-					}
-
+					BWebView* view = _WebViewForTabId(tabId);
 					if (view) {
 						BString httpUrl = url;
 						if (httpUrl.StartsWith("https://")) {
@@ -1876,14 +2031,65 @@ BrowserWindow::MessageReceived(BMessage* message)
 		case SELECT_TAB_BY_VIEW:
 		{
 			void* viewPtr = NULL;
+			uint32 tabId;
 			if (message->FindPointer("view", &viewPtr) == B_OK) {
 				BView* view = static_cast<BView*>(viewPtr);
 				if (fTabManager->HasView(view))
 					fTabManager->SelectTab(view);
+			} else if (message->FindUInt32("tab id", &tabId) == B_OK) {
+				// From the tab search, which may belong to another window
+				BView* view = _ViewForTabId(tabId);
+				if (view != NULL) {
+					fTabManager->SelectTab(view);
+					Activate();
+				}
 			}
 			break;
 		}
 
+		case COLLECT_TAB_SEARCH_ENTRIES:
+		{
+			BMessenger replyTo;
+			if (message->FindMessenger("reply to", &replyTo) != B_OK
+				|| message->GetBool("private", false) != fIsPrivate) {
+				break;
+			}
+
+			BMessage reply(TAB_SEARCH_ENTRIES);
+			reply.AddUInt32("window", fWindowId);
+			reply.AddMessenger("target", BMessenger(this));
+			for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
+				PageUserData* userData
+					= PageUserData::ForTabView(fTabManager->ViewForTab(i));
+				if (userData == NULL)
+					continue;
+				BString url;
+				BString title;
+				GetTabPage(i, url, title);
+				reply.AddUInt32("tab", userData->Id());
+				reply.AddString("title", title);
+				reply.AddString("url", url);
+			}
+			replyTo.SendMessage(&reply);
+			break;
+		}
+
+		case BookmarkBulkWriter::kMsgProgress:
+		{
+			if (fStatusText == NULL)
+				break;
+
+			BString text(message->GetBool("finished", false)
+				? B_TRANSLATE("Imported %count% bookmarks.")
+				: B_TRANSLATE("Importing bookmarks: %count% created"
+					B_UTF8_ELLIPSIS));
+			BString count;
+			count << message->GetInt32("created", 0);
+			text.ReplaceFirst("%count%", count.String());
+			fStatusText->SetText(text.String());
+			break;
+		}
+
 		case FAVICON_LOADED:
 		{
 			BBitmap* icon = new(std::nothrow) BBitmap(message);
@@ -1894,19 +2100,7 @@ BrowserWindow::MessageReceived(BMessage* message)
 
 			uint32 tabId;
 			if (message->FindUInt32("tabId", &tabId) == B_OK) {
-				// Find view by ID
-				BWebView* view = NULL;
-				for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
-					BWebView* tab = dynamic_cast<BWebView*>(fTabManager->ViewForTab(i));
-					if (tab) {
-						PageUserData* userData = static_cast<PageUserData*>(tab->GetUserData());
-						if (userData && userData->Id() == tabId) {
-							view = tab;
-							break;
-						}
-					}
-				}
-
+				BView* view = _ViewForTabId(tabId);
 				if (view) {
 					_SetPageIcon(view, icon, false);
 				}
@@ -1915,6 +2109,44 @@ BrowserWindow::MessageReceived(BMessage* message)
 			break;
 		}
 
+		case PREVIEW_READY:
+		{
+			uint32 tabId;
+			if (message->FindUInt32("tabId", &tabId) != B_OK)
+				break;
+
+			BWebView* view = _WebViewForTabId(tabId);
+			if (view == NULL)
+				break;
+
+			BBitmap* preview = new(std::nothrow) BBitmap(message);
+			if (preview == NULL || preview->InitCheck() != B_OK) {
+				delete preview;
+				break;
+			}
+			PageUserData* userData = _GetOrCreateUserData(view);
+			userData->SetPreview(preview);
+
+			// Without a new snapshot, an older one is dropped as well, the
+			// tab is no longer one that may get discarded
+			BBitmap* snapshot = NULL;
+			BMessage snapshotArchive;
+			if (message->FindMessage("snapshot", &snapshotArchive) == B_OK) {
+				snapshot = new(std::nothrow) BBitmap(&snapshotArchive);
+				if (snapshot != NULL && snapshot->InitCheck() != B_OK) {
+					delete snapshot;
+					snapshot = NULL;
+				}
+			}
+			userData->SetSnapshot(snapshot);
+			break;
+		}
+
+		case REMOVE_SNAPSHOT_OVERLAY:
+			_RemoveSnapshotOverlay(
+				_WebViewForTabId(message->GetUInt32("tabId", 0)));
+			break;
+
 		case TOGGLE_FULLSCREEN:
 			ToggleFullscreen();
 			break;
@@ -1933,7 +2165,8 @@ BrowserWindow::MessageReceived(BMessage* message)
 			if (fTabSearchWindow) {
 				fTabSearchWindow->Activate();
 			} else {
-				fTabSearchWindow = new TabSearchWindow(fTabManager);
+				fTabSearchWindow = new TabSearchWindow(BMessenger(this),
+					fIsPrivate);
 				fTabSearchWindow->Show();
 			}
 			break;
@@ -1952,10 +2185,10 @@ BrowserWindow::MessageReceived(BMessage* message)
 		{
 			rgb_color color;
 			if (message->FindColor("color", &color) == B_OK) {
-				BWebView* webView = NULL;
+				BView* webView = NULL;
 				int32 tabIndex = -1;
 				if (message->FindInt32("tab index", &tabIndex) == B_OK)
-					webView = dynamic_cast<BWebView*>(fTabManager->ViewForTab(tabIndex));
+					webView = fTabManager->ViewForTab(tabIndex);
 				else
 					webView = CurrentWebView();
 
@@ -1965,6 +2198,8 @@ BrowserWindow::MessageReceived(BMessage* message)
 						TabView* tab = fTabManager->GetTabContainerView()->TabAt(tabIndex);
 						if (tab) {
 							tab->SetGroupColor(color);
+							_JournalTab(SessionJournal::kTabNavigated,
+								webView);
 						}
 					}
 				}
@@ -2219,11 +2454,12 @@ BrowserWindow::MessageReceived(BMessage* message)
 			if (message->FindInt32("tab index", &index) == B_OK) {
 				// Close tabs from end to start to avoid index shifting problems
 				// Skip the target tab
+				BeginTabBatch();
 				for (int32 i = fTabManager->CountTabs() - 1; i >= 0; i--) {
 					if (i != index)
 						_ShutdownTab(i);
 				}
-				_UpdateTabGroupVisibility();
+				CommitTabBatch();
 			}
 			break;
 		}
@@ -2233,10 +2469,11 @@ BrowserWindow::MessageReceived(BMessage* message)
 			int32 index;
 			if (message->FindInt32("tab index", &index) == B_OK) {
 				// Close tabs from end down to index + 1
+				BeginTabBatch();
 				for (int32 i = fTabManager->CountTabs() - 1; i > index; i--) {
 					_ShutdownTab(i);
 				}
-				_UpdateTabGroupVisibility();
+				CommitTabBatch();
 			}
 			break;
 		}
@@ -2259,6 +2496,27 @@ BrowserWindow::MessageReceived(BMessage* message)
 			if (index >= fTabManager->CountTabs())
 				index = 0;
 			fTabManager->SelectTab(index);
+
+			// Cycling on will most likely hit the next tab
+			if (fTabManager->CountTabs() > 2)
+				_WarmUpTab((index + 1) % fTabManager->CountTabs());
+			break;
+		}
+
+		case WARM_UP_TAB:
+			_WarmUpTab(message->GetInt32("tab index", -1));
+			break;
+
+		case WARM_UP_TIMEOUT:
+		{
+			// The tab is still loading ahead of being selected. Unless it
+			// has been selected meanwhile, the load is stopped as well.
+			uint32 tabId = message->GetUInt32("tabId", 0);
+			if (fWarmingTabs.erase(tabId) == 0)
+				break;
+			BWebView* view = _WebViewForTabId(tabId);
+			if (view != NULL && view != CurrentWebView())
+				view->StopLoading();
 			break;
 		}
 
@@ -2268,15 +2526,17 @@ BrowserWindow::MessageReceived(BMessage* message)
 
 		case DUPLICATE_TAB:
 		{
-			BWebView* webView = NULL;
+			BView* view = NULL;
 			int32 tabIndex = -1;
 			if (message->FindInt32("tab index", &tabIndex) == B_OK)
-				webView = dynamic_cast<BWebView*>(fTabManager->ViewForTab(tabIndex));
+				view = fTabManager->ViewForTab(tabIndex);
 			else
-				webView = CurrentWebView();
+				view = CurrentWebView();
 
-			if (webView) {
-				BString url = webView->MainFrameURL();
+			if (view) {
+				BMessage state;
+				_ArchiveTabState(fTabManager->TabForView(view), state);
+				BString url = state.GetString("url", "");
 				int32 targetIndex = (tabIndex >= 0) ? tabIndex + 1 : fTabManager->SelectedTabIndex() + 1;
 				// Create new tab at specific index
 				CreateNewTab(url, true, NULL, false, targetIndex);
@@ -2294,16 +2554,14 @@ BrowserWindow::MessageReceived(BMessage* message)
 			break;
 		}
 
-		case REOPEN_CLOSED_TAB_WITH_INDEX:
+		case REOPEN_CLOSED_TAB_WITH_ID:
 		{
-			int32 index;
-			if (message->FindInt32("index", &index) == B_OK) {
-				if (index >= 0 && index < (int32)fClosedTabs.size()) {
-					ClosedTabInfo info = fClosedTabs[index];
-					fClosedTabs.erase(fClosedTabs.begin() + index);
-					_UpdateRecentlyClosedMenu();
-					CreateNewTab(info.url, true);
-				}
+			ClosedTabStore* store = ClosedTabStore::Default();
+			ClosedTabStore::Entry entry;
+			uint32 id;
+			if (store != NULL && message->FindUInt32("id", &id) == B_OK
+				&& store->Take(id, entry)) {
+				_ReopenTab(entry.archive);
 			}
 			break;
 		}
@@ -2311,10 +2569,10 @@ BrowserWindow::MessageReceived(BMessage* message)
 		case PIN_TAB:
 		case UNPIN_TAB:
 		{
-			BWebView* webView = NULL;
+			BView* webView = NULL;
 			int32 tabIndex = -1;
 			if (message->FindInt32("tab index", &tabIndex) == B_OK)
-				webView = dynamic_cast<BWebView*>(fTabManager->ViewForTab(tabIndex));
+				webView = fTabManager->ViewForTab(tabIndex);
 			else
 				webView = CurrentWebView();
 
@@ -2327,6 +2585,8 @@ BrowserWindow::MessageReceived(BMessage* message)
 						if (tab->IsPinned() == pinned) break;
 
 						tab->SetPinned(pinned);
+						_JournalTab(SessionJournal::kTabNavigated, webView);
+						_ReportTab(webView);
 
 						int32 pinnedCount = 0;
 						for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
@@ -2336,8 +2596,10 @@ BrowserWindow::MessageReceived(BMessage* message)
 							}
 						}
 
-						if (tabIndex != pinnedCount)
+						if (tabIndex != pinnedCount) {
 							fTabManager->MoveTab(tabIndex, pinnedCount);
+							_JournalTab(SessionJournal::kTabMoved, webView);
+						}
 					}
 				}
 			}
@@ -2457,7 +2719,11 @@ BrowserWindow::MessageReceived(BMessage* message)
 					BWebPage::SetCacheModel(B_WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
 				else
 					BWebPage::SetCacheModel(B_WEBKIT_CACHE_MODEL_WEB_BROWSER);
-				_CheckMemoryPressure();
+				PreviewCache::Snapshots().SetBudget(fLowRAMMode
+					? PreviewCache::kLowRAMSnapshotBudget
+					: PreviewCache::kDefaultSnapshotBudget);
+				// Let the application re-evaluate which tabs to keep
+				be_app->PostMessage(CHECK_MEMORY_PRESSURE);
 			} else if (name == kSettingsKeyLoadImages
 				&& message->FindBool("value", &flag) == B_OK) {
 				// flag is "load images" (true = load, false = don't load)
@@ -2478,6 +2744,35 @@ BrowserWindow::MessageReceived(BMessage* message)
 					fFormSafetyHelper->ConsoleMessage(text);
 					break;
 				}
+				if (text.StartsWith("WebPositive:TabState:")) {
+					// Format: WebPositive:TabState:tabId:x:y:dirty:media:nodes
+					uint32 tabId;
+					float x;
+					float y;
+					int dirty;
+					int media;
+					int32 nodes;
+					if (sscanf(text.String() + strlen("WebPositive:TabState:"),
+							"%" B_SCNu32 ":%f:%f:%d:%d:%" B_SCNd32, &tabId, &x,
+							&y, &dirty, &media, &nodes) == 6) {
+						// The text comes from the page, so it may only speak
+						// for the tab it is shown in
+						BWebView* view = _WebViewForTabId(tabId);
+						void* sender = NULL;
+						if (view != NULL
+							&& message->FindPointer("view", &sender) == B_OK
+							&& sender == view) {
+							PageUserData* userData = _GetOrCreateUserData(view);
+							userData->SetScrollPosition(BPoint(x, y));
+							userData->SetHasDirtyForm(dirty != 0);
+							userData->SetIsPlayingMedia(media != 0);
+							userData->SetDomNodeCount(nodes);
+							_JournalTab(SessionJournal::kTabNavigated, view);
+							_ReportTab(view);
+						}
+					}
+					break;
+				}
 				if (fExpectingDomInspection) {
 					if (text.StartsWith("INSPECT_DOM_START:")) {
 						fInspectDomBuffer = "";
@@ -2537,8 +2832,24 @@ BrowserWindow::MessageReceived(BMessage* message)
 			fFormSafetyHelper->MessageReceived(message);
 			break;
 
-		case CHECK_MEMORY_PRESSURE:
-			_CheckMemoryPressure();
+		case DISCARD_TAB:
+		{
+			// Sent by the application when memory runs low and this is one
+			// of the least recently used tabs of all windows. The tab may
+			// have changed since it was last reported, so check again.
+			uint32 tabId = message->GetUInt32("tab", 0);
+			TabDiscardPolicy::TabInfo tab;
+			if (!_GetTabInfo(_ViewForTabId(tabId), tab))
+				break;
+			if (TabDiscardPolicy().IsDiscardable(tab))
+				_DiscardTab(_WebViewForTabId(tabId));
+			_ReportTab(_ViewForTabId(tabId));
+			break;
+		}
+
+		case JOURNAL_WINDOW_CHANGED:
+			fWindowJournalRunner.reset();
+			_JournalWindow(SessionJournal::kWindowChanged);
 			break;
 
 		case RESET_BUTTON_STATE:
@@ -2581,20 +2892,339 @@ BrowserWindow::Archive(BMessage* archive, bool deep) const
 	if (status == B_OK)
 		status = archive->AddUInt32("window workspaces", Workspaces());
 
+	int32 archivedTabs = 0;
+	int32 selectedTab = 0;
 	for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
-		BWebView* view = dynamic_cast<BWebView*>(fTabManager->ViewForTab(i));
-		if (view == NULL) {
+		BView* view = fTabManager->ViewForTab(i);
+		if (PageUserData::ForTabView(view) == NULL
+			&& dynamic_cast<BWebView*>(view) == NULL) {
 			continue;
 		}
 
+		if (view == CurrentWebView())
+			selectedTab = archivedTabs;
+		archivedTabs++;
+
+		BMessage state;
+		_ArchiveTabState(i, state);
+
+		// Plain URLs for older versions reading this session
+		if (status == B_OK)
+			status = archive->AddString("tab", state.GetString("url", ""));
 		if (status == B_OK)
-			status = archive->AddString("tab", view->MainFrameURL());
+			status = archive->AddMessage("tab state", &state);
 	}
 
+	if (status == B_OK)
+		status = archive->AddInt32("selected tab", selectedTab);
+
 	return status;
 }
 
 
+void
+BrowserWindow::RestoreSession(const BMessage& archive)
+{
+	// The window was created with the selected tab already loading, apply
+	// its remaining state and add all other tabs around it without loading
+	// them.
+	int32 selectedTab = archive.GetInt32("selected tab", 0);
+	BMessage state;
+	if (archive.FindMessage("tab state", selectedTab, &state) != B_OK)
+		selectedTab = 0;
+
+	FaviconBatchLoadParams* icons = new(std::nothrow) FaviconBatchLoadParams;
+	int32 restoredBefore = 0;
+	for (int32 i = 0; archive.FindMessage("tab state", i, &state) == B_OK;
+			i++) {
+		if (i == selectedTab)
+			continue;
+
+		// Tabs in front of the loaded one are inserted before it
+		BView* view = _RestoreTab(state,
+			i < selectedTab ? restoredBefore : -1);
+		if (view != NULL && i < selectedTab)
+			restoredBefore++;
+		if (view == NULL || icons == NULL)
+			continue;
+
+		const char* faviconPath;
+		if (state.FindString("favicon", &faviconPath) == B_OK) {
+			try {
+				icons->icons.push_back(std::make_pair(BPath(faviconPath),
+					_GetOrCreateUserData(view)->Id()));
+			} catch (...) {
+			}
+		}
+	}
+
+	// Read all favicons in one go instead of spawning a thread per tab
+	if (icons != NULL)
+		icons->target = BMessenger(this);
+	_LoadFavicons(icons);
+
+	if (archive.FindMessage("tab state", selectedTab, &state) == B_OK) {
+		BWebView* view = dynamic_cast<BWebView*>(
+			fTabManager->ViewForTab(restoredBefore));
+		if (view != NULL) {
+			_ApplyTabState(restoredBefore, state);
+			PageUserData* userData = _GetOrCreateUserData(view);
+			userData->SetScrollPosition(state.GetPoint("scroll",
+				B_ORIGIN));
+			userData->SetRestoreScroll(true);
+			_JournalTab(SessionJournal::kTabNavigated, view);
+			fTabManager->SelectTab(restoredBefore);
+		}
+	}
+
+	_UpdateTabGroupVisibility();
+}
+
+
+BView*
+BrowserWindow::_RestoreTab(const BMessage& state, int32 index)
+{
+	BString url = state.GetString("url", "");
+	if (url.Length() == 0)
+		return NULL;
+
+	// The tab shows its label (and icon, once the favicon is read) right away,
+	// but the page is only loaded when the tab is first selected.
+	if (index < 0 || index > fTabManager->CountTabs())
+		index = fTabManager->CountTabs();
+	BView* view = _AddLazyTab(url, state.GetString("title", ""), index);
+	if (view == NULL)
+		return NULL;
+
+	PageUserData* userData = _GetOrCreateUserData(view);
+	userData->SetScrollPosition(state.GetPoint("scroll", B_ORIGIN));
+	userData->SetRestoreScroll(true);
+
+	_ApplyTabState(index, state);
+	_JournalTab(SessionJournal::kTabOpened, view);
+	return view;
+}
+
+
+BView*
+BrowserWindow::_AddLazyTab(const BString& url, const BString& title,
+	int32 index)
+{
+	PageUserData* userData = new(std::nothrow) PageUserData(NULL);
+	if (userData == NULL)
+		return NULL;
+	userData->SetIsLazy(true);
+	userData->SetPendingURL(url);
+	userData->SetPendingTitle(title);
+
+	LazyTabView* view = new(std::nothrow) LazyTabView(userData);
+	if (view == NULL) {
+		delete userData;
+		return NULL;
+	}
+
+	if (index < 0)
+		index = fTabManager->CountTabs();
+	fTabManager->AddTab(view, B_TRANSLATE("New tab"), index);
+	if (fTabManager->ViewForTab(index) != view) {
+		// AddTab() already deleted the view
+		return NULL;
+	}
+
+	_GetOrCreateUserData(view);
+	fTabManager->SetTabLabel(index, title.Length() > 0 ? title : url);
+	return view;
+}
+
+
+BWebView*
+BrowserWindow::_MaterializeTab(int32 index)
+{
+	BView* view = fTabManager->ViewForTab(index);
+	LazyTabView* placeholder = dynamic_cast<LazyTabView*>(view);
+	if (placeholder == NULL)
+		return dynamic_cast<BWebView*>(view);
+
+	// Only now the tab gets its WebKit page. The user data moves over, so
+	// SetCurrentWebView() finds the tab still lazy and loads its URL.
+	BrowserWebView* webView = new BrowserWebView("web view", fContext);
+	webView->SetZoomTextOnly(fZoomTextOnly);
+	if (fTabManager->ReplaceView(index, webView) == NULL) {
+		webView->Shutdown();
+		delete webView;
+		return NULL;
+	}
+
+	placeholder->HandOver(webView);
+	PageUserData* userData = static_cast<PageUserData*>(
+		webView->GetUserData());
+
+	PreviewCache::PreviewRef snapshot;
+	if (userData != NULL && userData->IsDiscarded())
+		snapshot = userData->Snapshot();
+	if (snapshot == NULL) {
+		delete placeholder;
+		return webView;
+	}
+
+	// Keep showing the page as it was last seen on top of the web view,
+	// until it has been loaded again. The web view gets the frame the
+	// placeholder had, so the overlay follows it through later resizes.
+	BRect frame = placeholder->Frame();
+	webView->MoveTo(frame.LeftTop());
+	webView->ResizeTo(frame.Width(), frame.Height());
+	placeholder->SetSnapshot(snapshot);
+	placeholder->MoveTo(B_ORIGIN);
+	placeholder->SetResizingMode(B_FOLLOW_ALL);
+	webView->AddChild(placeholder);
+
+	// Should the page neither finish nor fail loading, it is shown anyway
+	BMessage timeout(REMOVE_SNAPSHOT_OVERLAY);
+	timeout.AddUInt32("tabId", userData->Id());
+	BMessageRunner::StartSending(BMessenger(this), &timeout,
+		kSnapshotOverlayTimeout, 1);
+	return webView;
+}
+
+
+void
+BrowserWindow::_ApplyTabState(int32 tabIndex, const BMessage& state)
+{
+	const char* title = state.GetString("title", "");
+	if (title[0] != '\0')
+		fTabManager->SetTabLabel(tabIndex, title);
+	else
+		fTabManager->SetTabLabel(tabIndex, state.GetString("url", ""));
+
+	TabView* tab = fTabManager->GetTabContainerView()->TabAt(tabIndex);
+	if (tab == NULL)
+		return;
+
+	tab->SetPinned(state.GetBool("pinned", false));
+	rgb_color color;
+	if (state.FindColor("color", &color) == B_OK)
+		tab->SetGroupColor(color);
+}
+
+
+void
+BrowserWindow::GetTabPage(int32 tabIndex, BString& url, BString& title) const
+{
+	url.Truncate(0);
+	title.Truncate(0);
+
+	BView* view = fTabManager->ViewForTab(tabIndex);
+	if (view == NULL)
+		return;
+
+	// Tabs which were never loaded (restored lazily, or discarded) only
+	// know their URL and title from their user data.
+	PageUserData* userData = PageUserData::ForTabView(view);
+	if (userData != NULL && (userData->IsLazy() || userData->IsDiscarded())) {
+		url = userData->PendingURL();
+		title = userData->PendingTitle();
+		if (title.Length() > 0)
+			return;
+	}
+
+	BWebView* webView = dynamic_cast<BWebView*>(view);
+	if (webView != NULL) {
+		if (url.Length() == 0)
+			url = webView->MainFrameURL();
+		title = webView->MainFrameTitle();
+	}
+}
+
+
+void
+BrowserWindow::_ArchiveTabState(int32 tabIndex, BMessage& state) const
+{
+	BView* view = fTabManager->ViewForTab(tabIndex);
+	if (view == NULL)
+		return;
+
+	PageUserData* userData = PageUserData::ForTabView(view);
+	bool lazy = userData != NULL
+		&& (userData->IsLazy() || userData->IsDiscarded());
+	BString url;
+	BString title;
+	GetTabPage(tabIndex, url, title);
+
+	state.AddString("url", url);
+	state.AddString("title", title);
+	BPath faviconPath;
+	if (faviconPathForURL(url, faviconPath) == B_OK)
+		state.AddString("favicon", faviconPath.Path());
+	if (userData != NULL)
+		state.AddPoint("scroll", userData->ScrollPosition());
+	state.AddBool("lazy", lazy);
+
+	TabView* tab = fTabManager->GetTabContainerView()->TabAt(tabIndex);
+	if (tab != NULL) {
+		state.AddBool("pinned", tab->IsPinned());
+		rgb_color color = tab->GroupColor();
+		if (color != ui_color(B_PANEL_BACKGROUND_COLOR))
+			state.AddColor("color", color);
+	}
+}
+
+
+void
+BrowserWindow::_JournalWindow(uint32 what)
+{
+	// The application appends the event to the session journal, so
+	// autosaving never has to lock the window.
+	BMessage event(what);
+	event.AddUInt32("window", fWindowId);
+	if (fIsPrivate)
+		event.AddBool("private", true);
+	if (what == SessionJournal::kWindowOpened
+		|| what == SessionJournal::kWindowChanged) {
+		event.AddRect("frame", Frame());
+		event.AddUInt32("workspaces", Workspaces());
+	}
+	be_app->PostMessage(&event);
+}
+
+
+void
+BrowserWindow::_JournalWindowLater()
+{
+	// Moving or resizing a window reports many frames in a row, only the
+	// one it ends up with is journaled.
+	if (fWindowJournalRunner.get() != NULL)
+		return;
+
+	BMessage message(JOURNAL_WINDOW_CHANGED);
+	fWindowJournalRunner.reset(new BMessageRunner(BMessenger(this), &message,
+		kWindowJournalDelay, 1));
+}
+
+
+void
+BrowserWindow::_JournalTab(uint32 what, BView* view)
+{
+	int32 tabIndex = fTabManager->TabForView(view);
+	if (tabIndex < 0)
+		return;
+
+	BMessage event(what);
+	event.AddUInt32("window", fWindowId);
+	event.AddUInt32("tab", _GetOrCreateUserData(view)->Id());
+	if (fIsPrivate)
+		event.AddBool("private", true);
+	if (what == SessionJournal::kTabOpened || what == SessionJournal::kTabMoved)
+		event.AddInt32("index", tabIndex);
+	if (what == SessionJournal::kTabOpened
+		|| what == SessionJournal::kTabNavigated) {
+		BMessage state;
+		_ArchiveTabState(tabIndex, state);
+		event.AddMessage("state", &state);
+	}
+	be_app->PostMessage(&event);
+}
+
+
 bool
 BrowserWindow::QuitRequested()
 {
@@ -2607,13 +3237,20 @@ BrowserWindow::QuitRequested()
 
 		BMessage message(WINDOW_CLOSED);
 		Archive(&message);
+		message.AddBool("private", fIsPrivate);
+
+		// Nothing of a private window is kept once it is closed
+		ClosedTabStore* store = ClosedTabStore::Default();
+		if (fIsPrivate && store != NULL)
+			store->RemovePrivate(fWindowId);
+		_JournalWindow(SessionJournal::kWindowClosed);
 
 		// Iterate over all tabs to delete all BWebViews.
 		// Do this here, so WebKit tear down happens earlier.
 		SetCurrentWebView(NULL);
 		int32 tabCount = fTabManager->CountTabs();
 		while (tabCount > 0) {
-			_ShutdownTab(tabCount - 1);
+			_ShutdownTab(tabCount - 1, false);
 			if (fTabManager->CountTabs() >= tabCount)
 				break;
 			tabCount = fTabManager->CountTabs();
@@ -2730,6 +3367,23 @@ BrowserWindow::WorkspacesChanged(uint32 oldWorkspaces, uint32 newWorkspaces)
 {
 	if (fIsFullscreen)
 		_ResizeToScreen();
+	_JournalWindowLater();
+}
+
+
+void
+BrowserWindow::FrameMoved(BPoint newPosition)
+{
+	BWebWindow::FrameMoved(newPosition);
+	_JournalWindowLater();
+}
+
+
+void
+BrowserWindow::FrameResized(float width, float height)
+{
+	BWebWindow::FrameResized(width, height);
+	_JournalWindowLater();
 }
 
 
@@ -2755,6 +3409,7 @@ BrowserWindow::SetCurrentWebView(BWebView* webView)
 	if (webView == CurrentWebView())
 		return;
 
+	BWebView* previousWebView = CurrentWebView();
 	if (CurrentWebView() != NULL) {
 		// Remember the currently focused view before switching tabs,
 		// so that we can revert the focus when switching back to this tab
@@ -2768,44 +3423,24 @@ BrowserWindow::SetCurrentWebView(BWebView* webView)
 			&selectionEnd);
 		userData->SetURLInputSelection(selectionStart, selectionEnd);
 
-		// Capture Preview
-		if (CurrentWebView() && !CurrentWebView()->IsHidden()) {
-			BBitmap* tempPreview = new BBitmap(CurrentWebView()->Bounds(), B_RGB32);
-			if (tempPreview->InitCheck() == B_OK) {
-				// Use BScreen to read content if visible
-				if (CurrentWebView()->Window()) {
-					BScreen screen(CurrentWebView()->Window());
-					BRect screenRect = CurrentWebView()->ConvertToScreen(CurrentWebView()->Bounds());
-					if (screen.ReadBitmap(tempPreview, false, &screenRect) == B_OK) {
-						// Scale down to save memory
-						BRect thumbRect(0, 0, 200, 150);
-						BBitmap* thumbnail = new BBitmap(thumbRect, B_RGB32, true);
-						if (thumbnail->IsValid()) {
-							BView* thumbView = new BView(thumbRect, "thumb", B_FOLLOW_NONE, B_WILL_DRAW);
-							thumbnail->AddChild(thumbView);
-							thumbnail->Lock();
-							thumbView->SetHighColor(B_TRANSPARENT_32_BIT);
-							thumbView->FillRect(thumbRect);
-							thumbView->SetDrawingMode(B_OP_COPY);
-							thumbView->DrawBitmap(tempPreview, tempPreview->Bounds(), thumbRect, B_FILTER_BITMAP_BILINEAR);
-							thumbView->Sync();
-							thumbnail->Unlock();
-							thumbnail->RemoveChild(thumbView);
-							delete thumbView;
-
-							userData->SetPreview(thumbnail);
-						}
-						delete thumbnail;
-					}
-				}
-			}
-			delete tempPreview;
-		}
+		// Capture Preview. Only the screen grab has to happen here, the
+		// downscaling is done by a worker thread which posts the thumbnail
+		// back as PREVIEW_READY.
+		if (CurrentWebView() && !CurrentWebView()->IsHidden())
+			_CapturePreview(CurrentWebView(), userData);
+
+		userData->SetLastActivation(system_time());
+		_RequestTabState(CurrentWebView());
 	}
 
 	BWebWindow::SetCurrentWebView(webView);
+	_ReportTab(previousWebView);
 
 	if (webView != NULL) {
+		_JournalTab(SessionJournal::kTabSelected, webView);
+		_GetOrCreateUserData(webView)->SetLastActivation(system_time());
+		_ReportTab(webView);
+
 		BrowserWebView* browserWebView = dynamic_cast<BrowserWebView*>(webView);
 		if (browserWebView != NULL)
 			browserWebView->SetZoomTextOnly(fZoomTextOnly);
@@ -2891,6 +3526,19 @@ void
 BrowserWindow::CreateNewTab(const BString& _url, bool select,
 	BWebView* webView, bool lazy, int32 index)
 {
+	if (lazy && !select && webView == NULL && _url.Length() > 0) {
+		// Background tabs opened lazily get a placeholder instead of a web
+		// view until they are selected.
+		BView* view = _AddLazyTab(_url, BString(), index);
+		if (view != NULL) {
+			_LoadFavicon(_url, view);
+			_JournalTab(SessionJournal::kTabOpened, view);
+		}
+		_ShowInterface(true);
+		_UpdateTabGroupVisibility();
+		return;
+	}
+
 	bool applyNewPagePolicy = webView == NULL;
 	// Executed in app thread (new BWebPage needs to be created in app thread).
 	if (webView == NULL) {
@@ -2936,6 +3584,8 @@ BrowserWindow::CreateNewTab(const BString& _url, bool select,
 		_GetOrCreateUserData(webView);
 	}
 
+	_JournalTab(SessionJournal::kTabOpened, webView);
+
 	_ShowInterface(true);
 	_UpdateTabGroupVisibility();
 }
@@ -3184,6 +3834,7 @@ BrowserWindow::LoadNegotiating(const BString& url, BWebView* view)
 
 	if (userData != NULL)
 		userData->SetIsLoading(true);
+	_ReportTab(view);
 
 	if (view != CurrentWebView()) {
 		// Update the userData contents instead so the user sees
@@ -3215,6 +3866,8 @@ BrowserWindow::LoadCommitted(const BString& url, BWebView* view)
 		view->WebPage()->EvaluateJavaScript(script);
 	}
 
+	_JournalTab(SessionJournal::kTabNavigated, view);
+
 	if (view != CurrentWebView())
 		return;
 
@@ -3263,6 +3916,9 @@ BrowserWindow::LoadFailed(const BString& url, BWebView* view)
 	}
 	if (userData != NULL)
 		userData->SetIsLoading(false);
+	_RemoveSnapshotOverlay(view);
+	_WarmUpFinished(view);
+	_ReportTab(view);
 
 	if (view != CurrentWebView())
 		return;
@@ -3314,6 +3970,24 @@ BrowserWindow::LoadFinished(const BString& url, BWebView* view)
 		userData->SetIsBypassingCache(false);
 	}
 
+	// The page is back, stop showing the snapshot of a discarded tab
+	_RemoveSnapshotOverlay(view);
+	_WarmUpFinished(view);
+
+	if (userData != NULL && userData->RestoreScroll()
+		&& !userData->IsDiscarded() && view->WebPage()) {
+		// Return to where the page was scrolled in the previous session
+		userData->SetRestoreScroll(false);
+		BPoint position = userData->ScrollPosition();
+		if (position != B_ORIGIN) {
+			BString script;
+			script.SetToFormat("window.scrollTo(%d, %d);", (int)position.x,
+				(int)position.y);
+			view->WebPage()->EvaluateJavaScript(script);
+		}
+	}
+	_RequestTabState(view);
+
 	// Check permissions for popups and dark mode injection
 	bool allowJS = true;
 	bool allowCookies = true;
@@ -3394,6 +4068,7 @@ BrowserWindow::LoadFinished(const BString& url, BWebView* view)
 		if (userData->IsDownloadRestart())
 			userData->SetIsDownloadRestart(false);
 	}
+	_ReportTab(view);
 
 	if (view != CurrentWebView())
 		return;
@@ -3456,6 +4131,8 @@ BrowserWindow::MainDocumentError(const BString& failingURL,
 		}
 	}
 
+	_RemoveSnapshotOverlay(view);
+	_WarmUpFinished(view);
 	BWebWindow::MainDocumentError(failingURL, localizedDescription, view);
 
 	// Remove the failing URL from the browsing history.
@@ -3471,6 +4148,7 @@ BrowserWindow::TitleChanged(const BString& title, BWebView* view)
 		return;
 
 	fTabManager->SetTabLabel(tabIndex, title);
+	_JournalTab(SessionJournal::kTabNavigated, view);
 
 	if (view != CurrentWebView())
 		return;
@@ -3797,9 +4475,39 @@ BrowserWindow::_UpdateTitle(const BString& title)
 }
 
 
+void
+BrowserWindow::BeginTabBatch()
+{
+	// Opening or closing many tabs at once should not lay out the tab strip,
+	// pick a new selection and update the interface for every single tab.
+	if (fTabBatchDepth++ == 0)
+		fTabManager->BeginBatch();
+}
+
+
+void
+BrowserWindow::CommitTabBatch()
+{
+	if (fTabBatchDepth == 0 || --fTabBatchDepth > 0)
+		return;
+
+	fTabManager->CommitBatch();
+
+	ClosedTabStore* store = ClosedTabStore::Default();
+	if (store != NULL && !fBatchClosedTabs.empty())
+		store->AddTabs(fBatchClosedTabs, fIsPrivate, fWindowId);
+	fBatchClosedTabs.clear();
+
+	_UpdateTabGroupVisibility();
+}
+
+
 void
 BrowserWindow::_UpdateTabGroupVisibility()
 {
+	if (fTabBatchDepth > 0)
+		return;
+
 	if (Lock()) {
 		if (fInterfaceVisible)
 			fTabGroup->SetVisible(_TabGroupShouldBeVisible());
@@ -3818,21 +4526,28 @@ BrowserWindow::_TabGroupShouldBeVisible() const
 
 
 void
-BrowserWindow::_ShutdownTab(int32 index)
+BrowserWindow::_ShutdownTab(int32 index, bool remember)
 {
 	BView* view = fTabManager->ViewForTab(index);
 	BWebView* webView = dynamic_cast<BWebView*>(view);
 
-	if (webView != NULL) {
-		BString url = webView->MainFrameURL();
-		if (url.Length() > 0 && url != "about:blank") {
-			ClosedTabInfo info;
-			info.url = url;
-			info.title = webView->MainFrameTitle();
-			fClosedTabs.push_back(info);
-			if (fClosedTabs.size() > 10)
-				fClosedTabs.pop_front();
-			_UpdateRecentlyClosedMenu();
+	if (view != NULL) {
+		// Also covers tabs which were never loaded. Tabs of a closing window
+		// are remembered with the window instead.
+		BMessage state;
+		_ArchiveTabState(index, state);
+		BString url = state.GetString("url", "");
+		ClosedTabStore* store = ClosedTabStore::Default();
+		if (remember && store != NULL && url.Length() > 0
+			&& url != "about:blank") {
+			if (fTabBatchDepth > 0) {
+				state.AddInt32("index", index);
+				try {
+					fBatchClosedTabs.push_back(state);
+				} catch (...) {
+				}
+			} else
+				store->AddTab(state, index, fIsPrivate, fWindowId);
 		}
 	}
 
@@ -3843,6 +4558,9 @@ BrowserWindow::_ShutdownTab(int32 index)
 	if (CurrentWebView() != NULL && webView == CurrentWebView())
 		SetCurrentWebView(NULL);
 
+	if (view != NULL)
+		_JournalTab(SessionJournal::kTabClosed, view);
+
 	view = fTabManager->RemoveTab(index);
 	// webView pointer is still valid here, as RemoveTab only removed it from layout
 
@@ -3860,23 +4578,34 @@ BrowserWindow::_ShutdownTab(int32 index)
 void
 BrowserWindow::_TabChanged(int32 index)
 {
-	SetCurrentWebView(dynamic_cast<BWebView*>(fTabManager->ViewForTab(index)));
+	SetCurrentWebView(_MaterializeTab(index));
 }
 
 
 
 
 void
-BrowserWindow::_SetPageIcon(BWebView* view, const BBitmap* icon, bool save)
+BrowserWindow::_SetPageIcon(BView* view, const BBitmap* icon, bool save)
 {
 	PageUserData* userData = _GetOrCreateUserData(view);
+	if (userData == NULL)
+		return;
 
 	// The PageUserData makes a copy of the icon, which we pass on to
 	// the TabManager for display in the respective tab.
 	userData->SetPageIcon(icon);
 
-	if (save && icon) {
-		_SaveFavicon(view->MainFrameURL(), icon);
+	BWebView* webView = dynamic_cast<BWebView*>(view);
+	if (save && icon && webView != NULL) {
+		_SaveFavicon(webView->MainFrameURL(), icon);
+	}
+
+	// Shared with the bookmark bar, for the bookmarks of this site. What a
+	// private window visits must not show up anywhere else.
+	if (icon != NULL && !fIsPrivate) {
+		BString url = webView != NULL
+			? webView->MainFrameURL() : userData->PendingURL();
+		IconCache::Default().Put(IconCache::KeyForURL(url), icon);
 	}
 
 	fTabManager->SetTabIcon(view, userData->PageIcon());
@@ -3886,21 +4615,28 @@ BrowserWindow::_SetPageIcon(BWebView* view, const BBitmap* icon, bool save)
 
 
 PageUserData*
-BrowserWindow::_GetOrCreateUserData(BWebView* view)
+BrowserWindow::_GetOrCreateUserData(BView* view)
 {
 	if (view == NULL)
 		return NULL;
 
-	PageUserData* userData = static_cast<PageUserData*>(view->GetUserData());
+	PageUserData* userData = PageUserData::ForTabView(view);
 	if (userData == NULL) {
+		BWebView* webView = dynamic_cast<BWebView*>(view);
+		if (webView == NULL)
+			return NULL;
 		userData = new PageUserData(NULL);
-		view->SetUserData(userData);
+		webView->SetUserData(userData);
 	}
 
 	if (userData->Id() == 0) {
-		userData->SetId(fNextTabId++);
-		if (fNextTabId == 0)
-			fNextTabId = 1;
+		// Ids are unique across all windows, since the preview cache is
+		// shared by the whole application.
+		uint32 id;
+		do {
+			id = (uint32)atomic_add(&sNextTabId, 1);
+		} while (id == 0);
+		userData->SetId(id);
 	}
 
 	return userData;
@@ -4365,91 +5101,351 @@ BrowserWindow::_ShowBookmarkBar(bool show)
 void
 BrowserWindow::_ReopenClosedTab()
 {
-	if (fClosedTabs.empty())
+	ClosedTabStore* store = ClosedTabStore::Default();
+	if (store == NULL || !store->Lock())
 		return;
 
-	ClosedTabInfo info = fClosedTabs.back();
-	fClosedTabs.pop_back();
-	_UpdateRecentlyClosedMenu();
+	// Reopens whatever was closed last, be it a tab or a whole window
+	const ClosedTabStore::Entry* last = NULL;
+	for (int32 i = 0; i < store->CountEntries(); i++) {
+		const ClosedTabStore::Entry* entry = store->EntryAt(i);
+		if (!entry->isPrivate || entry->window == fWindowId) {
+			last = entry;
+			break;
+		}
+	}
 
-	CreateNewTab(info.url, true);
+	ClosedTabStore::Entry entry;
+	bool found = false;
+	if (last != NULL && last->kind == ClosedTabStore::kWindow) {
+		BMessage message(REOPEN_CLOSED_WINDOW);
+		message.AddUInt32("id", last->id);
+		be_app->PostMessage(&message);
+	} else if (last != NULL)
+		found = store->Take(last->id, entry);
+	store->Unlock();
+
+	if (found)
+		_ReopenTab(entry.archive);
+}
+
+
+void
+BrowserWindow::_ReopenTab(const BMessage& state)
+{
+	BView* view = _RestoreTab(state, state.GetInt32("index", -1));
+	if (view == NULL)
+		return;
+
+	fTabManager->SelectTab(view);
+	_UpdateTabGroupVisibility();
+
+	const char* faviconPath;
+	if (state.FindString("favicon", &faviconPath) != B_OK)
+		return;
+	FaviconBatchLoadParams* icons = new(std::nothrow) FaviconBatchLoadParams;
+	if (icons == NULL)
+		return;
+	try {
+		icons->icons.push_back(std::make_pair(BPath(faviconPath),
+			_GetOrCreateUserData(view)->Id()));
+	} catch (...) {
+	}
+	icons->target = BMessenger(this);
+	_LoadFavicons(icons);
 }
 
 
 void
 BrowserWindow::_UpdateRecentlyClosedMenu()
 {
-	bool hasClosedTabs = !fClosedTabs.empty();
-	if (fReopenClosedTabMenuItem != NULL)
-		fReopenClosedTabMenuItem->SetEnabled(hasClosedTabs);
-
-	if (fRecentlyClosedMenu != NULL) {
-		fRecentlyClosedMenu->RemoveItems(0, fRecentlyClosedMenu->CountItems(), true);
-
-		for (int32 i = (int32)fClosedTabs.size() - 1; i >= 0; i--) {
-			const ClosedTabInfo& info = fClosedTabs[i];
-			BMessage* msg = new BMessage(REOPEN_CLOSED_TAB_WITH_INDEX);
-			msg->AddInt32("index", i);
-
-			BString label = info.title;
-			if (label.IsEmpty()) label = info.url;
-			if (label.Length() > 50) {
-				label.Truncate(50);
-				label << B_UTF8_ELLIPSIS;
-			}
+	ClosedTabStore* store = ClosedTabStore::Default();
+	if (store == NULL || !store->Lock())
+		return;
+
+	// Only rebuilt when something was closed or reopened since the last time
+	if (store->Generation() == fLastClosedTabsGeneration) {
+		store->Unlock();
+		return;
+	}
+	fLastClosedTabsGeneration = store->Generation();
 
-			fRecentlyClosedMenu->AddItem(new BMenuItem(label, msg));
+	fRecentlyClosedMenu->RemoveItems(0, fRecentlyClosedMenu->CountItems(),
+		true);
+
+	for (int32 i = 0; i < store->CountEntries(); i++) {
+		const ClosedTabStore::Entry* entry = store->EntryAt(i);
+		// Tabs closed in a private window are only offered in that window
+		if (entry->isPrivate && entry->window != fWindowId)
+			continue;
+
+		BMessage state;
+		if (entry->kind == ClosedTabStore::kWindow)
+			entry->archive.FindMessage("tab state", 0, &state);
+		else
+			state = entry->archive;
+
+		BString label = state.GetString("title", "");
+		if (label.IsEmpty())
+			label = state.GetString("url", "");
+		if (label.Length() > 50) {
+			label.Truncate(50);
+			label << B_UTF8_ELLIPSIS;
 		}
 
-		fRecentlyClosedMenu->SetEnabled(hasClosedTabs);
+		BMessage* msg;
+		if (entry->kind == ClosedTabStore::kWindow) {
+			type_code type;
+			int32 count = 0;
+			entry->archive.GetInfo("tab state", &type, &count);
+			BString windowLabel(B_TRANSLATE("Window with %count% tabs: %title%"));
+			BString countString;
+			countString << count;
+			windowLabel.ReplaceFirst("%count%", countString);
+			windowLabel.ReplaceFirst("%title%", label);
+			label = windowLabel;
+			msg = new BMessage(REOPEN_CLOSED_WINDOW);
+		} else
+			msg = new BMessage(REOPEN_CLOSED_TAB_WITH_ID);
+		msg->AddUInt32("id", entry->id);
+
+		BMenuItem* item = new BMenuItem(label, msg);
+		if (entry->kind == ClosedTabStore::kWindow)
+			item->SetTarget(be_app);
+		fRecentlyClosedMenu->AddItem(item);
 	}
+	store->Unlock();
+
+	bool hasClosedTabs = fRecentlyClosedMenu->CountItems() > 0;
+	fReopenClosedTabMenuItem->SetEnabled(hasClosedTabs);
+	fRecentlyClosedMenu->SetEnabled(hasClosedTabs);
+}
+
+
+bool
+BrowserWindow::_GetTabInfo(BView* view, TabDiscardPolicy::TabInfo& tab) const
+{
+	int32 index = fTabManager->TabForView(view);
+	if (index < 0)
+		return false;
+	PageUserData* userData = PageUserData::ForTabView(view);
+	if (userData == NULL || userData->Id() == 0)
+		return false;
+
+	tab.id = userData->Id();
+	tab.lastActivation = userData->LastActivation();
+	tab.estimatedCost = TabDiscardPolicy::EstimateCost(
+		userData->DomNodeCount());
+	tab.loaded = dynamic_cast<BWebView*>(view) != NULL
+		&& !userData->IsLazy() && !userData->IsDiscarded();
+	tab.current = view == CurrentWebView();
+	tab.loading = userData->IsLoading();
+	tab.playingMedia = userData->IsPlayingMedia();
+	tab.dirtyForm = userData->HasDirtyForm();
+	TabView* tabView = fTabManager->GetTabContainerView()->TabAt(index);
+	tab.pinned = tabView != NULL && tabView->IsPinned();
+	return true;
+}
+
+
+void
+BrowserWindow::_ReportTab(BView* view)
+{
+	// The application keeps track of the tabs of all windows, to decide
+	// which ones to unload when memory runs low.
+	TabDiscardPolicy::TabInfo tab;
+	if (!_GetTabInfo(view, tab))
+		return;
+
+	BMessage message(TAB_STATE_CHANGED);
+	message.AddUInt32("window", fWindowId);
+	message.AddUInt32("tab", tab.id);
+	message.AddInt64("last activation", tab.lastActivation);
+	message.AddUInt64("cost", tab.estimatedCost);
+	message.AddBool("loaded", tab.loaded);
+	message.AddBool("current", tab.current);
+	message.AddBool("loading", tab.loading);
+	message.AddBool("pinned", tab.pinned);
+	message.AddBool("playing media", tab.playingMedia);
+	message.AddBool("dirty form", tab.dirtyForm);
+	be_app->PostMessage(&message);
 }
 
 
 void
-BrowserWindow::_CheckMemoryPressure()
+BrowserWindow::_DiscardTab(BWebView* view)
 {
-	if (fLowRAMMode) {
-		_DiscardBackgroundTabs();
+	if (view == NULL || view == CurrentWebView())
+		return;
+
+	int32 index = fTabManager->TabForView(view);
+	BString url = view->MainFrameURL();
+	if (index < 0 || url.Length() == 0 || url == "about:blank")
+		return;
+
+	// The whole WebKit page goes away, a placeholder keeps the user data
+	// with everything needed to bring the tab back as it was.
+	PageUserData* userData = _GetOrCreateUserData(view);
+	LazyTabView* placeholder = LazyTabView::TakeOver(view);
+	if (placeholder == NULL)
+		return;
+	if (fTabManager->ReplaceView(index, placeholder) == NULL) {
+		placeholder->HandOver(view);
+		delete placeholder;
 		return;
 	}
 
-	system_info info;
-	if (get_system_info(&info) == B_OK) {
-		uint64 usedPages = info.used_pages;
-		uint64 maxPages = info.max_pages;
-		// If more than 90% memory used
-		if (usedPages > (uint64)(maxPages * 0.9)) {
-			_DiscardBackgroundTabs();
-		}
+	userData->SetPendingURL(url);
+	userData->SetPendingTitle(view->MainFrameTitle());
+	userData->SetIsDiscarded(true);
+	userData->SetRestoreScroll(true);
+	userData->SetIsLoading(false);
+	userData->FreezeSnapshot();
+
+	view->Shutdown();
+	delete view;
+}
+
+
+void
+BrowserWindow::_WarmUpTab(int32 index)
+{
+	// Starts loading a lazy or discarded tab before it is selected, when the
+	// user is likely about to switch to it. WebKit cannot load a page at a
+	// lower priority, so instead only a few of these loads run at a time,
+	// and none in low RAM mode.
+	if (fLowRAMMode || index < 0 || index == fTabManager->SelectedTabIndex())
+		return;
+
+	PageUserData* userData = PageUserData::ForTabView(
+		fTabManager->ViewForTab(index));
+	if (userData == NULL || (!userData->IsLazy() && !userData->IsDiscarded())
+		|| userData->PendingURL().Length() == 0) {
+		return;
+	}
+
+	// Forget the tabs which have been closed while warming up
+	std::map<uint32, std::unique_ptr<BMessageRunner> >::iterator it
+		= fWarmingTabs.begin();
+	while (it != fWarmingTabs.end()) {
+		if (_ViewForTabId(it->first) == NULL)
+			fWarmingTabs.erase(it++);
+		else
+			it++;
+	}
+	if ((int32)fWarmingTabs.size() >= kMaxConcurrentWarmUps)
+		return;
+
+	BString url = userData->PendingURL();
+	BWebView* webView = _MaterializeTab(index);
+	if (webView == NULL)
+		return;
+
+	userData->SetIsLazy(false);
+	userData->SetIsDiscarded(false);
+	// Not picked for discarding right away again
+	userData->SetLastActivation(system_time());
+	webView->LoadURL(url);
+	_ReportTab(webView);
+
+	// A page that never finishes loading must not keep its slot
+	BMessage timeout(WARM_UP_TIMEOUT);
+	timeout.AddUInt32("tabId", userData->Id());
+	try {
+		fWarmingTabs[userData->Id()].reset(new BMessageRunner(
+			BMessenger(this), &timeout, kWarmUpTimeout, 1));
+	} catch (...) {
 	}
 }
 
 
 void
-BrowserWindow::_DiscardBackgroundTabs()
+BrowserWindow::_WarmUpFinished(BWebView* view)
 {
-	BWebView* current = CurrentWebView();
-	int32 count = fTabManager->CountTabs();
-	for (int32 i = 0; i < count; i++) {
-		BView* view = fTabManager->ViewForTab(i);
-		BWebView* webView = dynamic_cast<BWebView*>(view);
-		if (webView && webView != current) {
-			PageUserData* userData = static_cast<PageUserData*>(webView->GetUserData());
-			if (userData && !userData->IsDiscarded() && !userData->IsLazy() && !userData->IsLoading()) {
-				// Save URL
-				BString url = webView->MainFrameURL();
-				if (url.Length() > 0 && url != "about:blank") {
-					userData->SetPendingURL(url);
-					userData->SetIsDiscarded(true);
-					webView->LoadURL("about:blank");
-				}
-			}
+	PageUserData* userData = PageUserData::ForTabView(view);
+	if (userData == NULL)
+		return;
+
+	fWarmingTabs.erase(userData->Id());
+}
+
+
+void
+BrowserWindow::_RemoveSnapshotOverlay(BWebView* view)
+{
+	if (view == NULL)
+		return;
+
+	for (int32 i = view->CountChildren() - 1; i >= 0; i--) {
+		LazyTabView* overlay = dynamic_cast<LazyTabView*>(view->ChildAt(i));
+		if (overlay != NULL) {
+			overlay->RemoveSelf();
+			delete overlay;
 		}
 	}
 }
 
 
+void
+BrowserWindow::_RequestTabState(BWebView* view)
+{
+	// Asks the page for what is needed to remember the tab in the session
+	// and to decide whether it may be discarded. The answer comes back
+	// through the console as ADD_CONSOLE_MESSAGE.
+	PageUserData* userData = _GetOrCreateUserData(view);
+	if (userData == NULL || userData->IsLazy() || userData->IsDiscarded()
+		|| view->WebPage() == NULL) {
+		return;
+	}
+
+	// While the page is shown, the state is reported again whenever the
+	// user stopped scrolling for a moment, so the session always has the
+	// current position.
+	BString script(
+		"(function() {"
+		"  function report() {"
+		"    var dirty = false;"
+		"    try {"
+		"        var fields = document.querySelectorAll('input, textarea, select');"
+		"        for (var i = 0; i < fields.length && !dirty; i++) {"
+		"            var el = fields[i];"
+		"            if (el.disabled || el.readOnly) continue;"
+		"            if (el.type == 'checkbox' || el.type == 'radio')"
+		"                dirty = el.checked != el.defaultChecked;"
+		"            else if (el.options) {"
+		"                for (var k = 0; k < el.options.length && !dirty; k++)"
+		"                    dirty = el.options[k].selected != el.options[k].defaultSelected;"
+		"            } else if (el.type != 'hidden' && el.type != 'submit' && el.type != 'button')"
+		"                dirty = el.value != el.defaultValue;"
+		"        }"
+		"    } catch(e) {}"
+		"    var media = false;"
+		"    try {"
+		"        var players = document.querySelectorAll('audio, video');"
+		"        for (var j = 0; j < players.length && !media; j++)"
+		"            media = !players[j].paused;"
+		"    } catch(e) {}"
+		"    console.log('WebPositive:TabState:%id:' + window.scrollX + ':'"
+		"        + window.scrollY + ':' + (dirty ? 1 : 0) + ':' + (media ? 1 : 0)"
+		"        + ':' + document.getElementsByTagName('*').length);"
+		"  }"
+		"  report();"
+		"  if (!window.webPositiveScrollReport) {"
+		"    var timer = null;"
+		"    window.webPositiveScrollReport = true;"
+		"    window.addEventListener('scroll', function() {"
+		"      clearTimeout(timer);"
+		"      timer = setTimeout(report, 500);"
+		"    });"
+		"  }"
+		"})();");
+	BString id;
+	id << userData->Id();
+	script.ReplaceFirst("%id", id);
+	view->WebPage()->EvaluateJavaScript(script);
+}
+
+
 void
 BrowserWindow::_UpdateToolbarPlacement()
 {
@@ -4483,27 +5479,17 @@ BrowserWindow::_GetFaviconPath(const BString& url, BPath& path)
 	if (url.Length() == 0)
 		return B_BAD_VALUE;
 
-	if (find_directory(B_USER_SETTINGS_DIRECTORY, &path) != B_OK)
+	BPath directory;
+	if (find_directory(B_USER_SETTINGS_DIRECTORY, &directory) != B_OK)
 		return B_ERROR;
 
-	path.Append(kApplicationName);
-	path.Append("Favicons");
+	directory.Append(kApplicationName);
+	directory.Append("Favicons");
 
-	if (create_directory(path.Path(), 0777) != B_OK)
+	if (create_directory(directory.Path(), 0777) != B_OK)
 		return B_ERROR;
 
-	BUrl parsedUrl(url.String(), true);
-	if (!parsedUrl.IsValid() || parsedUrl.Host().Length() == 0)
-		return B_BAD_VALUE;
-
-	BString filename(parsedUrl.Host());
-	// Sanitize filename
-	filename.ToLower();
-	filename.ReplaceAll('/', '_');
-	filename.ReplaceAll(':', '_');
-
-	path.Append(filename.String());
-	return B_OK;
+	return faviconPathForURL(url, path);
 }
 
 
@@ -4549,12 +5535,12 @@ BrowserWindow::_SaveFavicon(const BString& url, const BBitmap* icon)
 
 
 void
-BrowserWindow::_LoadFavicon(const BString& url, BWebView* view)
+BrowserWindow::_LoadFavicon(const BString& url, BView* view)
 {
 	if (view == NULL) return;
 
 	// Don't overwrite existing icon
-	PageUserData* userData = static_cast<PageUserData*>(view->GetUserData());
+	PageUserData* userData = PageUserData::ForTabView(view);
 	if (userData && userData->PageIcon())
 		return;
 
@@ -4584,3 +5570,78 @@ BrowserWindow::_LoadFavicon(const BString& url, BWebView* view)
 		delete params;
 	}
 }
+
+
+BView*
+BrowserWindow::_ViewForTabId(uint32 tabId) const
+{
+	for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
+		BView* tab = fTabManager->ViewForTab(i);
+		PageUserData* userData = PageUserData::ForTabView(tab);
+		if (userData && userData->Id() == tabId)
+			return tab;
+	}
+	return NULL;
+}
+
+
+BWebView*
+BrowserWindow::_WebViewForTabId(uint32 tabId) const
+{
+	return dynamic_cast<BWebView*>(_ViewForTabId(tabId));
+}
+
+
+void
+BrowserWindow::_CapturePreview(BWebView* view, PageUserData* userData)
+{
+	if (view->Window() == NULL)
+		return;
+
+	BBitmap* capture = new(std::nothrow) BBitmap(view->Bounds(), B_RGB32);
+	if (capture == NULL || capture->InitCheck() != B_OK) {
+		delete capture;
+		return;
+	}
+
+	// Use BScreen to read content if visible
+	BScreen screen(view->Window());
+	BRect screenRect = view->ConvertToScreen(view->Bounds());
+	if (screen.ReadBitmap(capture, false, &screenRect) != B_OK) {
+		delete capture;
+		return;
+	}
+
+	PreviewScaleParams* params = new(std::nothrow) PreviewScaleParams;
+	if (params == NULL) {
+		delete capture;
+		return;
+	}
+
+	// Only a tab that may get discarded needs a snapshot to stand in for it.
+	// The tab is being left, so it will no longer be the current one.
+	TabDiscardPolicy::TabInfo tab;
+	bool discardable = false;
+	if (_GetTabInfo(view, tab)) {
+		tab.current = false;
+		discardable = TabDiscardPolicy().IsDiscardable(tab);
+	}
+
+	params->capture = capture;
+	params->target = BMessenger(this);
+	params->tabId = userData->Id();
+	params->snapshot = discardable;
+
+	thread_id thread = spawn_thread(_ScalePreviewThread, "Scale Preview",
+		B_LOW_PRIORITY, params);
+	if (thread >= 0) {
+		if (resume_thread(thread) != B_OK) {
+			kill_thread(thread);
+			delete params->capture;
+			delete params;
+		}
+	} else {
+		delete params->capture;
+		delete params;
+	}
+}
@@ -31,18 +31,20 @@
 
 #include "WebWindow.h"
 
-#include <deque>
 #include <DateTime.h>
 #include <Messenger.h>
 #include <String.h>
 #include <UrlContext.h>
 
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "bookmarks/BookmarkManager.h"
 #include "support/URLHandler.h"
 #include "support/FormSafetyHelper.h"
 #include "support/PageSourceSaver.h"
+#include "support/TabDiscardPolicy.h"
 
 class BButton;
 class BCheckBox;
@@ -66,6 +68,7 @@ class TabManager;
 class URLInputGroup;
 class PermissionsWindow;
 class NetworkWindow;
+class PageUserData;
 
 namespace BPrivate {
 	class BIconButton;
@@ -117,7 +120,8 @@ enum {
 	CHECK_FORM_DIRTY_TIMEOUT		= 'cfdt',
 	RESTART_DOWNLOAD_IN_WINDOW		= 'rdwn',
 	TOGGLE_AUTO_HIDE_BOOKMARK_BAR	= 'tahb',
-	REOPEN_CLOSED_TAB_WITH_INDEX	= 'rcti',
+	REOPEN_CLOSED_TAB_WITH_ID		= 'rcti',
+	REOPEN_CLOSED_WINDOW			= 'rcwn',
 	RELOAD							= 'reld',
 	RELOAD_BYPASS_CACHE				= 'rlbc',
 	PRINT_PAGE						= 'prnt',
@@ -131,6 +135,7 @@ enum {
 	TOGGLE_LOAD_IMAGES				= 'tgli',
 	INSPECT_ELEMENT					= 'insp',
 	RESET_BUTTON_STATE				= 'rsts',
+	JOURNAL_WINDOW_CHANGED			= 'jnwc',
 
 	EXPORT_BOOKMARKS							= 'exbm',
 	IMPORT_BOOKMARKS							= 'imbm',
@@ -138,6 +143,8 @@ enum {
 	SYNC_EXPORT									= 'syex',
 	SYNC_IMPORT									= 'syim',
 	CHECK_MEMORY_PRESSURE			= 'cmem',
+	TAB_STATE_CHANGED				= 'tbsc',
+	DISCARD_TAB						= 'dctb',
 	PERMISSIONS_WINDOW_CLOSED		= 'pwcl',
 	NETWORK_WINDOW_CLOSED			= 'nwcl',
 
@@ -146,7 +153,12 @@ enum {
 	OPEN_MANY_BOOKMARKS_CONFIRMED	= 'ombc',
 	FORM_SAFETY_ALERT_CONFIRMED		= 'fsac',
 	SELECT_TAB_BY_VIEW				= 'stbv',
-	FAVICON_LOADED					= 'favl'
+	COLLECT_TAB_SEARCH_ENTRIES		= 'ctse',
+	TAB_SEARCH_ENTRIES				= 'tsen',
+	FAVICON_LOADED					= 'favl',
+	PREVIEW_READY					= 'prvr',
+	REMOVE_SNAPSHOT_OVERLAY			= 'rmso',
+	WARM_UP_TIMEOUT					= 'wuto'
 };
 
 
@@ -174,6 +186,8 @@ public:
 									color_space format);
 	virtual void				WorkspacesChanged(uint32 oldWorkspaces,
 									uint32 newWorkspaces);
+	virtual	void				FrameMoved(BPoint newPosition);
+	virtual	void				FrameResized(float width, float height);
 
 	virtual	void				SetCurrentWebView(BWebView* view);
 
@@ -182,12 +196,19 @@ public:
 									BWebView* webView = 0, bool lazy = false,
 									int32 index = -1);
 			void				RestartDownload(const BString& url);
+			void				RestoreSession(const BMessage& archive);
+
+			void				BeginTabBatch();
+			void				CommitTabBatch();
 
 			BRect				WindowFrame() const;
 
 			void				ToggleFullscreen();
 
 			TabManager*			GetTabManager() const { return fTabManager.get(); }
+			void				GetTabPage(int32 tabIndex, BString& url,
+									BString& title) const;
+			uint32				WindowId() const { return fWindowId; }
 
 private:
 	// WebPage notification API implementations
@@ -231,10 +252,11 @@ private:
 			void				_UpdateTitle(const BString &title);
 			void				_UpdateTabGroupVisibility();
 			bool				_TabGroupShouldBeVisible() const;
-			void				_ShutdownTab(int32 index);
+			void				_ShutdownTab(int32 index,
+									bool remember = true);
 			void				_TabChanged(int32 index);
 
-			void				_SetPageIcon(BWebView* view,
+			void				_SetPageIcon(BView* view,
 									const BBitmap* icon, bool save = true);
 
 			void				_UpdateHistoryMenu();
@@ -259,23 +281,41 @@ private:
 			void				_UpdateToolbarPlacement();
 
 			void				_ReopenClosedTab();
+			void				_ReopenTab(const BMessage& state);
 			void				_UpdateRecentlyClosedMenu();
 
 			status_t			_GetFaviconPath(const BString& url, BPath& path);
 			void				_SaveFavicon(const BString& url, const BBitmap* icon);
-			void				_LoadFavicon(const BString& url, BWebView* view);
-
-			void				_CheckMemoryPressure();
-			void				_DiscardBackgroundTabs();
-
-			PageUserData*		_GetOrCreateUserData(BWebView* view);
+			void				_LoadFavicon(const BString& url, BView* view);
+
+			bool				_GetTabInfo(BView* view,
+									TabDiscardPolicy::TabInfo& tab) const;
+			void				_ReportTab(BView* view);
+			void				_DiscardTab(BWebView* view);
+			void				_RemoveSnapshotOverlay(BWebView* view);
+			void				_WarmUpTab(int32 index);
+			void				_WarmUpFinished(BWebView* view);
+			void				_RequestTabState(BWebView* view);
+
+			PageUserData*		_GetOrCreateUserData(BView* view);
+			BView*				_ViewForTabId(uint32 tabId) const;
+			BWebView*			_WebViewForTabId(uint32 tabId) const;
+			BView*				_AddLazyTab(const BString& url,
+									const BString& title, int32 index = -1);
+			BWebView*			_MaterializeTab(int32 index);
+			BView*				_RestoreTab(const BMessage& state,
+									int32 index = -1);
+			void				_ApplyTabState(int32 tabIndex,
+									const BMessage& state);
+			void				_ArchiveTabState(int32 tabIndex,
+									BMessage& state) const;
+			void				_JournalWindow(uint32 what);
+			void				_JournalWindowLater();
+			void				_JournalTab(uint32 what, BView* view);
+			void				_CapturePreview(BWebView* view,
+									PageUserData* userData);
 
 private:
-			struct ClosedTabInfo {
-				BString url;
-				BString title;
-			};
-			std::deque<ClosedTabInfo> fClosedTabs;
 			BMenu*				fRecentlyClosedMenu;
 			BMenuItem*			fReopenClosedTabMenuItem;
 
@@ -283,6 +323,7 @@ private:
 			int32				fHistoryMenuFixedItemCount;
 
 			uint32				fLastHistoryGeneration;
+			uint32				fLastClosedTabsGeneration;
 			BDateTime			fLastHistoryMenuDate;
 
 			BMenuItem*			fCutMenuItem;
@@ -325,6 +366,7 @@ private:
 			BRect				fNonFullscreenWindowFrame;
 			std::unique_ptr<BMessageRunner>		fPulseRunner;
 			std::unique_ptr<BMessageRunner>		fButtonResetRunner;
+			std::unique_ptr<BMessageRunner>		fWindowJournalRunner;
 			uint32				fVisibleInterfaceElements;
 			bigtime_t			fLastMouseMovedTime;
 			BPoint				fLastMousePos;
@@ -369,11 +411,14 @@ private:
 			PermissionsWindow*	fPermissionsWindow;
 			NetworkWindow*		fNetworkWindow;
 			bool				fIsPrivate;
+			uint32				fWindowId;
+			int32				fTabBatchDepth;
+			std::vector<BMessage> fBatchClosedTabs;
+			std::map<uint32, std::unique_ptr<BMessageRunner> > fWarmingTabs;
+									// with the runner of their timeout
 
-			std::unique_ptr<BMessageRunner>		fMemoryPressureRunner;
 
 			bool				fExpectingDomInspection;
-			uint32				fNextTabId;
 };
 
 
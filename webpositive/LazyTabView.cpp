@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "LazyTabView.h"
+
+#include <Bitmap.h>
+#include <InterfaceDefs.h>
+
+#include <new>
+
+#include "PageUserData.h"
+
+
+LazyTabView::LazyTabView(PageUserData* userData)
+	:
+	BView("lazy tab", B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE),
+	fUserData(userData)
+{
+	SetViewUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+	SetLowUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+}
+
+
+LazyTabView::~LazyTabView()
+{
+	delete fUserData;
+}
+
+
+void
+LazyTabView::Draw(BRect updateRect)
+{
+	if (fSnapshot != NULL) {
+		// Scale to the width of the view, the page may have been seen in a
+		// window of a different size.
+		BRect source = fSnapshot->Bounds();
+		BRect bounds = Bounds();
+		BRect target(bounds.left, bounds.top, bounds.right,
+			bounds.top + source.Height() * bounds.Width() / source.Width());
+		DrawBitmap(fSnapshot.get(), source, target, B_FILTER_BITMAP_BILINEAR);
+		if (target.bottom < bounds.bottom) {
+			FillRect(BRect(bounds.left, target.bottom + 1, bounds.right,
+				bounds.bottom), B_SOLID_LOW);
+		}
+		return;
+	}
+
+	// Normally only visible for a moment while the tab is being loaded
+	if (fUserData == NULL)
+		return;
+
+	const BString& title = fUserData->PendingTitle().Length() > 0
+		? fUserData->PendingTitle() : fUserData->PendingURL();
+	BString label(title);
+	BFont font;
+	GetFont(&font);
+	font.TruncateString(&label, B_TRUNCATE_END, Bounds().Width() - 20);
+
+	font_height fontHeight;
+	font.GetHeight(&fontHeight);
+	BRect bounds = Bounds();
+	SetHighUIColor(B_DOCUMENT_TEXT_COLOR, B_DARKEN_2_TINT);
+	DrawString(label, BPoint(
+		bounds.left + (bounds.Width() - font.StringWidth(label)) / 2,
+		bounds.top + (bounds.Height() + fontHeight.ascent) / 2));
+}
+
+
+PageUserData*
+LazyTabView::DetachUserData()
+{
+	PageUserData* userData = fUserData;
+	fUserData = NULL;
+	return userData;
+}
+
+
+/*static*/ LazyTabView*
+LazyTabView::TakeOver(BWebView* webView)
+{
+	LazyTabView* placeholder = new(std::nothrow) LazyTabView(
+		static_cast<PageUserData*>(webView->GetUserData()));
+	if (placeholder != NULL)
+		webView->SetUserData(NULL);
+	return placeholder;
+}
+
+
+void
+LazyTabView::HandOver(BWebView* webView)
+{
+	webView->SetUserData(DetachUserData());
+}
+
+
+void
+LazyTabView::SetSnapshot(const PreviewCache::PreviewRef& snapshot)
+{
+	fSnapshot = snapshot;
+	Invalidate();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef LAZY_TAB_VIEW_H
+#define LAZY_TAB_VIEW_H
+
+#include <View.h>
+
+#include "PreviewCache.h"
+
+class BWebView;
+class PageUserData;
+
+
+// Stands in for the web view of a tab which has not been loaded yet. It only
+// holds the tab's PageUserData (pending URL, title, icon), so an unloaded tab
+// costs no WebKit page. BrowserWindow replaces it with a real BrowserWebView
+// when the tab is selected for the first time.
+//
+// For a tab that was discarded, the view can also show a snapshot of the
+// page as it was last seen. BrowserWindow then lays it over the new web view
+// until the page has been loaded again.
+class LazyTabView : public BView {
+public:
+	LazyTabView(PageUserData* userData);
+	virtual ~LazyTabView();
+
+	virtual void Draw(BRect updateRect);
+
+	PageUserData* UserData() const { return fUserData; }
+	PageUserData* DetachUserData();
+
+	// Move the user data from a web view into a new placeholder, and back
+	// into a web view, following the ownership rules of PageUserData.
+	static LazyTabView* TakeOver(BWebView* webView);
+	void HandOver(BWebView* webView);
+
+	void SetSnapshot(const PreviewCache::PreviewRef& snapshot);
+
+private:
+	PageUserData* fUserData;
+	PreviewCache::PreviewRef fSnapshot;
+};
+
+#endif // LAZY_TAB_VIEW_H
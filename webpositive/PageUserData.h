@@ -14,12 +14,21 @@
 
 
 #include <Bitmap.h>
+#include <Point.h>
 #include <String.h>
 #include <View.h>
 
+#include "LazyTabView.h"
+#include "PreviewCache.h"
 #include "WebView.h"
 
 
+// The user data of a tab belongs to the view the tab shows: its web view,
+// or the LazyTabView standing in for it while it is not loaded. BWebView
+// never deletes its user data, so BrowserWindow deletes it along with a web
+// view it shuts down, while a LazyTabView deletes its own. When a tab
+// changes from one to the other, LazyTabView::TakeOver() and HandOver()
+// move the user data, so it is only ever held by one of them.
 class PageUserData : public BWebView::UserData {
 public:
 	PageUserData(BView* focusedView)
@@ -35,7 +44,11 @@ public:
 		fHttpsUpgraded(false),
 		fIsLazy(false),
 		fIsDiscarded(false),
-		fPreview(NULL),
+		fRestoreScroll(false),
+		fLastActivation(0),
+		fHasDirtyForm(false),
+		fIsPlayingMedia(false),
+		fDomNodeCount(0),
 		fId(0)
 	{
 	}
@@ -44,7 +57,10 @@ public:
 	{
 		delete fPageIcon;
 		delete fPageIconLarge;
-		delete fPreview;
+		if (fId != 0) {
+			PreviewCache::Default().Remove(fId);
+			PreviewCache::Snapshots().Remove(fId);
+		}
 	}
 
 	void SetFocusedView(BView* focusedView)
@@ -218,18 +234,126 @@ public:
 		return fAllowedInsecureHost;
 	}
 
-	void SetPreview(const BBitmap* bitmap)
+	void SetPendingTitle(const BString& title)
+	{
+		fPendingTitle = title;
+	}
+
+	const BString& PendingTitle() const
+	{
+		return fPendingTitle;
+	}
+
+	void SetScrollPosition(BPoint position)
+	{
+		fScrollPosition = position;
+	}
+
+	BPoint ScrollPosition() const
+	{
+		return fScrollPosition;
+	}
+
+	void SetRestoreScroll(bool restore)
+	{
+		fRestoreScroll = restore;
+	}
+
+	bool RestoreScroll() const
+	{
+		return fRestoreScroll;
+	}
+
+	void SetLastActivation(bigtime_t when)
+	{
+		fLastActivation = when;
+	}
+
+	bigtime_t LastActivation() const
+	{
+		return fLastActivation;
+	}
+
+	void SetHasDirtyForm(bool dirty)
+	{
+		fHasDirtyForm = dirty;
+	}
+
+	bool HasDirtyForm() const
+	{
+		return fHasDirtyForm;
+	}
+
+	void SetIsPlayingMedia(bool playing)
+	{
+		fIsPlayingMedia = playing;
+	}
+
+	bool IsPlayingMedia() const
+	{
+		return fIsPlayingMedia;
+	}
+
+	void SetDomNodeCount(int32 count)
+	{
+		fDomNodeCount = count;
+	}
+
+	int32 DomNodeCount() const
+	{
+		return fDomNodeCount;
+	}
+
+	void SetPreview(BBitmap* bitmap)
+	{
+		// The preview is owned by the shared cache from now on.
+		if (fId != 0)
+			PreviewCache::Default().Put(fId, bitmap);
+		else
+			delete bitmap;
+	}
+
+	PreviewCache::PreviewRef Preview(uint32* generation = NULL) const
+	{
+		if (fId == 0) {
+			if (generation != NULL)
+				*generation = 0;
+			return PreviewCache::PreviewRef();
+		}
+		return PreviewCache::Default().Get(fId, generation);
+	}
+
+	void SetSnapshot(BBitmap* bitmap)
 	{
-		delete fPreview;
-		if (bitmap)
-			fPreview = new BBitmap(bitmap);
+		// Owned by the shared snapshot cache, like the preview; NULL
+		// removes it
+		if (fId == 0)
+			delete bitmap;
+		else if (bitmap == NULL)
+			PreviewCache::Snapshots().Remove(fId);
 		else
-			fPreview = NULL;
+			PreviewCache::Snapshots().Put(fId, bitmap);
+	}
+
+	PreviewCache::PreviewRef Snapshot() const
+	{
+		if (fId == 0)
+			return PreviewCache::PreviewRef();
+		return PreviewCache::Snapshots().Get(fId);
+	}
+
+	void FreezeSnapshot() const
+	{
+		// The snapshot is not drawn until the tab is selected again
+		if (fId != 0)
+			PreviewCache::Snapshots().Compress(fId);
 	}
 
-	const BBitmap* Preview() const
+	uint32 PreviewGeneration() const
 	{
-		return fPreview;
+		if (fId == 0)
+			return 0;
+		return PreviewCache::Default().GenerationFor(fId);
 	}
 
 	void SetId(uint32 id)
@@ -242,6 +366,9 @@ public:
 		return fId;
 	}
 
+	// The user data of the view a tab shows, loaded or not
+	static PageUserData* ForTabView(const BView* tabView);
+
 private:
 	BView*		fFocusedView;
 	BBitmap*	fPageIcon;
@@ -258,9 +385,32 @@ private:
 	bool		fIsLazy;
 	bool		fIsDiscarded;
 	BString		fAllowedInsecureHost;
-	BBitmap*	fPreview;
+	BString		fPendingTitle;
+	BPoint		fScrollPosition;
+	bool		fRestoreScroll;
+	bigtime_t	fLastActivation;
+	bool		fHasDirtyForm;
+	bool		fIsPlayingMedia;
+	int32		fDomNodeCount;
 	uint32		fId;
 };
 
 
+
+
+/*static*/ inline PageUserData*
+PageUserData::ForTabView(const BView* tabView)
+{
+	const BWebView* webView = dynamic_cast<const BWebView*>(tabView);
+	if (webView != NULL)
+		return static_cast<PageUserData*>(webView->GetUserData());
+
+	const LazyTabView* lazyView = dynamic_cast<const LazyTabView*>(tabView);
+	if (lazyView != NULL)
+		return lazyView->UserData();
+
+	return NULL;
+}
+
+
 #endif // PAGE_USER_DATA_H
@@ -50,6 +50,8 @@ const char* kSettingsKeyBlockAds = "block ads";
 const char* kSettingsKeyDisableCache = "disable cache";
 const char* kSettingsKeyLoadImages = "load images";
 const char* kSettingsKeyLowRAMMode = "low ram mode";
+const char* kSettingsKeyPreviewCacheBudget = "preview cache budget";
+const char* kSettingsKeyTabDiscardTarget = "tab discard target";
 const char* kSettingsKeyEnableGPU = "enable gpu";
 const char* kSettingsKeyEnableMSE = "enable mse";
 
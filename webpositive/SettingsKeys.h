@@ -49,6 +49,8 @@ extern const char* kSettingsKeyBlockAds;
 extern const char* kSettingsKeyDisableCache;
 extern const char* kSettingsKeyLoadImages;
 extern const char* kSettingsKeyLowRAMMode;
+extern const char* kSettingsKeyPreviewCacheBudget;
+extern const char* kSettingsKeyTabDiscardTarget;
 extern const char* kSettingsKeyEnableGPU;
 extern const char* kSettingsKeyEnableMSE;
 
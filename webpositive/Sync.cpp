@@ -51,7 +51,8 @@ Sync::ImportProfile(const BPath& folder,
 {
 	BPath bookmarksPath(folder);
 	bookmarksPath.Append("bookmarks.html");
-	BookmarkManager::ImportBookmarks(bookmarksPath);
+	// Merged, so importing the same profile again adds no duplicates
+	BookmarkManager::ImportBookmarks(bookmarksPath, BMessenger(), true);
 	// We ignore errors here as some files might be missing
 
 	BPath historyPath(folder);
@@ -8,45 +8,54 @@
 #include "BrowserWindow.h"
 
 #include <Application.h>
-#include <Autolock.h>
 #include <GroupLayoutBuilder.h>
 #include <ListView.h>
 #include <ScrollView.h>
 #include <TextControl.h>
 #include <StringItem.h>
 
-#include "TabManager.h"
+#include <new>
 
 enum {
 	MSG_SEARCH_TEXT_CHANGED = 'mstc',
+	MSG_SEARCH_INVOKED = 'msiv',
 	MSG_TAB_SELECTED = 'mtsl'
 };
 
 
 class TabListItem : public BStringItem {
 public:
-	TabListItem(const char* text, BView* view)
-		: BStringItem(text), fTabView(view) {}
+	TabListItem(const char* text, uint32 windowId, uint32 tabId)
+		: BStringItem(text), fWindowId(windowId), fTabId(tabId) {}
 
-	BView* View() const { return fTabView; }
+	uint32 WindowId() const { return fWindowId; }
+	uint32 TabId() const { return fTabId; }
 
 private:
-	BView* fTabView;
+	uint32 fWindowId;
+	uint32 fTabId;
 };
 
 
-TabSearchWindow::TabSearchWindow(TabManager* manager)
+static BString
+labelForTab(const TabSearchIndex::Tab& tab)
+{
+	return tab.title.Length() > 0 ? tab.title : tab.url;
+}
+
+
+TabSearchWindow::TabSearchWindow(const BMessenger& target, bool isPrivate)
 	:
 	BWindow(BRect(0, 0, 300, 400), "Search Tabs", B_TITLED_WINDOW,
 		B_NOT_ZOOMABLE | B_NOT_RESIZABLE | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
-	fTabManager(manager),
-	fTarget(manager->Target()),
+	fTarget(target),
+	fIsPrivate(isPrivate),
 	fForceQuit(false)
 {
 	CenterOnScreen();
 
 	fSearchControl = new BTextControl("search", "Search:", "",
-		new BMessage(MSG_SEARCH_TEXT_CHANGED));
+		new BMessage(MSG_SEARCH_INVOKED));
 	fSearchControl->SetModificationMessage(new BMessage(MSG_SEARCH_TEXT_CHANGED));
 
 	fTabList = new BListView("tabList");
@@ -59,7 +68,6 @@ TabSearchWindow::TabSearchWindow(TabManager* manager)
 		.SetInsets(10, 10, 10, 10)
 	);
 
-	_UpdateList();
 	fSearchControl->MakeFocus(true);
 }
 
@@ -76,26 +84,21 @@ TabSearchWindow::MessageReceived(BMessage* message)
 {
 	switch (message->what) {
 		case MSG_SEARCH_TEXT_CHANGED:
-			_FilterList();
+			_UpdateList();
+			break;
+
+		case MSG_SEARCH_INVOKED:
+			_SelectItem(0);
 			break;
 
 		case MSG_TAB_SELECTED:
-		{
-			int32 selection = fTabList->CurrentSelection();
-			if (selection >= 0) {
-				TabListItem* item = dynamic_cast<TabListItem*>(fTabList->ItemAt(selection));
-				if (item) {
-					BView* view = item->View();
-					if (fTarget.IsValid()) {
-						BMessage selectMsg(SELECT_TAB_BY_VIEW);
-						selectMsg.AddPointer("view", view);
-						fTarget.SendMessage(&selectMsg);
-						PostMessage(B_QUIT_REQUESTED);
-					}
-				}
-			}
+			_SelectItem(fTabList->CurrentSelection());
+			break;
+
+		case TAB_SEARCH_ENTRIES:
+			_AddWindowTabs(message);
+			_UpdateList();
 			break;
-		}
 
 		default:
 			BWindow::MessageReceived(message);
@@ -104,6 +107,17 @@ TabSearchWindow::MessageReceived(BMessage* message)
 }
 
 
+void
+TabSearchWindow::WindowActivated(bool active)
+{
+	BWindow::WindowActivated(active);
+
+	// The tabs may have changed while the window was hidden
+	if (active)
+		_RequestTabs();
+}
+
+
 bool
 TabSearchWindow::QuitRequested()
 {
@@ -127,55 +141,128 @@ TabSearchWindow::PrepareToQuit()
 
 
 void
-TabSearchWindow::SetTabManager(TabManager* manager)
+TabSearchWindow::_RequestTabs()
 {
-	fTabManager = manager;
+	// Forget the windows which have been closed since the last time; the
+	// others answer asynchronously, so a busy window never blocks the search.
+	std::map<uint32, BMessenger>::iterator it = fWindows.begin();
+	while (it != fWindows.end()) {
+		if (it->second.IsValid()) {
+			it++;
+			continue;
+		}
+		fIndex.RemoveWindow(it->first);
+		fWindows.erase(it++);
+	}
+	_UpdateList();
+
+	// Only windows of the same kind answer: the tabs of private windows
+	// are not found from normal ones, nor the other way around
+	BMessage request(COLLECT_TAB_SEARCH_ENTRIES);
+	request.AddMessenger("reply to", BMessenger(this));
+	request.AddBool("private", fIsPrivate);
+	be_app->PostMessage(&request);
 }
 
 
 void
-TabSearchWindow::_UpdateList()
+TabSearchWindow::_AddWindowTabs(const BMessage* message)
 {
-	for (int32 i = fTabList->CountItems() - 1; i >= 0; i--)
-		delete fTabList->RemoveItem(i);
-
-	if (!fTabManager) return;
-
-	BMessenger target = fTarget;
-	BLooper* looper;
-	target.Target(&looper);
-	// If we can't lock, we assume the window is busy or dead, so we skip updating
-	if (looper && looper->LockWithTimeout(100000) == B_OK) {
-		for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
-			BString label = fTabManager->TabLabel(i);
-			BView* view = fTabManager->ViewForTab(i);
-			fTabList->AddItem(new TabListItem(label.String(), view));
+	uint32 windowId = message->GetUInt32("window", 0);
+	BMessenger target;
+	if (message->FindMessenger("target", &target) != B_OK)
+		return;
+
+	std::vector<TabSearchIndex::Tab> tabs;
+	TabSearchIndex::Tab tab;
+	tab.windowId = windowId;
+	for (int32 i = 0; message->FindUInt32("tab", i, &tab.tabId) == B_OK;
+			i++) {
+		tab.title = message->GetString("title", i, "");
+		tab.url = message->GetString("url", i, "");
+		try {
+			tabs.push_back(tab);
+		} catch (...) {
+			break;
 		}
-		looper->Unlock();
 	}
+
+	fIndex.SetWindowTabs(windowId, tabs);
+	fWindows[windowId] = target;
 }
 
 
 void
-TabSearchWindow::_FilterList()
+TabSearchWindow::_UpdateList()
 {
-	if (!fTabManager) return;
-
-	BMessenger target = fTarget;
-	BLooper* looper;
-	target.Target(&looper);
-	if (looper && looper->LockWithTimeout(100000) == B_OK) {
-		BString filter = fSearchControl->Text();
-		for (int32 i = fTabList->CountItems() - 1; i >= 0; i--)
+	std::vector<TabSearchIndex::Match> matches
+		= fIndex.Search(fSearchControl->Text());
+
+	// Update the list in place rather than rebuilding it, so the list view
+	// only redraws the rows which actually changed and keeps its selection.
+	std::map<uint64, TabListItem*> items;
+	for (int32 i = 0; i < fTabList->CountItems(); i++) {
+		TabListItem* item = static_cast<TabListItem*>(fTabList->ItemAt(i));
+		items[(uint64)item->WindowId() << 32 | item->TabId()] = item;
+	}
+
+	std::map<uint64, bool> wanted;
+	for (size_t i = 0; i < matches.size(); i++) {
+		const TabSearchIndex::Tab& tab = fIndex.TabAt(matches[i].index);
+		wanted[(uint64)tab.windowId << 32 | tab.tabId] = true;
+	}
+
+	for (int32 i = fTabList->CountItems() - 1; i >= 0; i--) {
+		TabListItem* item = static_cast<TabListItem*>(fTabList->ItemAt(i));
+		uint64 key = (uint64)item->WindowId() << 32 | item->TabId();
+		if (wanted.find(key) == wanted.end()) {
+			items.erase(key);
 			delete fTabList->RemoveItem(i);
+		}
+	}
 
-		for (int32 i = 0; i < fTabManager->CountTabs(); i++) {
-			BString label = fTabManager->TabLabel(i);
-			BView* view = fTabManager->ViewForTab(i);
-			if (filter.Length() == 0 || label.IFindFirst(filter) >= 0) {
-				fTabList->AddItem(new TabListItem(label.String(), view));
+	for (size_t i = 0; i < matches.size(); i++) {
+		const TabSearchIndex::Tab& tab = fIndex.TabAt(matches[i].index);
+		uint64 key = (uint64)tab.windowId << 32 | tab.tabId;
+		BString label = labelForTab(tab);
+
+		std::map<uint64, TabListItem*>::iterator found = items.find(key);
+		if (found == items.end()) {
+			TabListItem* item = new(std::nothrow) TabListItem(label.String(),
+				tab.windowId, tab.tabId);
+			if (item == NULL || !fTabList->AddItem(item, i)) {
+				delete item;
+				break;
 			}
+			continue;
+		}
+
+		TabListItem* item = found->second;
+		int32 index = fTabList->IndexOf(item);
+		if (index != (int32)i)
+			fTabList->MoveItem(index, i);
+		if (label != item->Text()) {
+			item->SetText(label.String());
+			fTabList->InvalidateItem(i);
 		}
-		looper->Unlock();
 	}
 }
+
+
+void
+TabSearchWindow::_SelectItem(int32 index)
+{
+	TabListItem* item = dynamic_cast<TabListItem*>(fTabList->ItemAt(index));
+	if (item == NULL)
+		return;
+
+	std::map<uint32, BMessenger>::iterator window
+		= fWindows.find(item->WindowId());
+	if (window == fWindows.end() || !window->second.IsValid())
+		return;
+
+	BMessage selectMsg(SELECT_TAB_BY_VIEW);
+	selectMsg.AddUInt32("tab id", item->TabId());
+	window->second.SendMessage(&selectMsg);
+	PostMessage(B_QUIT_REQUESTED);
+}
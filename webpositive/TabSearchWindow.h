@@ -9,31 +9,40 @@
 #include <Messenger.h>
 #include <String.h>
 
+#include <map>
+
+#include "support/TabSearchIndex.h"
+
 class BListView;
 class BTextControl;
-class TabManager;
 
 class TabSearchWindow : public BWindow {
 public:
-								TabSearchWindow(TabManager* manager);
+								TabSearchWindow(const BMessenger& target,
+									bool isPrivate = false);
 	virtual						~TabSearchWindow();
 
 	virtual	void				MessageReceived(BMessage* message);
+	virtual	void				WindowActivated(bool active);
 	virtual	bool				QuitRequested();
 
-			void				SetTabManager(TabManager* manager);
 			void				PrepareToQuit();
 
 private:
+			void				_RequestTabs();
+			void				_AddWindowTabs(const BMessage* message);
 			void				_UpdateList();
-			void				_FilterList();
+			void				_SelectItem(int32 index);
 
 private:
-			TabManager*			fTabManager;
 			BMessenger			fTarget;
+			bool				fIsPrivate;
 			BTextControl*		fSearchControl;
 			BListView*			fTabList;
 			bool				fForceQuit;
+
+			TabSearchIndex		fIndex;
+			std::map<uint32, BMessenger> fWindows;
 };
 
 #endif // TAB_SEARCH_WINDOW_H
@@ -6,6 +6,7 @@
 #include "URLInputGroup.h"
 
 #include <Application.h>
+#include <Autolock.h>
 #include <Bitmap.h>
 #include <Button.h>
 #include <Catalog.h>
@@ -27,12 +28,14 @@
 #include <vector>
 #include <algorithm>
 
-#include "BaseURL.h"
+#include "BookmarkIndex.h"
 #include "BrowserWindow.h"
 #include "BrowsingHistory.h"
+#include "CompletionRanker.h"
 #include "IconButton.h"
 #include "PageUserData.h"
 #include "SettingsKeys.h"
+#include "TabManager.h"
 #include "IconUtils.h"
 #include "TextViewCompleter.h"
 #include "WebView.h"
@@ -74,9 +77,15 @@ private:
 };
 
 
-class BrowsingHistoryChoiceModel : public BAutoCompleter::ChoiceModel {
+class URLChoiceModel : public BAutoCompleter::ChoiceModel {
 public:
-	virtual ~BrowsingHistoryChoiceModel()
+	URLChoiceModel(BView* owner)
+		:
+		fOwner(owner)
+	{
+	}
+
+	virtual ~URLChoiceModel()
 	{
 		_ClearChoices();
 	}
@@ -85,61 +94,94 @@ public:
 	{
 		_ClearChoices();
 
-		// Search through BrowsingHistory for any matches.
+		// All sources are kept in memory, so typing does not wait for the
+		// disk no matter how many of them there are.
+		CompletionRanker ranker(pattern);
+		_AddHistory(ranker, pattern);
+		_AddBookmarks(ranker, pattern);
+		_AddOpenTabs(ranker);
+
+		std::vector<CompletionRanker::Candidate> candidates;
+		ranker.Rank(kMaxChoices, candidates);
+		for (size_t i = 0; i < candidates.size(); i++) {
+			const CompletionRanker::Candidate& candidate = candidates[i];
+			int32 matchPos = candidate.matchPos;
+			fChoices.push_back(new URLChoice(candidate.url, candidate.url,
+				std::max(matchPos, (int32)0),
+				matchPos >= 0 ? pattern.Length() : 0, candidate.score));
+		}
+	}
+
+	virtual int32 CountChoices() const
+	{
+		return (int32)fChoices.size();
+	}
+
+	virtual const BAutoCompleter::Choice* ChoiceAt(int32 index) const
+	{
+		return fChoices[index];
+	}
+
+private:
+	void _AddHistory(CompletionRanker& ranker, const BString& pattern)
+	{
 		BrowsingHistory* history = BrowsingHistory::DefaultInstance();
 		if (!history->Lock())
 			return;
 
-		BString lastBaseURL;
-		int32 priority = INT_MAX;
-
-		const int32 kMaxChoices = 50;
+		// Recently and often visited pages first
+		int32 added = 0;
 		int32 count = history->CountItems();
-		for (int32 i = count - 1; i >= 0; i--) {
+		for (int32 i = count - 1; i >= 0 && added < kMaxHistoryChoices; i--) {
 			const BrowsingHistoryItem* item = history->HistoryItemAt(i);
-			if (item == NULL)
-				continue;
-			const BString& choiceText = item->URL();
-			int32 matchPos = choiceText.IFindFirst(pattern);
-			if (matchPos < 0)
+			if (item == NULL || item->URL().IFindFirst(pattern) < 0)
 				continue;
-			if (lastBaseURL.Length() > 0
-				&& choiceText.FindFirst(lastBaseURL) >= 0) {
-				priority--;
-			} else
-				priority = INT_MAX;
-
-			// Optimized inline baseURL() to avoid memory allocation
-			baseURL(choiceText, lastBaseURL);
-
-			fChoices.push_back(new URLChoice(choiceText,
-				choiceText, matchPos, pattern.Length(), priority));
-
-			if ((int32)fChoices.size() >= kMaxChoices)
-				break;
+			int32 score = (kMaxHistoryChoices - added)
+				+ std::min(item->InvocationCount(), (uint32)20) * 5;
+			if (ranker.Add(CompletionRanker::kHistory, item->URL(), "",
+					score)) {
+				added++;
+			}
 		}
 
 		history->Unlock();
-
-		std::sort(fChoices.begin(), fChoices.end(), _CompareChoices);
 	}
 
-	virtual int32 CountChoices() const
+	void _AddBookmarks(CompletionRanker& ranker, const BString& pattern)
 	{
-		return (int32)fChoices.size();
-	}
+		BookmarkIndex* index = BookmarkIndex::Default();
+		if (index == NULL)
+			return;
 
-	virtual const BAutoCompleter::Choice* ChoiceAt(int32 index) const
-	{
-		return fChoices[index];
+		BAutolock _(index);
+		if (!index->IsSearchable())
+			return;
+
+		// The index matches the words of the pattern in any order, in the
+		// tags as well
+		std::vector<BookmarkIndex::Entry> bookmarks;
+		index->Search(pattern, kMaxBookmarkChoices, bookmarks);
+		for (size_t i = 0; i < bookmarks.size(); i++) {
+			ranker.Add(CompletionRanker::kBookmark, bookmarks[i].url,
+				bookmarks[i].title, kMaxBookmarkChoices - (int32)i, true);
+		}
 	}
 
-	static bool _CompareChoices(const URLChoice* a, const URLChoice* b)
+	void _AddOpenTabs(CompletionRanker& ranker)
 	{
-		return *a < *b;
+		BrowserWindow* window = dynamic_cast<BrowserWindow*>(fOwner->Window());
+		if (window == NULL || window->GetTabManager() == NULL)
+			return;
+
+		int32 count = window->GetTabManager()->CountTabs();
+		for (int32 i = 0; i < count; i++) {
+			BString url;
+			BString title;
+			window->GetTabPage(i, url, title);
+			ranker.Add(CompletionRanker::kOpenTab, url, title, 0);
+		}
 	}
 
-private:
 	void _ClearChoices()
 	{
 		for (size_t i = 0; i < fChoices.size(); i++)
@@ -148,6 +190,11 @@ private:
 	}
 
 private:
+	static const int32 kMaxChoices = 50;
+	static const int32 kMaxHistoryChoices = 50;
+	static const int32 kMaxBookmarkChoices = 20;
+
+	BView* fOwner;
 	std::vector<URLChoice*> fChoices;
 };
 
@@ -195,7 +242,7 @@ URLInputGroup::URLTextView::URLTextView(URLInputGroup* parent)
 	BTextView("url"),
 	fURLInputGroup(parent),
 	fURLAutoCompleter(new TextViewCompleter(this,
-		new BrowsingHistoryChoiceModel())),
+		new URLChoiceModel(this))),
 	fUpdateAutoCompleterChoices(true)
 {
 	MakeResizable(true);
@@ -0,0 +1,342 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "BookmarkBulkWriter.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <Message.h>
+#include <Node.h>
+#include <OS.h>
+
+#include <algorithm>
+
+#include "BaseURL.h"
+#include "BookmarkIndex.h"
+#include "BookmarkManager.h"
+
+
+static void
+fileName(const BString& baseName, int32 suffix, BString& name)
+{
+	// The " N" suffix for N > 0 always fits; the base name is shortened
+	// for it as needed, without cutting a UTF-8 character in two.
+	BString suffixText;
+	if (suffix > 0)
+		suffixText << " " << suffix;
+
+	int32 length = std::min(baseName.Length(),
+		(int32)B_FILE_NAME_LENGTH - 1 - suffixText.Length());
+	while (length > 0 && length < baseName.Length()
+		&& (baseName.ByteAt(length) & 0xc0) == 0x80) {
+		length--;
+	}
+	name.SetTo(baseName.String(), length);
+	name << suffixText;
+}
+
+
+BookmarkBulkWriter::BookmarkBulkWriter(const BMessenger& progressTarget,
+	bool merge)
+	:
+	fProgressTarget(progressTarget),
+	fMerge(merge),
+	fMergeStarted(false),
+	fMergeIndex(NULL),
+	fNextJob(0),
+	fCreated(0),
+	fSkipped(0),
+	fFailed(0),
+	fFirstError(B_OK)
+{
+}
+
+
+BookmarkBulkWriter::~BookmarkBulkWriter()
+{
+}
+
+
+status_t
+BookmarkBulkWriter::Add(const BPath& folder, const BString& title,
+	const BString& url)
+{
+	if (url.IsEmpty())
+		return B_BAD_VALUE;
+
+	BString folderPath(folder.Path());
+	Folder* state = _FolderFor(folderPath);
+	if (state == NULL)
+		return B_NO_MEMORY;
+
+	if (state->urls.find(url) != state->urls.end()) {
+		fSkipped++;
+		return B_OK;
+	}
+
+	BString key;
+	if (fMerge) {
+		duplicateURLKey(url, key);
+		if (_IsMerged(url, key)) {
+			fSkipped++;
+			return B_OK;
+		}
+	}
+
+	// Named like BookmarkManager::CreateBookmark() does it
+	BString baseName(title);
+	if (baseName.Length() == 0) {
+		baseName = url;
+		int32 leafPos = baseName.FindLast('/');
+		if (leafPos >= 0)
+			baseName.Remove(0, leafPos + 1);
+	}
+	baseName.ReplaceAll('/', '-');
+
+	BString name;
+	int32 tries = 0;
+	fileName(baseName, tries, name);
+	while (state->names.find(name) != state->names.end())
+		fileName(baseName, ++tries, name);
+
+	Job job;
+	job.folder = folderPath;
+	job.name = baseName;
+	job.suffix = tries;
+	job.title = title;
+	job.url = url;
+
+	try {
+		state->names.insert(name);
+		state->urls.insert(url);
+		if (fMerge)
+			fMergeURLs.insert(key);
+		fJobs.push_back(job);
+	} catch (...) {
+		return B_NO_MEMORY;
+	}
+
+	if ((int32)fJobs.size() >= kBatchSize)
+		_WriteJobs();
+	return B_OK;
+}
+
+
+status_t
+BookmarkBulkWriter::Flush()
+{
+	_WriteJobs();
+	_ReportProgress(true);
+
+	if (fCreated == 0 && fFailed > 0)
+		return fFirstError;
+	return B_OK;
+}
+
+
+BookmarkBulkWriter::Folder*
+BookmarkBulkWriter::_FolderFor(const BString& path)
+{
+	std::map<BString, Folder>::iterator it = fFolders.find(path);
+	if (it != fFolders.end())
+		return &it->second;
+
+	Folder* folder;
+	try {
+		folder = &fFolders[path];
+	} catch (...) {
+		return NULL;
+	}
+
+	// The URLs of existing bookmarks are looked up in the index, if it can
+	// tell, instead of reading the files.
+	BookmarkIndex* index = BookmarkIndex::Default();
+	if (index != NULL) {
+		BAutolock _(index);
+		if (!index->IsReady())
+			index = NULL;
+	}
+
+	std::vector<BString> files;
+	BDirectory directory(path.String());
+	BEntry entry;
+	char name[B_FILE_NAME_LENGTH];
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		if (entry.GetName(name) != B_OK)
+			continue;
+		folder->names.insert(name);
+		if (entry.IsDirectory())
+			continue;
+
+		if (index == NULL) {
+			BNode node(&entry);
+			BString url;
+			if (BookmarkManager::ReadURLAttr(node, url))
+				folder->urls.insert(url);
+		} else
+			files.push_back(name);
+	}
+
+	if (files.empty() || index == NULL)
+		return folder;
+
+	BAutolock _(index);
+	for (size_t i = 0; i < files.size(); i++) {
+		BString filePath(path);
+		filePath << "/" << files[i];
+		const BookmarkIndex::Entry* bookmark = index->FindPath(filePath);
+		if (bookmark != NULL && !bookmark->url.IsEmpty())
+			folder->urls.insert(bookmark->url);
+	}
+	return folder;
+}
+
+
+bool
+BookmarkBulkWriter::_IsMerged(const BString& url, const BString& key)
+{
+	if (!fMergeStarted) {
+		fMergeStarted = true;
+
+		BookmarkIndex* index = BookmarkIndex::Default();
+		if (index != NULL) {
+			BAutolock _(index);
+			if (index->IsReady())
+				fMergeIndex = index;
+		}
+
+		BPath path;
+		if (fMergeIndex == NULL
+			&& BookmarkManager::GetBookmarkPath(path) == B_OK) {
+			BDirectory directory(path.Path());
+			_CollectURLs(directory);
+		}
+	}
+
+	if (fMergeURLs.find(key) != fMergeURLs.end())
+		return true;
+	if (fMergeIndex == NULL)
+		return false;
+
+	BAutolock _(fMergeIndex);
+	return fMergeIndex->IsBookmarkedSimilar(url);
+}
+
+
+void
+BookmarkBulkWriter::_CollectURLs(BDirectory& directory)
+{
+	BEntry entry;
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		if (entry.IsDirectory()) {
+			BDirectory subDirectory(&entry);
+			_CollectURLs(subDirectory);
+			continue;
+		}
+
+		BNode node(&entry);
+		BString url;
+		if (!BookmarkManager::ReadURLAttr(node, url))
+			continue;
+
+		BString key;
+		duplicateURLKey(url, key);
+		try {
+			fMergeURLs.insert(key);
+		} catch (...) {
+			// Only means that duplicates of it are added
+		}
+	}
+}
+
+
+void
+BookmarkBulkWriter::_WriteJobs()
+{
+	if (fJobs.empty())
+		return;
+
+	fNextJob = 0;
+
+	thread_id threads[kWorkerCount];
+	int32 threadCount = 0;
+	int32 workers = std::min((int32)kWorkerCount,
+		(int32)(fJobs.size() + kProgressInterval - 1) / kProgressInterval);
+	for (int32 i = 0; i < workers; i++) {
+		thread_id thread = spawn_thread(_WorkerThread, "bookmark writer",
+			B_NORMAL_PRIORITY, this);
+		if (thread < 0)
+			break;
+		if (resume_thread(thread) != B_OK) {
+			kill_thread(thread);
+			break;
+		}
+		threads[threadCount++] = thread;
+	}
+
+	// Whatever the workers did not get to is done here
+	status_t status = _WorkerThread(this);
+	if (status != B_OK && fFirstError == B_OK)
+		fFirstError = status;
+
+	for (int32 i = 0; i < threadCount; i++) {
+		if (wait_for_thread(threads[i], &status) == B_OK && status != B_OK
+			&& fFirstError == B_OK) {
+			fFirstError = status;
+		}
+	}
+
+	fJobs.clear();
+}
+
+
+/*static*/ status_t
+BookmarkBulkWriter::_WorkerThread(void* data)
+{
+	BookmarkBulkWriter* writer = (BookmarkBulkWriter*)data;
+
+	status_t firstError = B_OK;
+	int32 count = (int32)writer->fJobs.size();
+	while (true) {
+		int32 index = atomic_add(&writer->fNextJob, 1);
+		if (index >= count)
+			break;
+
+		const Job& job = writer->fJobs[index];
+		status_t status = B_FILE_EXISTS;
+		for (int32 suffix = job.suffix; status == B_FILE_EXISTS
+				&& suffix <= job.suffix + kMaxNameRetries; suffix++) {
+			BString name;
+			fileName(job.name, suffix, name);
+			BString path(job.folder);
+			path << "/" << name;
+			status = BookmarkManager::WriteBookmarkFile(path.String(),
+				job.title, job.url);
+		}
+		if (status != B_OK) {
+			atomic_add(&writer->fFailed, 1);
+			if (firstError == B_OK)
+				firstError = status;
+			continue;
+		}
+
+		if ((atomic_add(&writer->fCreated, 1) + 1) % kProgressInterval == 0)
+			writer->_ReportProgress(false);
+	}
+	return firstError;
+}
+
+
+void
+BookmarkBulkWriter::_ReportProgress(bool finished)
+{
+	BMessage message(kMsgProgress);
+	message.AddInt32("created", atomic_get(&fCreated));
+	message.AddInt32("skipped", fSkipped);
+	message.AddInt32("failed", atomic_get(&fFailed));
+	message.AddBool("finished", finished);
+	fProgressTarget.SendMessage(&message);
+}
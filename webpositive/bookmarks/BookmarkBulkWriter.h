@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BOOKMARK_BULK_WRITER_H
+#define BOOKMARK_BULK_WRITER_H
+
+#include <Messenger.h>
+#include <Path.h>
+#include <String.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+class BDirectory;
+class BookmarkIndex;
+
+
+// Creates many bookmark files at once, for importing.
+//
+// Bookmarks are queued and written in batches. Before a batch is written,
+// bookmarks whose folder already holds one with the same URL (on disk or
+// earlier in the import) are dropped, and every remaining one is given a
+// unique file name. Each folder is listed only once for this; the URLs of
+// its bookmarks come from the bookmark index when it is ready. Since all
+// names are known in advance, the files are then created by a few worker
+// threads in parallel. An existing file is never replaced: if a name was
+// taken since its folder was listed, the next free " N" suffix is used.
+//
+// In merge mode, a bookmark is also dropped if one of the same page (its URL
+// differing only as duplicateURLKey() allows) exists anywhere in the bookmark folder
+// or came earlier in the import, so importing the same bookmarks again
+// adds nothing. Existing URLs are looked up in the index when it is ready;
+// otherwise the whole folder is walked once, before the first bookmark is
+// added.
+//
+// The number of bookmarks created so far is sent to the progress target
+// every now and then, and once more when done.
+class BookmarkBulkWriter {
+public:
+								BookmarkBulkWriter(
+									const BMessenger& progressTarget,
+									bool merge = false);
+								~BookmarkBulkWriter();
+
+			status_t			Add(const BPath& folder, const BString& title,
+									const BString& url);
+			status_t			Flush();
+
+			int32				CountCreated() const { return fCreated; }
+			int32				CountSkipped() const { return fSkipped; }
+			int32				CountFailed() const { return fFailed; }
+			status_t			FirstError() const { return fFirstError; }
+
+	static	const uint32		kMsgProgress = 'bbwp';
+	static	const int32			kWorkerCount = 4;
+	static	const int32			kBatchSize = 1000;
+	static	const int32			kProgressInterval = 250;
+	static	const int32			kMaxNameRetries = 100;
+
+private:
+			struct Job {
+				BString			folder;
+				BString			name;
+				int32			suffix;
+									// 0 for none
+				BString			title;
+				BString			url;
+			};
+
+			struct Folder {
+				std::set<BString> names;
+				std::set<BString> urls;
+			};
+
+			Folder*				_FolderFor(const BString& path);
+			bool				_IsMerged(const BString& url,
+									const BString& key);
+			void				_CollectURLs(BDirectory& directory);
+			void				_WriteJobs();
+	static	status_t			_WorkerThread(void* data);
+			void				_ReportProgress(bool finished);
+
+private:
+			BMessenger			fProgressTarget;
+			std::vector<Job>	fJobs;
+			std::map<BString, Folder> fFolders;
+
+			bool				fMerge;
+			bool				fMergeStarted;
+			BookmarkIndex*		fMergeIndex;
+			std::set<BString>	fMergeURLs;
+									// duplicate keys, of the whole folder
+									// if the index is not used
+
+			int32				fNextJob;
+			int32				fCreated;
+			int32				fSkipped;
+			int32				fFailed;
+			status_t			fFirstError;
+};
+
+#endif // BOOKMARK_BULK_WRITER_H
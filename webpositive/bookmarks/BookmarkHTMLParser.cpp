@@ -0,0 +1,408 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "BookmarkHTMLParser.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+struct NamedEntity {
+	const char*	name;
+	const char*	text;
+};
+
+static const NamedEntity kNamedEntities[] = {
+	{ "amp", "&" },
+	{ "lt", "<" },
+	{ "gt", ">" },
+	{ "quot", "\"" },
+	{ "apos", "'" },
+	{ "nbsp", "\xc2\xa0" }
+};
+
+
+static int32
+encodeUTF8(uint32 codePoint, char* buffer)
+{
+	if (codePoint < 0x80) {
+		buffer[0] = (char)codePoint;
+		return 1;
+	}
+	if (codePoint < 0x800) {
+		buffer[0] = (char)(0xc0 | (codePoint >> 6));
+		buffer[1] = (char)(0x80 | (codePoint & 0x3f));
+		return 2;
+	}
+	if (codePoint < 0x10000) {
+		buffer[0] = (char)(0xe0 | (codePoint >> 12));
+		buffer[1] = (char)(0x80 | ((codePoint >> 6) & 0x3f));
+		buffer[2] = (char)(0x80 | (codePoint & 0x3f));
+		return 3;
+	}
+	buffer[0] = (char)(0xf0 | (codePoint >> 18));
+	buffer[1] = (char)(0x80 | ((codePoint >> 12) & 0x3f));
+	buffer[2] = (char)(0x80 | ((codePoint >> 6) & 0x3f));
+	buffer[3] = (char)(0x80 | (codePoint & 0x3f));
+	return 4;
+}
+
+
+BookmarkHTMLParser::Listener::~Listener()
+{
+}
+
+
+// #pragma mark - Buffer
+
+
+void
+BookmarkHTMLParser::Buffer::Clear()
+{
+	length = 0;
+	overflow = false;
+}
+
+
+void
+BookmarkHTMLParser::Buffer::Append(char c)
+{
+	if (length < capacity)
+		data[length++] = c;
+	else
+		overflow = true;
+}
+
+
+void
+BookmarkHTMLParser::Buffer::Append(const char* text, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		Append(text[i]);
+}
+
+
+bool
+BookmarkHTMLParser::Buffer::Is(const char* text) const
+{
+	return !overflow && (int32)strlen(text) == length
+		&& strncasecmp(data, text, length) == 0;
+}
+
+
+// #pragma mark - BookmarkHTMLParser
+
+
+BookmarkHTMLParser::BookmarkHTMLParser(Listener* listener)
+	:
+	fListener(listener)
+{
+	fTagName.data = fTagNameData;
+	fTagName.capacity = sizeof(fTagNameData);
+	fAttributeName.data = fAttributeNameData;
+	fAttributeName.capacity = sizeof(fAttributeNameData);
+	fEntity.data = fEntityData;
+	fEntity.capacity = sizeof(fEntityData);
+	fText.data = fTextData;
+	fText.capacity = sizeof(fTextData);
+	fURL.data = fURLData;
+	fURL.capacity = sizeof(fURLData);
+
+	Reset();
+}
+
+
+void
+BookmarkHTMLParser::Feed(const char* data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+		_Process(data[i]);
+}
+
+
+void
+BookmarkHTMLParser::Reset()
+{
+	fState = kText;
+	fEntityReturnState = kText;
+	fCapture = kNone;
+	fClosingTag = false;
+	fCaptureValue = false;
+	fTagHasURL = false;
+	fQuote = 0;
+	fDashes = 0;
+
+	fTagName.Clear();
+	fAttributeName.Clear();
+	fEntity.Clear();
+	fText.Clear();
+	fURL.Clear();
+}
+
+
+void
+BookmarkHTMLParser::_Process(char c)
+{
+	switch (fState) {
+		case kText:
+			if (c == '<') {
+				fState = kTagOpen;
+				fClosingTag = false;
+				fTagHasURL = false;
+				fTagName.Clear();
+			} else if (c == '&' && fCapture != kNone) {
+				fEntityReturnState = kText;
+				fEntity.Clear();
+				fState = kEntity;
+			} else if (fCapture != kNone)
+				fText.Append(c);
+			break;
+
+		case kTagOpen:
+			if (c == '/' && !fClosingTag)
+				fClosingTag = true;
+			else if (c == '!' && !fClosingTag) {
+				fDashes = 0;
+				fState = kMarkup;
+			} else if (isalpha((unsigned char)c)) {
+				fTagName.Append(c);
+				fState = kTagName;
+			} else {
+				// Not a tag after all
+				_Append(kText, fClosingTag ? "</" : "<", fClosingTag ? 2 : 1);
+				fState = kText;
+				_Process(c);
+			}
+			break;
+
+		case kTagName:
+			if (isalnum((unsigned char)c))
+				fTagName.Append(c);
+			else if (c == '>')
+				_TagEnded();
+			else
+				fState = kAttributes;
+			break;
+
+		case kMarkup:
+			// A comment if it starts with "--", a declaration otherwise
+			if (c == '-' && fDashes >= 0) {
+				if (++fDashes == 2) {
+					fDashes = 0;
+					fState = kComment;
+				}
+			} else {
+				fDashes = -1;
+				if (c == '>')
+					fState = kText;
+			}
+			break;
+
+		case kComment:
+			if (c == '-')
+				fDashes++;
+			else {
+				if (c == '>' && fDashes >= 2)
+					fState = kText;
+				fDashes = 0;
+			}
+			break;
+
+		case kAttributes:
+			if (c == '>')
+				_TagEnded();
+			else if (!isspace((unsigned char)c) && c != '/') {
+				fAttributeName.Clear();
+				fAttributeName.Append(c);
+				fState = kAttributeName;
+			}
+			break;
+
+		case kAttributeName:
+			if (c == '=')
+				_ValueStarted();
+			else if (c == '>')
+				_TagEnded();
+			else if (isspace((unsigned char)c))
+				fState = kAfterAttributeName;
+			else
+				fAttributeName.Append(c);
+			break;
+
+		case kAfterAttributeName:
+			if (c == '=')
+				_ValueStarted();
+			else if (c == '>')
+				_TagEnded();
+			else if (!isspace((unsigned char)c)) {
+				fAttributeName.Clear();
+				fAttributeName.Append(c);
+				fState = kAttributeName;
+			}
+			break;
+
+		case kValueStart:
+			if (c == '"' || c == '\'') {
+				fQuote = c;
+				fState = kQuotedValue;
+			} else if (c == '>') {
+				fCaptureValue = false;
+				_TagEnded();
+			} else if (!isspace((unsigned char)c)) {
+				fState = kUnquotedValue;
+				_Process(c);
+			}
+			break;
+
+		case kQuotedValue:
+		case kUnquotedValue:
+		{
+			bool quoted = fState == kQuotedValue;
+			if ((quoted && c == fQuote)
+				|| (!quoted && (isspace((unsigned char)c) || c == '>'))) {
+				fCaptureValue = false;
+				fState = kAttributes;
+				if (c == '>')
+					_TagEnded();
+			} else if (c == '&') {
+				fEntityReturnState = fState;
+				fEntity.Clear();
+				fState = kEntity;
+			} else
+				_Append(fState, &c, 1);
+			break;
+		}
+
+		case kEntity:
+			_ProcessEntity(c);
+			break;
+	}
+}
+
+
+void
+BookmarkHTMLParser::_ProcessEntity(char c)
+{
+	State returnState = fEntityReturnState;
+
+	if (c != ';') {
+		if ((isalnum((unsigned char)c) || (c == '#' && fEntity.length == 0))
+			&& fEntity.length < fEntity.capacity) {
+			fEntity.Append(c);
+			return;
+		}
+
+		// Not a character reference, keep it as it is
+		_Append(returnState, "&", 1);
+		_Append(returnState, fEntity.data, fEntity.length);
+		fState = returnState;
+		_Process(c);
+		return;
+	}
+
+	fState = returnState;
+
+	char decoded[4];
+	int32 decodedLength = 0;
+	if (fEntity.length > 1 && fEntity.data[0] == '#') {
+		char number[sizeof(fEntityData) + 1];
+		memcpy(number, fEntity.data + 1, fEntity.length - 1);
+		number[fEntity.length - 1] = '\0';
+
+		bool hex = number[0] == 'x' || number[0] == 'X';
+		char* end;
+		unsigned long codePoint = strtoul(hex ? number + 1 : number, &end,
+			hex ? 16 : 10);
+		if (*end == '\0' && end != (hex ? number + 1 : number)
+			&& codePoint > 0 && codePoint <= 0x10ffff
+			&& (codePoint < 0xd800 || codePoint > 0xdfff)) {
+			decodedLength = encodeUTF8((uint32)codePoint, decoded);
+		}
+	} else {
+		for (size_t i = 0;
+				i < sizeof(kNamedEntities) / sizeof(kNamedEntities[0]); i++) {
+			if (fEntity.Is(kNamedEntities[i].name)) {
+				decodedLength = strlen(kNamedEntities[i].text);
+				memcpy(decoded, kNamedEntities[i].text, decodedLength);
+				break;
+			}
+		}
+	}
+
+	if (decodedLength > 0) {
+		_Append(returnState, decoded, decodedLength);
+		return;
+	}
+
+	_Append(returnState, "&", 1);
+	_Append(returnState, fEntity.data, fEntity.length);
+	_Append(returnState, ";", 1);
+}
+
+
+void
+BookmarkHTMLParser::_Append(State state, const char* text, int32 count)
+{
+	if (state == kText) {
+		if (fCapture != kNone)
+			fText.Append(text, count);
+	} else if (fCaptureValue)
+		fURL.Append(text, count);
+}
+
+
+void
+BookmarkHTMLParser::_ValueStarted()
+{
+	fState = kValueStart;
+	fCaptureValue = !fClosingTag && fTagName.Is("A")
+		&& fAttributeName.Is("HREF");
+	if (fCaptureValue) {
+		fURL.Clear();
+		fTagHasURL = true;
+	}
+}
+
+
+void
+BookmarkHTMLParser::_TagEnded()
+{
+	fState = kText;
+
+	if (fTagName.Is("DL")) {
+		if (fClosingTag)
+			fListener->ListEnded();
+		else
+			fListener->ListStarted();
+	} else if (fTagName.Is("H3")) {
+		if (!fClosingTag) {
+			fCapture = kFolderName;
+			fText.Clear();
+		} else if (fCapture == kFolderName) {
+			fCapture = kNone;
+			BString name;
+			name.SetTo(fText.data, fText.length);
+			fListener->FolderFound(name);
+		}
+	} else if (fTagName.Is("A")) {
+		if (!fClosingTag) {
+			// Links which are cut short are of no use
+			if (fTagHasURL && fURL.length > 0 && !fURL.overflow) {
+				fCapture = kLinkTitle;
+				fText.Clear();
+			} else
+				fCapture = kNone;
+		} else if (fCapture == kLinkTitle) {
+			fCapture = kNone;
+			BString url;
+			url.SetTo(fURL.data, fURL.length);
+			BString title;
+			title.SetTo(fText.data, fText.length);
+			fListener->BookmarkFound(url, title);
+		}
+	}
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BOOKMARK_HTML_PARSER_H
+#define BOOKMARK_HTML_PARSER_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+
+// Streaming reader of the Netscape bookmark file format, as exported by
+// about every browser.
+//
+// The input is fed in chunks of any size and scanned a single time, one
+// character after the other; tags, attributes and entities may span chunk
+// boundaries. Only the tag names, the HREF attribute of links and the text
+// of folder headings and links are kept, in buffers of fixed size, so huge
+// files (with embedded icons, for example) are read with constant memory.
+// Text and attribute values have their character references decoded.
+//
+// What is found is reported to a Listener: a folder heading (<H3>), the
+// start and end of a list (<DL>), which holds the contents of the folder
+// named right before it, and links (<A HREF>).
+class BookmarkHTMLParser {
+public:
+	class Listener {
+	public:
+		virtual					~Listener();
+
+		virtual	void			FolderFound(const BString& name) = 0;
+		virtual	void			ListStarted() = 0;
+		virtual	void			ListEnded() = 0;
+		virtual	void			BookmarkFound(const BString& url,
+									const BString& title) = 0;
+	};
+
+								BookmarkHTMLParser(Listener* listener);
+
+			void				Feed(const char* data, size_t length);
+			void				Reset();
+
+	static	const int32			kMaxTextLength = 4096;
+	static	const int32			kMaxURLLength = 16384;
+
+private:
+			enum State {
+				kText,
+				kTagOpen,
+				kTagName,
+				kMarkup,
+				kComment,
+				kAttributes,
+				kAttributeName,
+				kAfterAttributeName,
+				kValueStart,
+				kQuotedValue,
+				kUnquotedValue,
+				kEntity
+			};
+
+			enum Capture {
+				kNone,
+				kFolderName,
+				kLinkTitle
+			};
+
+			struct Buffer {
+				char*			data;
+				int32			capacity;
+				int32			length;
+				bool			overflow;
+
+				void			Clear();
+				void			Append(char c);
+				void			Append(const char* text, int32 count);
+				bool			Is(const char* text) const;
+			};
+
+			void				_Process(char c);
+			void				_ProcessEntity(char c);
+			void				_Append(State state, const char* text,
+									int32 count);
+			void				_ValueStarted();
+			void				_TagEnded();
+
+private:
+			Listener*			fListener;
+
+			State				fState;
+			State				fEntityReturnState;
+			Capture				fCapture;
+			bool				fClosingTag;
+			bool				fCaptureValue;
+			bool				fTagHasURL;
+			char				fQuote;
+			int32				fDashes;
+
+			char				fTagNameData[16];
+			char				fAttributeNameData[16];
+			char				fEntityData[12];
+			char				fTextData[kMaxTextLength];
+			char				fURLData[kMaxURLLength];
+
+			Buffer				fTagName;
+			Buffer				fAttributeName;
+			Buffer				fEntity;
+			Buffer				fText;
+			Buffer				fURL;
+};
+
+#endif // BOOKMARK_HTML_PARSER_H
@@ -0,0 +1,738 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "BookmarkIndex.h"
+
+#include <Entry.h>
+#include <File.h>
+#include <Message.h>
+#include <Path.h>
+
+#include <algorithm>
+#include <ctype.h>
+#include <iterator>
+#include <string.h>
+
+#include "BaseURL.h"
+
+
+static BookmarkIndex* sDefaultIndex = NULL;
+
+
+struct SearchResult {
+	const BookmarkIndex::Entry*	entry;
+	int32						score;
+};
+
+
+static bool
+betterResult(const SearchResult& a, const SearchResult& b)
+{
+	if (a.score != b.score)
+		return a.score > b.score;
+	return a.entry->title.ICompare(b.entry->title) < 0;
+}
+
+
+static bool
+smallerList(const std::vector<ino_t>& a, const std::vector<ino_t>& b)
+{
+	return a.size() < b.size();
+}
+
+
+static int32
+scoreWord(const BString& text, const char* word, int32 weight)
+{
+	int32 offset = text.IFindFirst(word);
+	if (offset < 0)
+		return 0;
+
+	// Prefer matches at the start of a word
+	if (offset == 0 || !isalnum((unsigned char)text.ByteAt(offset - 1)))
+		return weight * 2;
+	return weight;
+}
+
+
+// Drops the "scheme://" from URLs typed into a query. Bookmarks are not
+// indexed by their scheme (see _EntryTerms()), so it would match none.
+static BString
+withoutSchemes(const BString& query)
+{
+	BString result;
+	const char* text = query.String();
+	while (*text != '\0') {
+		if (text == query.String() || isspace((unsigned char)text[-1])) {
+			const char* end = text;
+			while (isalnum((unsigned char)*end) || *end == '+' || *end == '-'
+				|| *end == '.') {
+				end++;
+			}
+			if (end > text && strncmp(end, "://", 3) == 0) {
+				text = end + 3;
+				continue;
+			}
+		}
+		result += *text++;
+	}
+	return result;
+}
+
+
+BookmarkIndex::Entry::Entry()
+	:
+	node(0)
+{
+}
+
+
+BookmarkIndex::BookmarkIndex()
+	:
+	BLocker("bookmark index"),
+	fRescanning(false),
+	fReady(false),
+	fLoaded(false),
+	fGeneration(0)
+{
+}
+
+
+BookmarkIndex::~BookmarkIndex()
+{
+	if (sDefaultIndex == this)
+		sDefaultIndex = NULL;
+}
+
+
+/*static*/ BookmarkIndex*
+BookmarkIndex::Default()
+{
+	return sDefaultIndex;
+}
+
+
+/*static*/ void
+BookmarkIndex::SetDefault(BookmarkIndex* index)
+{
+	sDefaultIndex = index;
+}
+
+
+void
+BookmarkIndex::SetReady(bool ready)
+{
+	fReady = ready;
+	fGeneration++;
+}
+
+
+status_t
+BookmarkIndex::Put(ino_t node, const BString& path, const BString& title,
+	const BString& url, const BString& tags)
+{
+	if (fRescanning) {
+		try {
+			fRescanned.insert(node);
+		} catch (...) {
+			// At worst, the entry is dropped by FinishRescan() and added
+			// again on its next change
+		}
+	}
+
+	EntryMap::iterator it = fEntries.find(node);
+	if (it != fEntries.end()) {
+		if (it->second.path == path && it->second.title == title
+			&& it->second.url == url && it->second.tags == tags) {
+			return B_OK;
+		}
+		_Unlink(it->second);
+		fEntries.erase(it);
+	}
+
+	// Another file may have been replaced by this one
+	PathMap::iterator pathIt = fPaths.find(path);
+	if (pathIt != fPaths.end())
+		Remove(pathIt->second);
+
+	Entry entry;
+	entry.node = node;
+	entry.path = path;
+	entry.title = title;
+	entry.url = url;
+	entry.tags = tags;
+
+	try {
+		fEntries[node] = entry;
+	} catch (...) {
+		return B_NO_MEMORY;
+	}
+	if (!_Link(entry)) {
+		fEntries.erase(node);
+		return B_NO_MEMORY;
+	}
+
+	fGeneration++;
+	return B_OK;
+}
+
+
+void
+BookmarkIndex::Remove(ino_t node)
+{
+	EntryMap::iterator it = fEntries.find(node);
+	if (it == fEntries.end())
+		return;
+
+	_Unlink(it->second);
+	fEntries.erase(it);
+	fGeneration++;
+}
+
+
+void
+BookmarkIndex::RemovePath(const BString& path)
+{
+	std::vector<ino_t> nodes;
+	_CollectBelow(path, nodes);
+	PathMap::const_iterator it = fPaths.find(path);
+	if (it != fPaths.end())
+		nodes.push_back(it->second);
+
+	for (size_t i = 0; i < nodes.size(); i++)
+		Remove(nodes[i]);
+}
+
+
+void
+BookmarkIndex::MovePath(const BString& from, const BString& to)
+{
+	if (from == to)
+		return;
+
+	std::vector<ino_t> nodes;
+	_CollectBelow(from, nodes);
+	PathMap::const_iterator it = fPaths.find(from);
+	if (it != fPaths.end())
+		nodes.push_back(it->second);
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const Entry* entry = FindNode(nodes[i]);
+		if (entry == NULL)
+			continue;
+
+		BString path(to);
+		path << (entry->path.String() + from.Length());
+		Put(entry->node, path, BString(entry->title), BString(entry->url),
+			BString(entry->tags));
+	}
+}
+
+
+void
+BookmarkIndex::Clear()
+{
+	fEntries.clear();
+	fPaths.clear();
+	fURLs.clear();
+	fSimilarURLs.clear();
+	fTerms.clear();
+	fRescanned.clear();
+	fGeneration++;
+}
+
+
+const BookmarkIndex::Entry*
+BookmarkIndex::FindNode(ino_t node) const
+{
+	EntryMap::const_iterator it = fEntries.find(node);
+	if (it == fEntries.end())
+		return NULL;
+	return &it->second;
+}
+
+
+const BookmarkIndex::Entry*
+BookmarkIndex::FindPath(const BString& path) const
+{
+	PathMap::const_iterator it = fPaths.find(path);
+	if (it == fPaths.end())
+		return NULL;
+	return FindNode(it->second);
+}
+
+
+bool
+BookmarkIndex::IsBookmarked(const BString& url) const
+{
+	return !url.IsEmpty() && fURLs.find(url) != fURLs.end();
+}
+
+
+bool
+BookmarkIndex::IsBookmarkedSimilar(const BString& url) const
+{
+	if (url.IsEmpty())
+		return false;
+
+	BString key;
+	duplicateURLKey(url, key);
+	return fSimilarURLs.find(key) != fSimilarURLs.end();
+}
+
+
+bool
+BookmarkIndex::HasBookmark(const BString& path, const BString& url) const
+{
+	const Entry* entry = FindPath(path);
+	return entry != NULL && !url.IsEmpty() && entry->url == url;
+}
+
+
+int32
+BookmarkIndex::AddURLs(const BString& directoryPath, BMessage* message) const
+{
+	std::vector<ino_t> nodes;
+	_CollectBelow(directoryPath, nodes);
+
+	int32 added = 0;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const Entry* entry = FindNode(nodes[i]);
+		if (entry == NULL || entry->url.IsEmpty())
+			continue;
+		message->AddString("url", entry->url.String());
+		added++;
+	}
+	return added;
+}
+
+
+void
+BookmarkIndex::Search(const BString& query, int32 maxResults,
+	std::vector<Entry>& results) const
+{
+	results.clear();
+
+	BString terms(withoutSchemes(query));
+	std::vector<BString> words;
+	const char* text = terms.String();
+	while (*text != '\0') {
+		while (isspace((unsigned char)*text))
+			text++;
+		const char* start = text;
+		while (*text != '\0' && !isspace((unsigned char)*text))
+			text++;
+		if (text > start) {
+			BString word;
+			word.SetTo(start, text - start);
+			words.push_back(word);
+		}
+	}
+	if (words.empty() || maxResults <= 0)
+		return;
+
+	std::vector<ino_t> nodes;
+	if (Query(terms, nodes) != B_OK)
+		return;
+
+	// Every word has to be found in either the title, the tags or the URL.
+	// Titles and tags count for more, since that is what the user knows
+	// the bookmark by.
+	std::vector<SearchResult> matches;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const Entry* entry = FindNode(nodes[i]);
+		if (entry == NULL || entry->url.IsEmpty())
+			continue;
+
+		int32 score = 0;
+		for (size_t j = 0; j < words.size(); j++) {
+			int32 wordScore = std::max(scoreWord(entry->title, words[j], 2),
+				std::max(scoreWord(entry->tags, words[j], 2),
+					scoreWord(entry->url, words[j], 1)));
+			if (wordScore == 0) {
+				score = 0;
+				break;
+			}
+			score += wordScore;
+		}
+		if (score == 0)
+			continue;
+
+		SearchResult match;
+		match.entry = entry;
+		match.score = score;
+		matches.push_back(match);
+	}
+
+	size_t count = std::min(matches.size(), (size_t)maxResults);
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+		betterResult);
+
+	try {
+		for (size_t i = 0; i < count; i++)
+			results.push_back(*matches[i].entry);
+	} catch (...) {
+	}
+}
+
+
+status_t
+BookmarkIndex::Query(const BString& query, std::vector<ino_t>& nodes) const
+{
+	nodes.clear();
+
+	std::vector<BString> words;
+	SplitWords(withoutSchemes(query), words);
+	if (words.empty())
+		return B_BAD_VALUE;
+
+	try {
+		// Every word is the prefix of a word of the bookmark. The nodes
+		// matching each of them are intersected, smallest lists first.
+		std::vector<std::vector<ino_t> > lists(words.size());
+		for (size_t i = 0; i < words.size(); i++) {
+			_FindPrefix(words[i], lists[i]);
+			if (lists[i].empty())
+				return B_OK;
+		}
+		std::sort(lists.begin(), lists.end(), smallerList);
+
+		nodes.swap(lists[0]);
+		std::vector<ino_t> both;
+		for (size_t i = 1; i < lists.size() && !nodes.empty(); i++) {
+			both.clear();
+			std::set_intersection(nodes.begin(), nodes.end(),
+				lists[i].begin(), lists[i].end(), std::back_inserter(both));
+			nodes.swap(both);
+		}
+	} catch (...) {
+		nodes.clear();
+		return B_NO_MEMORY;
+	}
+	return B_OK;
+}
+
+
+void
+BookmarkIndex::StartRescan()
+{
+	fRescanning = true;
+	fRescanned.clear();
+}
+
+
+void
+BookmarkIndex::FinishRescan()
+{
+	if (!fRescanning)
+		return;
+
+	// Whatever was not seen again is gone since the index was saved
+	std::vector<ino_t> stale;
+	for (EntryMap::const_iterator it = fEntries.begin(); it != fEntries.end();
+			++it) {
+		if (fRescanned.find(it->first) == fRescanned.end())
+			stale.push_back(it->first);
+	}
+	for (size_t i = 0; i < stale.size(); i++)
+		Remove(stale[i]);
+
+	fRescanning = false;
+	fRescanned.clear();
+}
+
+
+bool
+BookmarkIndex::IsRescanned(ino_t node) const
+{
+	return fRescanning && fRescanned.find(node) != fRescanned.end();
+}
+
+
+status_t
+BookmarkIndex::Archive(BMessage& archive) const
+{
+	for (EntryMap::const_iterator it = fEntries.begin(); it != fEntries.end();
+			++it) {
+		const Entry& entry = it->second;
+		status_t status = archive.AddInt64("node", entry.node);
+		if (status == B_OK)
+			status = archive.AddString("path", entry.path);
+		if (status == B_OK)
+			status = archive.AddString("title", entry.title);
+		if (status == B_OK)
+			status = archive.AddString("url", entry.url);
+		if (status == B_OK)
+			status = archive.AddString("tags", entry.tags);
+		if (status != B_OK)
+			return status;
+	}
+	return B_OK;
+}
+
+
+status_t
+BookmarkIndex::Unarchive(const BMessage& archive)
+{
+	Clear();
+
+	int64 node;
+	for (int32 i = 0; archive.FindInt64("node", i, &node) == B_OK; i++) {
+		BString path;
+		BString title;
+		BString url;
+		BString tags;
+		if (archive.FindString("path", i, &path) != B_OK
+			|| archive.FindString("title", i, &title) != B_OK
+			|| archive.FindString("url", i, &url) != B_OK
+			|| archive.FindString("tags", i, &tags) != B_OK) {
+			Clear();
+			return B_BAD_DATA;
+		}
+
+		status_t status = Put((ino_t)node, path, title, url, tags);
+		if (status != B_OK) {
+			Clear();
+			return status;
+		}
+	}
+
+	fLoaded = true;
+	fGeneration++;
+	return B_OK;
+}
+
+
+status_t
+BookmarkIndex::Save(const char* path) const
+{
+	BMessage archive;
+	status_t status = Archive(archive);
+	if (status != B_OK)
+		return status;
+
+	// Written next to the old one and moved over it, so a crash leaves
+	// either of them
+	BString tempPath(path);
+	tempPath << ".new";
+	BFile file(tempPath.String(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status = file.InitCheck();
+	if (status == B_OK)
+		status = archive.Flatten(&file);
+	if (status == B_OK)
+		status = file.Sync();
+	file.Unset();
+
+	BEntry entry(tempPath.String());
+	if (status == B_OK)
+		status = entry.Rename(BPath(path).Leaf(), true);
+	if (status != B_OK)
+		entry.Remove();
+	return status;
+}
+
+
+status_t
+BookmarkIndex::Load(const char* path)
+{
+	BFile file(path, B_READ_ONLY);
+	status_t status = file.InitCheck();
+	if (status != B_OK)
+		return status;
+
+	BMessage archive;
+	status = archive.Unflatten(&file);
+	if (status != B_OK)
+		return status;
+
+	return Unarchive(archive);
+}
+
+
+/*static*/ void
+BookmarkIndex::SplitWords(const BString& text, std::vector<BString>& words)
+{
+	// Words are runs of letters and digits; anything beyond ASCII counts
+	// as a letter, so UTF-8 text is kept together.
+	const char* c = text.String();
+	while (*c != '\0') {
+		while (*c != '\0' && (unsigned char)*c < 0x80
+			&& !isalnum((unsigned char)*c)) {
+			c++;
+		}
+		const char* start = c;
+		while (*c != '\0' && ((unsigned char)*c >= 0x80
+			|| isalnum((unsigned char)*c))) {
+			c++;
+		}
+		if (c > start) {
+			BString word;
+			word.SetTo(start, c - start);
+			word.ToLower();
+			words.push_back(word);
+		}
+	}
+}
+
+
+size_t
+BookmarkIndex::URLHash::operator()(const BString& url) const
+{
+	// FNV-1a
+	size_t hash = 2166136261U;
+	for (const char* c = url.String(); *c != '\0'; c++) {
+		hash ^= (unsigned char)*c;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+void
+BookmarkIndex::_Unlink(const Entry& entry)
+{
+	PathMap::iterator pathIt = fPaths.find(entry.path);
+	if (pathIt != fPaths.end() && pathIt->second == entry.node)
+		fPaths.erase(pathIt);
+
+	_RemoveTerms(entry);
+
+	if (entry.url.IsEmpty())
+		return;
+
+	URLMap::iterator urlIt = fURLs.find(entry.url);
+	if (urlIt != fURLs.end() && --urlIt->second <= 0)
+		fURLs.erase(urlIt);
+
+	BString key;
+	duplicateURLKey(entry.url, key);
+	urlIt = fSimilarURLs.find(key);
+	if (urlIt != fSimilarURLs.end() && --urlIt->second <= 0)
+		fSimilarURLs.erase(urlIt);
+}
+
+
+bool
+BookmarkIndex::_Link(const Entry& entry)
+{
+	bool counted = false;
+	try {
+		fPaths[entry.path] = entry.node;
+
+		std::vector<BString> terms;
+		_EntryTerms(entry, terms);
+		for (size_t i = 0; i < terms.size(); i++) {
+			std::vector<ino_t>& nodes = fTerms[terms[i]];
+			nodes.insert(std::lower_bound(nodes.begin(), nodes.end(),
+				entry.node), entry.node);
+		}
+
+		if (!entry.url.IsEmpty()) {
+			BString key;
+			duplicateURLKey(entry.url, key);
+			fURLs[entry.url]++;
+			counted = true;
+			fSimilarURLs[key]++;
+		}
+	} catch (...) {
+		fPaths.erase(entry.path);
+		_RemoveTerms(entry);
+		if (counted) {
+			URLMap::iterator urlIt = fURLs.find(entry.url);
+			if (--urlIt->second <= 0)
+				fURLs.erase(urlIt);
+		}
+		return false;
+	}
+	return true;
+}
+
+
+void
+BookmarkIndex::_RemoveTerms(const Entry& entry)
+{
+	std::vector<BString> terms;
+	try {
+		_EntryTerms(entry, terms);
+	} catch (...) {
+		// Look through all of them instead
+		for (TermMap::iterator it = fTerms.begin(); it != fTerms.end();) {
+			std::vector<ino_t>& nodes = it->second;
+			nodes.erase(std::remove(nodes.begin(), nodes.end(), entry.node),
+				nodes.end());
+			if (nodes.empty())
+				fTerms.erase(it++);
+			else
+				++it;
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < terms.size(); i++) {
+		TermMap::iterator it = fTerms.find(terms[i]);
+		if (it == fTerms.end())
+			continue;
+
+		std::vector<ino_t>& nodes = it->second;
+		std::vector<ino_t>::iterator node = std::lower_bound(nodes.begin(),
+			nodes.end(), entry.node);
+		if (node != nodes.end() && *node == entry.node)
+			nodes.erase(node);
+		if (nodes.empty())
+			fTerms.erase(it);
+	}
+}
+
+
+void
+BookmarkIndex::_EntryTerms(const Entry& entry,
+	std::vector<BString>& terms) const
+{
+	SplitWords(entry.title, terms);
+	SplitWords(entry.tags, terms);
+
+	// The scheme is part of about every URL, and would match them all
+	const char* url = entry.url.String();
+	const char* scheme = strstr(url, "://");
+	SplitWords(BString(scheme != NULL ? scheme + 3 : url), terms);
+
+	std::sort(terms.begin(), terms.end());
+	terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+}
+
+
+void
+BookmarkIndex::_FindPrefix(const BString& prefix,
+	std::vector<ino_t>& nodes) const
+{
+	// Words sort by their prefix, so all that start with it are one range
+	for (TermMap::const_iterator it = fTerms.lower_bound(prefix);
+			it != fTerms.end(); ++it) {
+		if (it->first.Compare(prefix.String(), prefix.Length()) != 0)
+			break;
+		nodes.insert(nodes.end(), it->second.begin(), it->second.end());
+	}
+
+	std::sort(nodes.begin(), nodes.end());
+	nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+}
+
+
+void
+BookmarkIndex::_CollectBelow(const BString& path,
+	std::vector<ino_t>& nodes) const
+{
+	// Paths sort by their prefix, so everything below a folder is one range
+	BString prefix(path);
+	if (prefix.Length() == 0 || prefix.ByteAt(prefix.Length() - 1) != '/')
+		prefix << "/";
+
+	for (PathMap::const_iterator it = fPaths.lower_bound(prefix);
+			it != fPaths.end(); ++it) {
+		if (it->first.Compare(prefix.String(), prefix.Length()) != 0)
+			break;
+		nodes.push_back(it->second);
+	}
+}
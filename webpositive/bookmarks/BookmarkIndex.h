@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BOOKMARK_INDEX_H
+#define BOOKMARK_INDEX_H
+
+#include <Locker.h>
+#include <String.h>
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class BMessage;
+
+
+// In-memory copy of the bookmark folder: path, title and URL of every file
+// in it, keyed by inode.
+//
+// The index is filled in the background when the application starts and
+// then kept current by the BookmarkMonitor, so finding out whether a URL is
+// bookmarked, or what is bookmarked below a folder, needs no disk access.
+// Until it is ready, callers are expected to go to the filesystem instead.
+//
+// Besides the exact URLs, the index counts them with the case of their host
+// name and trailing slashes folded (see duplicateURLKey()), so a bookmark of
+// the same page anywhere in the folder can be found as a duplicate. Other
+// schemes or fragments make a different page; hash routed web applications
+// rely on the latter.
+//
+// Files without a URL are kept as well, so a later change of their
+// attributes can be applied without looking them up again.
+//
+// The words of the titles, URLs and tags (the "META:keyw" attribute) are
+// kept in an inverted index as well, so a query for a few word prefixes is
+// answered by intersecting short lists, without looking at the other
+// bookmarks. The index can be saved next to the bookmark folder and loaded
+// again on the next start, so it can be searched before the folder has
+// been walked again; it only counts as ready once that is done.
+//
+// Should Lock() the object when calling any of its methods.
+class BookmarkIndex : public BLocker {
+public:
+	struct Entry {
+									Entry();
+
+				ino_t				node;
+				BString				path;
+				BString				title;
+				BString				url;
+				BString				tags;
+	};
+
+								BookmarkIndex();
+								~BookmarkIndex();
+
+	static	BookmarkIndex*		Default();
+	static	void				SetDefault(BookmarkIndex* index);
+
+			bool				IsReady() const { return fReady; }
+			void				SetReady(bool ready);
+			bool				IsSearchable() const
+									{ return fReady || fLoaded; }
+
+			status_t			Put(ino_t node, const BString& path,
+									const BString& title, const BString& url,
+									const BString& tags = BString());
+			void				Remove(ino_t node);
+			void				RemovePath(const BString& path);
+			void				MovePath(const BString& from,
+									const BString& to);
+			void				Clear();
+
+			int32				CountEntries() const
+									{ return (int32)fEntries.size(); }
+			const Entry*		FindNode(ino_t node) const;
+			const Entry*		FindPath(const BString& path) const;
+
+			bool				IsBookmarked(const BString& url) const;
+			bool				IsBookmarkedSimilar(const BString& url)
+									const;
+			bool				HasBookmark(const BString& path,
+									const BString& url) const;
+			int32				AddURLs(const BString& directoryPath,
+									BMessage* message) const;
+			void				Search(const BString& query, int32 maxResults,
+									std::vector<Entry>& results) const;
+			status_t			Query(const BString& query,
+									std::vector<ino_t>& nodes) const;
+
+			void				StartRescan();
+			void				FinishRescan();
+			bool				IsRescanned(ino_t node) const;
+
+			status_t			Archive(BMessage& archive) const;
+			status_t			Unarchive(const BMessage& archive);
+			status_t			Save(const char* path) const;
+			status_t			Load(const char* path);
+
+			uint32				Generation() const { return fGeneration; }
+
+	static	void				SplitWords(const BString& text,
+									std::vector<BString>& words);
+
+private:
+			struct URLHash {
+				size_t			operator()(const BString& url) const;
+			};
+
+			typedef std::map<ino_t, Entry> EntryMap;
+			typedef std::map<BString, ino_t> PathMap;
+			typedef std::unordered_map<BString, int32, URLHash> URLMap;
+			typedef std::map<BString, std::vector<ino_t> > TermMap;
+
+			void				_Unlink(const Entry& entry);
+			bool				_Link(const Entry& entry);
+			void				_RemoveTerms(const Entry& entry);
+			void				_EntryTerms(const Entry& entry,
+									std::vector<BString>& terms) const;
+			void				_FindPrefix(const BString& prefix,
+									std::vector<ino_t>& nodes) const;
+			void				_CollectBelow(const BString& path,
+									std::vector<ino_t>& nodes) const;
+
+private:
+			EntryMap			fEntries;
+			PathMap				fPaths;
+			URLMap				fURLs;
+									// number of entries with each URL
+			URLMap				fSimilarURLs;
+									// same, by duplicateURLKey()
+			TermMap				fTerms;
+									// sorted nodes of the entries with
+									// each word
+			std::set<ino_t>		fRescanned;
+			bool				fRescanning;
+			bool				fReady;
+			bool				fLoaded;
+			uint32				fGeneration;
+};
+
+#endif // BOOKMARK_INDEX_H
@@ -6,6 +6,7 @@
 #include "BookmarkManager.h"
 
 #include <Alert.h>
+#include <Autolock.h>
 #include <Catalog.h>
 #include <Entry.h>
 #include <File.h>
@@ -14,20 +15,314 @@
 #include <Locale.h>
 #include <Message.h>
 #include <NodeInfo.h>
-#include <Query.h>
 #include <Roster.h>
-#include <Volume.h>
 #include <stdio.h>
+#include <string.h>
 #include <strings.h>
 
+#include <algorithm>
+#include <new>
 #include <vector>
 
+#include "BookmarkBulkWriter.h"
+#include "BookmarkHTMLParser.h"
+#include "BookmarkIndex.h"
 #include "../support/SafeStrerror.h"
 #include "../support/WebConstants.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "WebPositive Window"
 
+
+static const size_t kImportBufferSize = 64 * 1024;
+static const size_t kExportBufferSize = 256 * 1024;
+static const int32 kExportIndentWidth = 4;
+
+
+// Creates the folders found in an imported bookmark file right away, and
+// hands the bookmarks to a writer which creates them in batches.
+class BookmarkImporter : public BookmarkHTMLParser::Listener {
+public:
+	BookmarkImporter(const BPath& root, BookmarkBulkWriter& writer)
+		:
+		fWriter(writer),
+		fHasPendingFolder(false)
+	{
+		fFolders.push_back(root);
+	}
+
+	virtual void FolderFound(const BString& name)
+	{
+		BString folderName(name);
+		folderName.ReplaceAll('/', '-');
+		folderName.Truncate(B_FILE_NAME_LENGTH - 1);
+		// These would put the folder and its bookmarks somewhere else
+		if (folderName.Length() == 0 || folderName == "." || folderName == "..")
+			folderName = B_TRANSLATE("Untitled folder");
+
+		// The folder is created right away, so it exists even if it has
+		// no list of contents following it.
+		fHasPendingFolder = false;
+		BPath path(fFolders.back());
+		if (path.Append(folderName) == B_OK
+			&& create_directory(path.Path(), 0777) == B_OK) {
+			fPendingFolder = path;
+			fHasPendingFolder = true;
+		}
+	}
+
+	virtual void ListStarted()
+	{
+		// Lists that do not follow a folder name belong to the current
+		// folder, they are kept on the stack so their ends match up.
+		fFolders.push_back(fHasPendingFolder ? fPendingFolder : fFolders.back());
+		fHasPendingFolder = false;
+	}
+
+	virtual void ListEnded()
+	{
+		if (fFolders.size() > 1)
+			fFolders.pop_back();
+		fHasPendingFolder = false;
+	}
+
+	virtual void BookmarkFound(const BString& url, const BString& title)
+	{
+		fHasPendingFolder = false;
+		fWriter.Add(fFolders.back(), title, url);
+	}
+
+private:
+	BookmarkBulkWriter&	fWriter;
+	std::vector<BPath>	fFolders;
+	BPath				fPendingFolder;
+	bool				fHasPendingFolder;
+};
+
+
+// Writes the bookmark folder out as a Netscape bookmark file.
+//
+// The output is collected in one large buffer, which is written whenever it
+// is full, so exporting takes a few large writes instead of several per
+// bookmark. Each folder is listed once; the titles and URLs of the bookmarks
+// in it come from the bookmark index when it is ready, and from the files
+// only otherwise.
+class BookmarkExporter {
+public:
+	BookmarkExporter(BFile& file)
+		:
+		fFile(file),
+		fBuffer(new(std::nothrow) char[kExportBufferSize]),
+		fLength(0),
+		fStatus(fBuffer != NULL ? B_OK : B_NO_MEMORY)
+	{
+	}
+
+	~BookmarkExporter()
+	{
+		delete[] fBuffer;
+	}
+
+	status_t Export(const BPath& root)
+	{
+		_Append("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+			"<!-- This is an automatically generated file.\n"
+			"     It will be read and overwritten.\n"
+			"     DO NOT EDIT! -->\n"
+			"<META HTTP-EQUIV=\"Content-Type\" CONTENT=\"text/html; "
+				"charset=UTF-8\">\n"
+			"<TITLE>Bookmarks</TITLE>\n"
+			"<H1>Bookmarks</H1>\n"
+			"<DL><p>\n");
+
+		_ExportDirectory(BString(root.Path()), 1);
+
+		_Append("</DL><p>\n");
+		_Flush();
+		return fStatus;
+	}
+
+private:
+	struct Item {
+		BString	name;
+		bool	isDirectory;
+		bool	hasURL;
+		BString	title;
+		BString	url;
+	};
+
+	void _ExportDirectory(const BString& path, int32 indentLevel)
+	{
+		BookmarkIndex* index = BookmarkIndex::Default();
+		if (index != NULL) {
+			BAutolock _(index);
+			if (!index->IsReady())
+				index = NULL;
+		}
+
+		std::vector<Item> items;
+		try {
+			BDirectory directory(path.String());
+			BEntry entry;
+			char name[B_FILE_NAME_LENGTH];
+			while (directory.GetNextEntry(&entry) == B_OK) {
+				if (entry.GetName(name) != B_OK)
+					continue;
+
+				Item item;
+				item.name = name;
+				item.isDirectory = entry.IsDirectory();
+				item.hasURL = false;
+				if (!item.isDirectory && index == NULL) {
+					BNode node(&entry);
+					item.hasURL = _ReadBookmark(node, item);
+				}
+				items.push_back(item);
+			}
+		} catch (...) {
+			fStatus = B_NO_MEMORY;
+			return;
+		}
+
+		if (index != NULL) {
+			BAutolock _(index);
+			for (size_t i = 0; i < items.size(); i++) {
+				Item& item = items[i];
+				if (item.isDirectory)
+					continue;
+
+				BString filePath(path);
+				filePath << "/" << item.name;
+				const BookmarkIndex::Entry* bookmark = index->FindPath(filePath);
+				if (bookmark != NULL) {
+					item.url = bookmark->url;
+					item.title = bookmark->title;
+					item.hasURL = !item.url.IsEmpty();
+				} else {
+					// Not indexed yet, it was just added
+					BNode node(filePath.String());
+					item.hasURL = _ReadBookmark(node, item);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < items.size() && fStatus == B_OK; i++) {
+			const Item& item = items[i];
+			if (item.isDirectory) {
+				_AppendIndent(indentLevel);
+				_Append("<DT><H3>");
+				_AppendEscaped(item.name);
+				_Append("</H3>\n");
+				_AppendIndent(indentLevel);
+				_Append("<DL><p>\n");
+
+				BString subPath(path);
+				subPath << "/" << item.name;
+				_ExportDirectory(subPath, indentLevel + 1);
+
+				_AppendIndent(indentLevel);
+				_Append("</DL><p>\n");
+			} else if (item.hasURL) {
+				_AppendIndent(indentLevel);
+				_Append("<DT><A HREF=\"");
+				_Append(item.url.String(), item.url.Length());
+				_Append("\">");
+				_AppendEscaped(item.title.IsEmpty() ? item.name : item.title);
+				_Append("</A>\n");
+			}
+		}
+	}
+
+	bool _ReadBookmark(BNode& node, Item& item)
+	{
+		if (!BookmarkManager::ReadURLAttr(node, item.url))
+			return false;
+		if (node.ReadAttrString("META:title", &item.title) != B_OK)
+			item.title = "";
+		return true;
+	}
+
+	void _Append(const char* text)
+	{
+		_Append(text, strlen(text));
+	}
+
+	void _Append(const char* text, size_t length)
+	{
+		if (fStatus != B_OK)
+			return;
+
+		while (length > 0) {
+			if (fLength == kExportBufferSize && _Flush() != B_OK)
+				return;
+
+			size_t count = std::min(length, kExportBufferSize - fLength);
+			memcpy(fBuffer + fLength, text, count);
+			fLength += count;
+			text += count;
+			length -= count;
+		}
+	}
+
+	void _AppendIndent(int32 indentLevel)
+	{
+		static const char kSpaces[] = "                                ";
+		size_t length = indentLevel * kExportIndentWidth;
+		while (length > 0) {
+			size_t count = std::min(length, sizeof(kSpaces) - 1);
+			_Append(kSpaces, count);
+			length -= count;
+		}
+	}
+
+	void _AppendEscaped(const BString& text)
+	{
+		const char* start = text.String();
+		const char* end = start + text.Length();
+		for (const char* c = start; c < end; c++) {
+			const char* entity;
+			switch (*c) {
+				case '&':
+					entity = "&amp;";
+					break;
+				case '<':
+					entity = "&lt;";
+					break;
+				case '>':
+					entity = "&gt;";
+					break;
+				default:
+					continue;
+			}
+			_Append(start, c - start);
+			_Append(entity);
+			start = c + 1;
+		}
+		_Append(start, end - start);
+	}
+
+	status_t _Flush()
+	{
+		if (fStatus != B_OK || fLength == 0)
+			return fStatus;
+
+		ssize_t written = fFile.Write(fBuffer, fLength);
+		if (written < 0)
+			fStatus = written;
+		else if ((size_t)written != fLength)
+			fStatus = B_IO_ERROR;
+		fLength = 0;
+		return fStatus;
+	}
+
+private:
+	BFile&				fFile;
+	char*				fBuffer;
+	size_t				fLength;
+	status_t			fStatus;
+};
+
+
 /*static*/ status_t
 BookmarkManager::GetBookmarkPath(BPath& path)
 {
@@ -137,14 +432,10 @@ BookmarkManager::_CreateBookmark(const BPath& path, BString fileName, const BStr
 
 	// Write bookmark meta data
 	if (status == B_OK)
-		status = bookmarkFile.WriteAttrString("META:url", &url);
-	if (status == B_OK) {
-		bookmarkFile.WriteAttrString("META:title", &title);
-	}
+		status = _WriteBookmarkAttributes(bookmarkFile, title, url);
 
 	BNodeInfo nodeInfo(&bookmarkFile);
 	if (status == B_OK) {
-		status = nodeInfo.SetType("application/x-vnd.Be-bookmark");
 		// Replace the standard Be-bookmark file icons with the argument icons,
 		// if any were provided.
 		if (status == B_OK) {
@@ -206,6 +497,30 @@ BookmarkManager::_CreateBookmark(const BPath& path, BString fileName, const BStr
 	}
 }
 
+/*static*/ status_t
+BookmarkManager::WriteBookmarkFile(const char* path, const BString& title,
+	const BString& url)
+{
+	BFile file(path, B_CREATE_FILE | B_FAIL_IF_EXISTS | B_WRITE_ONLY);
+	status_t status = file.InitCheck();
+	if (status == B_OK)
+		status = _WriteBookmarkAttributes(file, title, url);
+	return status;
+}
+
+/*static*/ status_t
+BookmarkManager::_WriteBookmarkAttributes(BFile& file, const BString& title,
+	const BString& url)
+{
+	status_t status = file.WriteAttrString("META:url", &url);
+	if (status != B_OK)
+		return status;
+	file.WriteAttrString("META:title", &title);
+
+	BNodeInfo nodeInfo(&file);
+	return nodeInfo.SetType("application/x-vnd.Be-bookmark");
+}
+
 /*static*/ void
 BookmarkManager::CreateBookmarkFromMessage(BMessage* message)
 {
@@ -301,6 +616,18 @@ BookmarkManager::ShowBookmarks()
 BookmarkManager::CheckBookmarkExists(BDirectory& directory,
 	const BString& bookmarkName, const BString& url)
 {
+	BookmarkIndex* index = BookmarkIndex::Default();
+	if (index != NULL) {
+		BAutolock _(index);
+		BEntry directoryEntry;
+		BPath path;
+		if (index->IsReady() && directory.GetEntry(&directoryEntry) == B_OK
+			&& directoryEntry.GetPath(&path) == B_OK
+			&& path.Append(bookmarkName.String()) == B_OK) {
+			return index->HasBookmark(path.Path(), url);
+		}
+	}
+
 	BEntry entry;
 	if (directory.FindEntry(bookmarkName.String(), &entry) == B_OK) {
 		BString storedURL;
@@ -325,46 +652,20 @@ BookmarkManager::ReadURLAttr(BNode& bookmarkNode, BString& url)
 BookmarkManager::AddBookmarkURLsRecursively(BDirectory& directory,
 	BMessage* message, uint32& addedCount)
 {
-	BVolume volume;
-	if (directory.GetVolume(&volume) == B_OK && volume.KnowsQuery()) {
-		BQuery query;
-		query.SetVolume(&volume);
-		query.PushAttr("META:url");
-		query.PushString("*");
-		query.PushOp(B_EQ);
-
-		if (query.Fetch() == B_OK) {
-			BEntry dirEntry;
-			BPath dirPath;
-			if (directory.GetEntry(&dirEntry) == B_OK && dirEntry.GetPath(&dirPath) == B_OK) {
-				const char* dirStr = dirPath.Path();
-				size_t dirLen = strlen(dirStr);
-
-				entry_ref ref;
-				BPath path;
-				while (query.GetNextRef(&ref) == B_OK) {
-					if (path.SetTo(&ref) == B_OK) {
-						const char* pathStr = path.Path();
-						// Check if pathStr starts with dirStr
-						if (strncmp(pathStr, dirStr, dirLen) == 0) {
-							// Ensure it is a file under this directory (descendant)
-							// pathStr must have a separator after dirStr or be strictly inside
-							if (pathStr[dirLen] == '/' || pathStr[dirLen] == '\0') {
-								BNode node(&ref);
-								BString storedURL;
-								if (ReadURLAttr(node, storedURL)) {
-									message->AddString("url", storedURL.String());
-									addedCount++;
-								}
-							}
-						}
-					}
-				}
-				return;
-			}
+	BookmarkIndex* index = BookmarkIndex::Default();
+	if (index != NULL) {
+		BAutolock _(index);
+		BEntry directoryEntry;
+		BPath path;
+		if (index->IsReady() && directory.GetEntry(&directoryEntry) == B_OK
+			&& directoryEntry.GetPath(&path) == B_OK) {
+			addedCount += index->AddURLs(path.Path(), message);
+			return;
 		}
 	}
 
+	// Until the index is ready, the folder is walked. A query for all
+	// bookmarks would have to look at every one on the volume instead.
 	BEntry entry;
 	directory.Rewind();
 	while (directory.GetNextEntry(&entry) == B_OK) {
@@ -389,259 +690,55 @@ BookmarkManager::AddBookmarkURLsRecursively(BDirectory& directory,
 /*static*/ status_t
 BookmarkManager::ExportBookmarks(const BPath& path)
 {
-	BFile file(path.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
-	status_t status = file.InitCheck();
+	BPath bookmarkPath;
+	status_t status = GetBookmarkPath(bookmarkPath);
 	if (status != B_OK)
 		return status;
 
-	BString header = "<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
-		"<!-- This is an automatically generated file.\n"
-		"     It will be read and overwritten.\n"
-		"     DO NOT EDIT! -->\n"
-		"<META HTTP-EQUIV=\"Content-Type\" CONTENT=\"text/html; charset=UTF-8\">\n"
-		"<TITLE>Bookmarks</TITLE>\n"
-		"<H1>Bookmarks</H1>\n"
-		"<DL><p>\n";
-	file.Write(header.String(), header.Length());
-
-	BPath bookmarkPath;
-	status = GetBookmarkPath(bookmarkPath);
+	BFile file(path.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status = file.InitCheck();
 	if (status != B_OK)
 		return status;
 
-	BDirectory dir(bookmarkPath.Path());
-	_ExportBookmarksRecursively(dir, file, 1);
-
-	BString footer = "</DL><p>\n";
-	file.Write(footer.String(), footer.Length());
-	return B_OK;
-}
-
-/*static*/ status_t
-BookmarkManager::_ExportBookmarksRecursively(BDirectory& directory, BFile& file,
-	int32 indentLevel)
-{
-	BEntry entry;
-	directory.Rewind();
-	while (directory.GetNextEntry(&entry) == B_OK) {
-		char name[B_FILE_NAME_LENGTH];
-		if (entry.GetName(name) != B_OK)
-			continue;
-
-		BString indent;
-		indent.SetTo(' ', indentLevel * 4);
-
-		if (entry.IsDirectory()) {
-			BString folderName(name);
-			folderName.ReplaceAll("&", "&amp;");
-			folderName.ReplaceAll("<", "&lt;");
-			folderName.ReplaceAll(">", "&gt;");
-
-			BString line;
-			line << indent << "<DT><H3>" << folderName << "</H3>\n";
-			line << indent << "<DL><p>\n";
-			file.Write(line.String(), line.Length());
-
-			BDirectory subDirectory(&entry);
-			_ExportBookmarksRecursively(subDirectory, file, indentLevel + 1);
-
-			line = "";
-			line << indent << "</DL><p>\n";
-			file.Write(line.String(), line.Length());
-		} else {
-			BNode bookmarkNode(&entry);
-			BString url;
-			if (ReadURLAttr(bookmarkNode, url)) {
-				BString title;
-				if (bookmarkNode.ReadAttrString("META:title", &title) != B_OK)
-					title = name;
-
-				title.ReplaceAll("&", "&amp;");
-				title.ReplaceAll("<", "&lt;");
-				title.ReplaceAll(">", "&gt;");
-
-				BString line;
-				line << indent << "<DT><A HREF=\"" << url << "\">" << title << "</A>\n";
-				file.Write(line.String(), line.Length());
-			}
-		}
-	}
-	return B_OK;
-}
-
-/*static*/ BString
-BookmarkManager::_ExtractAttribute(const BString& tag, const char* attribute)
-{
-	BString attr(attribute);
-	attr << "=";
-	int32 pos = tag.IFindFirst(attr);
-	if (pos < 0) return "";
-
-	pos += attr.Length();
-	// Handle quoting
-	char quote = 0;
-	if (tag.ByteAt(pos) == '"' || tag.ByteAt(pos) == '\'') {
-		quote = tag.ByteAt(pos);
-		pos++;
-	}
-
-	int32 endPos;
-	if (quote != 0) {
-		endPos = tag.FindFirst(quote, pos);
-	} else {
-		endPos = tag.FindFirst(" ", pos);
-		if (endPos < 0) endPos = tag.FindFirst(">", pos); // Should not happen given how tag is constructed
-		if (endPos < 0) endPos = tag.Length();
-	}
-
-	if (endPos > pos) {
-		BString value;
-		tag.CopyInto(value, pos, endPos - pos);
-		return value;
-	}
-	return "";
+	BookmarkExporter exporter(file);
+	return exporter.Export(bookmarkPath);
 }
 
 /*static*/ status_t
-BookmarkManager::ImportBookmarks(const BPath& path)
+BookmarkManager::ImportBookmarks(const BPath& path,
+	const BMessenger& progressTarget, bool merge)
 {
 	BFile file(path.Path(), B_READ_ONLY);
 	status_t status = file.InitCheck();
 	if (status != B_OK)
 		return status;
 
-	off_t size;
-	status = file.GetSize(&size);
-	if (status != B_OK)
-		return status;
-
-	// Check against reasonable limit (64MB) and int32 overflow
-	if (size < 0 || size > 0x4000000)
-		return B_ERROR;
-
-	BString content;
-	char* buffer = content.LockBuffer(size);
-	if (buffer == NULL)
-		return B_NO_MEMORY;
-
-	ssize_t bytesRead = file.Read(buffer, size);
-	if (bytesRead < 0) {
-		content.UnlockBuffer(0);
-		return (status_t)bytesRead;
-	}
-	if (bytesRead != size) {
-		content.UnlockBuffer(0);
-		return B_IO_ERROR;
-	}
-
-	content.UnlockBuffer(size);
-
 	BPath bookmarkPath;
 	status = GetBookmarkPath(bookmarkPath);
 	if (status != B_OK)
 		return status;
 
-	std::vector<BPath> dirStack;
-	dirStack.push_back(bookmarkPath);
-
-	BString pendingFolderName;
-
-	int32 pos = 0;
-	const char* contentStr = content.String();
-
-	while (pos < content.Length()) {
-		int32 tagStart = content.FindFirst("<", pos);
-		if (tagStart < 0) break;
-		int32 tagEnd = content.FindFirst(">", tagStart);
-		if (tagEnd < 0) break;
-
-		const char* tagData = contentStr + tagStart + 1;
-		int32 tagLen = tagEnd - tagStart - 1;
-
-		if (tagLen >= 2 && strncasecmp(tagData, "DT", 2) == 0) {
-			if (!pendingFolderName.IsEmpty()) {
-				BPath currentPath = dirStack.back();
-				currentPath.Append(pendingFolderName);
-				create_directory(currentPath.Path(), 0777);
-				pendingFolderName = "";
-			}
-
-			// Found DT, look for H3 or A in next tag
-			int32 nextTagStart = content.FindFirst("<", tagEnd);
-			if (nextTagStart > 0) {
-				int32 nextTagEnd = content.FindFirst(">", nextTagStart);
-				if (nextTagEnd > 0) {
-					const char* nextTagData = contentStr + nextTagStart + 1;
-					int32 nextTagLen = nextTagEnd - nextTagStart - 1;
-
-					if (nextTagLen >= 2 && strncasecmp(nextTagData, "H3", 2) == 0) {
-						// Folder name
-						BString endTag = "</H3>";
-						int32 closeH3 = content.IFindFirst(endTag, nextTagEnd);
-
-						if (closeH3 > 0) {
-							BString folderName;
-							content.CopyInto(folderName, nextTagEnd + 1, closeH3 - nextTagEnd - 1);
-
-							folderName.ReplaceAll("&lt;", "<");
-							folderName.ReplaceAll("&gt;", ">");
-							folderName.ReplaceAll("&amp;", "&");
-							folderName.ReplaceAll("&quot;", "\"");
-							folderName.ReplaceAll("&#39;", "'");
-
-							pendingFolderName = folderName;
-							pos = closeH3 + 5;
-							continue;
-						}
-					} else if (nextTagLen >= 1 && strncasecmp(nextTagData, "A", 1) == 0) {
-						// Bookmark
-						BString tagContent;
-						tagContent.SetTo(nextTagData, nextTagLen);
-
-						BString url = _ExtractAttribute(tagContent, "HREF");
-						if (url.Length() > 0) {
-							int32 closeA = content.IFindFirst("</A>", nextTagEnd);
-
-							if (closeA > 0) {
-								BString title;
-								content.CopyInto(title, nextTagEnd + 1, closeA - nextTagEnd - 1);
-
-								title.ReplaceAll("&lt;", "<");
-								title.ReplaceAll("&gt;", ">");
-								title.ReplaceAll("&amp;", "&");
-								title.ReplaceAll("&quot;", "\"");
-								title.ReplaceAll("&#39;", "'");
-
-								_CreateBookmark(dirStack.back(), title, title, url, NULL, NULL);
-								pos = closeA + 4;
-								continue;
-							}
-						}
-					}
-				}
-			}
-		} else if (tagLen >= 2 && strncasecmp(tagData, "DL", 2) == 0) {
-			if (!pendingFolderName.IsEmpty()) {
-				BPath currentPath = dirStack.back();
-				currentPath.Append(pendingFolderName);
-				create_directory(currentPath.Path(), 0777);
-				dirStack.push_back(currentPath);
-				pendingFolderName = "";
-			}
-		} else if (tagLen >= 3 && strncasecmp(tagData, "/DL", 3) == 0) {
-			if (!pendingFolderName.IsEmpty()) {
-				BPath currentPath = dirStack.back();
-				currentPath.Append(pendingFolderName);
-				create_directory(currentPath.Path(), 0777);
-				pendingFolderName = "";
-			}
+	// The file is parsed while it is read, so its size does not matter
+	BookmarkBulkWriter writer(progressTarget, merge);
+	BookmarkImporter importer(bookmarkPath, writer);
+	BookmarkHTMLParser* parser = new(std::nothrow) BookmarkHTMLParser(
+		&importer);
+	char* buffer = new(std::nothrow) char[kImportBufferSize];
+	if (parser == NULL || buffer == NULL) {
+		delete parser;
+		delete[] buffer;
+		return B_NO_MEMORY;
+	}
 
-			if (dirStack.size() > 1)
-				dirStack.pop_back();
-		}
+	ssize_t bytesRead;
+	while ((bytesRead = file.Read(buffer, kImportBufferSize)) > 0)
+		parser->Feed(buffer, bytesRead);
 
-		pos = tagEnd + 1;
-	}
+	delete parser;
+	delete[] buffer;
 
-	return B_OK;
+	status = writer.Flush();
+	if (bytesRead < 0)
+		return (status_t)bytesRead;
+	return status;
 }
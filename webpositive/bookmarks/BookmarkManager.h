@@ -7,6 +7,7 @@
 
 #include <Bitmap.h>
 #include <Directory.h>
+#include <Messenger.h>
 #include <Path.h>
 #include <String.h>
 
@@ -31,16 +32,21 @@ public:
 	static void AddBookmarkURLsRecursively(BDirectory& directory,
 		BMessage* message, uint32& addedCount);
 
-	static status_t ImportBookmarks(const BPath& path);
+	static status_t WriteBookmarkFile(const char* path, const BString& title,
+		const BString& url);
+
+	static status_t ImportBookmarks(const BPath& path,
+		const BMessenger& progressTarget = BMessenger(), bool merge = false);
 	static status_t ExportBookmarks(const BPath& path);
 
 private:
 	static void _CreateBookmark(const BPath& path, BString fileName, const BString& title,
 		const BString& url, const BBitmap* miniIcon, const BBitmap* largeIcon);
 
-	static status_t _ExportBookmarksRecursively(BDirectory& directory, BFile& file,
-		int32 indentLevel);
-	static BString _ExtractAttribute(const BString& tag, const char* attribute);
+	static status_t _WriteBookmarkAttributes(BFile& file, const BString& title,
+		const BString& url);
+
+	friend class BookmarkImporter;
 };
 
 #endif // BOOKMARK_MANAGER_H
@@ -0,0 +1,476 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "BookmarkMonitor.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <Node.h>
+#include <NodeMonitor.h>
+
+#include <string.h>
+
+#include "BookmarkIndex.h"
+#include "BookmarkManager.h"
+
+
+// Symlinks are not followed, so this only guards against absurdly deep
+// folder hierarchies.
+static const int32 kMaxDepth = 64;
+
+
+static void
+readBookmark(BNode& node, BString& title, BString& url, BString& tags)
+{
+	if (!BookmarkManager::ReadURLAttr(node, url))
+		url.Truncate(0);
+	if (node.ReadAttrString("META:title", &title) != B_OK)
+		title.Truncate(0);
+	if (node.ReadAttrString("META:keyw", &tags) != B_OK)
+		tags.Truncate(0);
+}
+
+
+BookmarkMonitor::BookmarkMonitor(BookmarkIndex* index)
+	:
+	BHandler("bookmark monitor"),
+	fIndex(index),
+	fBuildThread(-1),
+	fPendingSemaphore(-1),
+	fWalking(false),
+	fQuitting(false),
+	fWatchFailed(false)
+{
+}
+
+
+BookmarkMonitor::~BookmarkMonitor()
+{
+	Stop();
+}
+
+
+status_t
+BookmarkMonitor::Start(const BPath& root)
+{
+	if (Looper() == NULL)
+		return B_NO_INIT;
+	if (fBuildThread >= 0)
+		return B_BUSY;
+
+	fRoot = root;
+	fQuitting = false;
+	fWatchFailed = false;
+	fPendingSemaphore = create_sem(0, "bookmark folders");
+	if (fPendingSemaphore < 0)
+		return fPendingSemaphore;
+
+	fBuildThread = spawn_thread(_BuildThread, "bookmark indexer",
+		B_LOW_PRIORITY, this);
+	status_t status = fBuildThread;
+	if (fBuildThread >= 0) {
+		status = resume_thread(fBuildThread);
+		if (status != B_OK)
+			kill_thread(fBuildThread);
+	}
+	if (status != B_OK) {
+		fBuildThread = -1;
+		delete_sem(fPendingSemaphore);
+		fPendingSemaphore = -1;
+	}
+	return status;
+}
+
+
+void
+BookmarkMonitor::Stop()
+{
+	fQuitting = true;
+	if (fPendingSemaphore >= 0) {
+		// Wakes up the thread if it waits for folders to walk
+		delete_sem(fPendingSemaphore);
+	}
+	if (fBuildThread >= 0) {
+		status_t result;
+		wait_for_thread(fBuildThread, &result);
+		fBuildThread = -1;
+	}
+	fPendingSemaphore = -1;
+	stop_watching(this);
+
+	BAutolock _(fIndex);
+	fDirectories.clear();
+	fPendingDirectories.clear();
+}
+
+
+void
+BookmarkMonitor::MessageReceived(BMessage* message)
+{
+	if (message->what != B_NODE_MONITOR) {
+		BHandler::MessageReceived(message);
+		return;
+	}
+	if (fWatchFailed)
+		return;
+
+	switch (message->GetInt32("opcode", 0)) {
+		case B_ENTRY_CREATED:
+			_EntryCreated(message);
+			break;
+		case B_ENTRY_MOVED:
+			_EntryMoved(message);
+			break;
+		case B_ENTRY_REMOVED:
+			_EntryRemoved(message);
+			break;
+		case B_ATTR_CHANGED:
+			_AttributeChanged(message);
+			break;
+	}
+}
+
+
+/*static*/ status_t
+BookmarkMonitor::_BuildThread(void* data)
+{
+	BookmarkMonitor* monitor = (BookmarkMonitor*)data;
+
+	// The index may have been loaded from disk; what is not found again
+	// is removed once the walk is complete.
+	{
+		BAutolock _(monitor->fIndex);
+		monitor->fIndex->StartRescan();
+		monitor->fWalking = true;
+	}
+
+	BEntry root(monitor->fRoot.Path());
+	monitor->_AddDirectory(root, 0, true);
+	// Folders that turned up meanwhile are part of the first walk
+	monitor->_AddPendingDirectories(true);
+
+	{
+		BAutolock _(monitor->fIndex);
+		monitor->fWalking = false;
+		monitor->fRemovedNodes.clear();
+		if (monitor->fWatchFailed) {
+			stop_watching(monitor);
+			return B_OK;
+		}
+		if (!monitor->fQuitting) {
+			monitor->fIndex->FinishRescan();
+			monitor->fIndex->SetReady(true);
+		}
+	}
+
+	// Then walks the folders created or moved in later, as those may be
+	// large, until Stop() deletes the semaphore
+	while (acquire_sem(monitor->fPendingSemaphore) == B_OK
+		&& !monitor->fQuitting && !monitor->fWatchFailed) {
+		monitor->_AddPendingDirectories(false);
+	}
+	return B_OK;
+}
+
+
+void
+BookmarkMonitor::_PostDirectory(const entry_ref& ref)
+{
+	{
+		BAutolock _(fIndex);
+		try {
+			fPendingDirectories.push_back(ref);
+		} catch (...) {
+			return;
+		}
+	}
+	release_sem(fPendingSemaphore);
+}
+
+
+void
+BookmarkMonitor::_AddPendingDirectories(bool walking)
+{
+	while (!fQuitting && !fWatchFailed) {
+		entry_ref ref;
+		{
+			BAutolock _(fIndex);
+			if (fPendingDirectories.empty())
+				return;
+			ref = fPendingDirectories.front();
+			fPendingDirectories.pop_front();
+		}
+
+		// It may have been moved on or removed since it was posted; the
+		// notification for that posts it again or does not need it
+		BEntry entry(&ref);
+		if (entry.InitCheck() == B_OK && entry.IsDirectory())
+			_AddDirectory(entry, 0, walking);
+	}
+}
+
+
+void
+BookmarkMonitor::_AddDirectory(const BEntry& entry, int32 depth,
+	bool walking)
+{
+	node_ref nodeRef;
+	BPath path;
+	if (fQuitting || depth > kMaxDepth || entry.GetNodeRef(&nodeRef) != B_OK
+		|| entry.GetPath(&path) != B_OK) {
+		return;
+	}
+
+	if (!_Watch(nodeRef, B_WATCH_DIRECTORY))
+		return;
+	{
+		BAutolock _(fIndex);
+		if (walking && fRemovedNodes.erase(nodeRef.node) > 0) {
+			// Removed while the walk got here, the notification missed it
+			watch_node(&nodeRef, B_STOP_WATCHING, BMessenger(this));
+			return;
+		}
+		fDirectories[nodeRef.node] = path.Path();
+	}
+
+	BDirectory directory(&entry);
+	BEntry child;
+	while (!fQuitting && !fWatchFailed
+		&& directory.GetNextEntry(&child) == B_OK) {
+		if (child.IsDirectory())
+			_AddDirectory(child, depth + 1, walking);
+		else
+			_AddFile(child, walking);
+	}
+}
+
+
+void
+BookmarkMonitor::_AddFile(const BEntry& entry, bool walking)
+{
+	node_ref nodeRef;
+	BPath path;
+	if (entry.GetNodeRef(&nodeRef) != B_OK || entry.GetPath(&path) != B_OK)
+		return;
+
+	if (!_Watch(nodeRef, B_WATCH_ATTR))
+		return;
+
+	BNode node(&entry);
+	BString title;
+	BString url;
+	BString tags;
+	readBookmark(node, title, url, tags);
+
+	BAutolock _(fIndex);
+	if (walking) {
+		// The file may have gone since it was listed; if the removal came
+		// in before the file was in the index, it has been recorded. A file
+		// that a notification already put in is newer than what was read.
+		node_ref current;
+		bool removed = fRemovedNodes.erase(nodeRef.node) > 0
+			|| BEntry(path.Path()).GetNodeRef(&current) != B_OK
+			|| current != nodeRef;
+		if (removed || fIndex->IsRescanned(nodeRef.node)) {
+			if (removed)
+				watch_node(&nodeRef, B_STOP_WATCHING, BMessenger(this));
+			return;
+		}
+	}
+	fIndex->Put(nodeRef.node, path.Path(), title, url, tags);
+}
+
+
+bool
+BookmarkMonitor::_Watch(const node_ref& nodeRef, uint32 flags)
+{
+	if (watch_node(&nodeRef, flags, BMessenger(this)) == B_OK)
+		return true;
+
+	// Most likely the team ran out of node monitors. Without notifications
+	// the index would silently go stale, so it is no longer offered as
+	// ready, and its users walk the bookmark folder instead.
+	BAutolock _(fIndex);
+	if (!fWatchFailed) {
+		fWatchFailed = true;
+		fIndex->SetReady(false);
+		if (!fWalking)
+			stop_watching(this);
+	}
+	return false;
+}
+
+
+void
+BookmarkMonitor::_RemoveNode(dev_t device, ino_t node)
+{
+	BAutolock _(fIndex);
+
+	if (fWalking)
+		fRemovedNodes.insert(node);
+
+	std::map<ino_t, BString>::iterator it = fDirectories.find(node);
+	if (it == fDirectories.end()) {
+		if (fIndex->FindNode(node) != NULL) {
+			node_ref nodeRef(device, node);
+			watch_node(&nodeRef, B_STOP_WATCHING, BMessenger(this));
+			fIndex->Remove(node);
+		}
+		return;
+	}
+
+	BString prefix(it->second);
+	fIndex->RemovePath(prefix);
+	prefix << "/";
+
+	it = fDirectories.begin();
+	while (it != fDirectories.end()) {
+		if (it->first == node
+			|| it->second.Compare(prefix.String(), prefix.Length()) == 0) {
+			node_ref nodeRef(device, it->first);
+			watch_node(&nodeRef, B_STOP_WATCHING, BMessenger(this));
+			fDirectories.erase(it++);
+		} else
+			++it;
+	}
+}
+
+
+void
+BookmarkMonitor::_EntryCreated(const BMessage* message)
+{
+	entry_ref ref;
+	const char* name;
+	if (message->FindInt32("device", &ref.device) != B_OK
+		|| message->FindInt64("directory", &ref.directory) != B_OK
+		|| message->FindString("name", &name) != B_OK
+		|| ref.set_name(name) != B_OK) {
+		return;
+	}
+
+	BEntry entry(&ref);
+	if (entry.InitCheck() != B_OK)
+		return;
+
+	if (entry.IsDirectory())
+		_PostDirectory(ref);
+	else
+		_AddFile(entry);
+}
+
+
+void
+BookmarkMonitor::_EntryMoved(const BMessage* message)
+{
+	entry_ref ref;
+	const char* name;
+	ino_t node;
+	if (message->FindInt32("device", &ref.device) != B_OK
+		|| message->FindInt64("to directory", &ref.directory) != B_OK
+		|| message->FindInt64("node", &node) != B_OK
+		|| message->FindString("name", &name) != B_OK
+		|| ref.set_name(name) != B_OK) {
+		return;
+	}
+
+	BEntry entry(&ref);
+	BPath path;
+	if (entry.GetPath(&path) != B_OK || !_IsBelowRoot(path.Path())) {
+		// Moved out of the bookmark folder, to the Trash for example
+		_RemoveNode(ref.device, node);
+		return;
+	}
+
+	BAutolock locker(fIndex);
+
+	std::map<ino_t, BString>::iterator it = fDirectories.find(node);
+	if (it != fDirectories.end()) {
+		BString from(it->second);
+		BString to(path.Path());
+		fIndex->MovePath(from, to);
+
+		from << "/";
+		for (it = fDirectories.begin(); it != fDirectories.end(); ++it) {
+			if (it->first == node)
+				it->second = to;
+			else if (it->second.Compare(from.String(), from.Length()) == 0) {
+				BString moved(to);
+				moved << (it->second.String() + from.Length() - 1);
+				it->second = moved;
+			}
+		}
+		return;
+	}
+
+	const BookmarkIndex::Entry* indexed = fIndex->FindNode(node);
+	if (indexed != NULL) {
+		fIndex->Put(node, path.Path(), BString(indexed->title),
+			BString(indexed->url), BString(indexed->tags));
+		return;
+	}
+	locker.Unlock();
+
+	// Moved in from elsewhere
+	if (entry.IsDirectory())
+		_PostDirectory(ref);
+	else
+		_AddFile(entry);
+}
+
+
+void
+BookmarkMonitor::_EntryRemoved(const BMessage* message)
+{
+	dev_t device;
+	ino_t node;
+	if (message->FindInt32("device", &device) == B_OK
+		&& message->FindInt64("node", &node) == B_OK) {
+		_RemoveNode(device, node);
+	}
+}
+
+
+void
+BookmarkMonitor::_AttributeChanged(const BMessage* message)
+{
+	const char* attribute;
+	ino_t node;
+	if (message->FindString("attr", &attribute) != B_OK
+		|| message->FindInt64("node", &node) != B_OK
+		|| (strcmp(attribute, "META:url") != 0
+			&& strcmp(attribute, "META:title") != 0
+			&& strcmp(attribute, "META:keyw") != 0)) {
+		return;
+	}
+
+	BString path;
+	{
+		BAutolock _(fIndex);
+		const BookmarkIndex::Entry* entry = fIndex->FindNode(node);
+		if (entry == NULL)
+			return;
+		path = entry->path;
+	}
+
+	BNode file(path.String());
+	BString title;
+	BString url;
+	BString tags;
+	readBookmark(file, title, url, tags);
+
+	BAutolock _(fIndex);
+	if (fIndex->FindNode(node) != NULL)
+		fIndex->Put(node, path, title, url, tags);
+}
+
+
+bool
+BookmarkMonitor::_IsBelowRoot(const BString& path) const
+{
+	int32 length = strlen(fRoot.Path());
+	return path.Compare(fRoot.Path(), length) == 0
+		&& (path.Length() == length || path.ByteAt(length) == '/');
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef BOOKMARK_MONITOR_H
+#define BOOKMARK_MONITOR_H
+
+#include <Entry.h>
+#include <Handler.h>
+#include <OS.h>
+#include <Path.h>
+#include <String.h>
+
+#include <deque>
+#include <map>
+#include <set>
+
+class BookmarkIndex;
+struct node_ref;
+
+
+// Fills a BookmarkIndex from the bookmark folder and keeps it current.
+//
+// The folder is walked once in a thread of its own. Every folder is
+// watched for entries being created, moved or removed, and every file for
+// attribute changes; a node is watched before it is read, so nothing that
+// changes in between gets lost. Files the notifications already dealt with
+// before the walk got to them (removed, moved or changed ones) are left as
+// the notifications had them. Folders created or moved in later are
+// walked by the same thread, so the looper never walks a whole subtree.
+// If a node cannot be watched, the index can no longer be kept current;
+// it is then marked as not ready, and the monitor stops. Needs to be added
+// to a looper before calling Start().
+class BookmarkMonitor : public BHandler {
+public:
+								BookmarkMonitor(BookmarkIndex* index);
+	virtual						~BookmarkMonitor();
+
+			status_t			Start(const BPath& root);
+			void				Stop();
+
+	virtual	void				MessageReceived(BMessage* message);
+
+private:
+	static	status_t			_BuildThread(void* data);
+			void				_PostDirectory(const entry_ref& ref);
+			void				_AddPendingDirectories(bool walking);
+
+			void				_AddDirectory(const BEntry& entry,
+									int32 depth, bool walking = false);
+			void				_AddFile(const BEntry& entry,
+									bool walking = false);
+			bool				_Watch(const node_ref& nodeRef,
+									uint32 flags);
+			void				_RemoveNode(dev_t device, ino_t node);
+
+			void				_EntryCreated(const BMessage* message);
+			void				_EntryMoved(const BMessage* message);
+			void				_EntryRemoved(const BMessage* message);
+			void				_AttributeChanged(const BMessage* message);
+
+			bool				_IsBelowRoot(const BString& path) const;
+
+private:
+			BookmarkIndex*		fIndex;
+			BPath				fRoot;
+			thread_id			fBuildThread;
+			sem_id				fPendingSemaphore;
+			bool				fWalking;
+			volatile bool		fQuitting;
+			volatile bool		fWatchFailed;
+
+			std::map<ino_t, BString> fDirectories;
+									// guarded by the index lock
+			std::set<ino_t>		fRemovedNodes;
+									// while walking, same lock
+			std::deque<entry_ref> fPendingDirectories;
+									// to be walked, same lock
+};
+
+#endif // BOOKMARK_MONITOR_H
@@ -5,6 +5,9 @@
 
 #include "BaseURL.h"
 
+#include <ctype.h>
+#include <string.h>
+
 
 BString
 baseURL(const BString& string)
@@ -31,3 +34,72 @@ baseURL(const BString& string, BString& result)
 	else
 		result.SetTo(string.String() + baseURLStart, baseURLEnd - baseURLStart);
 }
+
+
+int32
+urlHostStart(const BString& url)
+{
+	int32 start = url.FindFirst("://");
+	start = start < 0 ? 0 : start + 3;
+	if (strncasecmp(url.String() + start, "www.", 4) == 0)
+		start += 4;
+	return start;
+}
+
+
+void
+normalizeURL(const BString& url, BString& key)
+{
+	int32 start = urlHostStart(url);
+	int32 end = url.Length();
+	int32 fragment = url.FindFirst('#');
+	if (fragment >= 0)
+		end = fragment;
+	while (end > start && url.ByteAt(end - 1) == '/')
+		end--;
+
+	key.SetTo(url.String() + start, end - start);
+
+	// Only the host name is case insensitive
+	int32 hostEnd = key.FindFirst('/');
+	if (hostEnd < 0)
+		hostEnd = key.Length();
+	char* buffer = key.LockBuffer(key.Length());
+	for (int32 i = 0; i < hostEnd; i++)
+		buffer[i] = tolower((unsigned char)buffer[i]);
+	key.UnlockBuffer(key.Length());
+}
+
+
+void
+duplicateURLKey(const BString& url, BString& key)
+{
+	key = url;
+	int32 schemeEnd = key.FindFirst("://");
+	int32 hostStart = schemeEnd < 0 ? 0 : schemeEnd + 3;
+	int32 pathStart = hostStart;
+	while (pathStart < key.Length() && key.ByteAt(pathStart) != '/'
+		&& key.ByteAt(pathStart) != '?' && key.ByteAt(pathStart) != '#') {
+		if (key.ByteAt(pathStart) == '@')
+			hostStart = pathStart + 1;
+		pathStart++;
+	}
+	int32 pathEnd = pathStart;
+	while (pathEnd < key.Length() && key.ByteAt(pathEnd) != '?'
+		&& key.ByteAt(pathEnd) != '#') {
+		pathEnd++;
+	}
+
+	int32 slashes = pathEnd;
+	while (slashes > pathStart && key.ByteAt(slashes - 1) == '/')
+		slashes--;
+	key.Remove(slashes, pathEnd - slashes);
+
+	// The user name and password are left as they are
+	char* buffer = key.LockBuffer(key.Length());
+	for (int32 i = 0; i < schemeEnd; i++)
+		buffer[i] = tolower((unsigned char)buffer[i]);
+	for (int32 i = hostStart; i < pathStart; i++)
+		buffer[i] = tolower((unsigned char)buffer[i]);
+	key.UnlockBuffer(key.Length());
+}
@@ -11,5 +11,15 @@
 BString baseURL(const BString& string);
 void baseURL(const BString& string, BString& result);
 
+// Offset of the host name, behind the scheme and a "www."
+int32 urlHostStart(const BString& url);
+// The URL without scheme, "www.", fragment and trailing slashes, and with
+// the host name in lower case, so that similar URLs have the same key.
+void normalizeURL(const BString& url, BString& key);
+// The URL with its scheme and host name in lower case, and without trailing
+// slashes on its path. Unlike the key above, it is only shared by URLs of the
+// very same page, so one of them can be dropped as a duplicate.
+void duplicateURLKey(const BString& url, BString& key);
+
 
 #endif // BASE_URL_H
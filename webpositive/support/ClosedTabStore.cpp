@@ -0,0 +1,380 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "ClosedTabStore.h"
+
+#include <Autolock.h>
+#include <Entry.h>
+#include <String.h>
+
+#include <new>
+#include <string.h>
+
+
+// Records are stored as their flattened size followed by the flattened
+// message, as in the session journal.
+static const int32 kMaxRecordSize = 1024 * 1024;
+
+static ClosedTabStore* sDefaultStore = NULL;
+
+
+ClosedTabStore::Entry::Entry()
+	:
+	id(0),
+	kind(kTab),
+	isPrivate(false),
+	window(0)
+{
+}
+
+
+ClosedTabStore::ClosedTabStore(const BPath& path, int32 capacity,
+	int32 privateCapacity)
+	:
+	BLocker("closed tabs"),
+	fPath(path),
+	fCapacity(capacity > 0 ? capacity : kDefaultCapacity),
+	fPrivateCapacity(privateCapacity > 0
+		? privateCapacity : kDefaultPrivateCapacity),
+	fLogRecords(0),
+	fNextId(1),
+	fGeneration(0)
+{
+}
+
+
+ClosedTabStore::~ClosedTabStore()
+{
+	if (sDefaultStore == this)
+		sDefaultStore = NULL;
+}
+
+
+/*static*/ ClosedTabStore*
+ClosedTabStore::Default()
+{
+	return sDefaultStore;
+}
+
+
+/*static*/ void
+ClosedTabStore::SetDefault(ClosedTabStore* store)
+{
+	sDefaultStore = store;
+}
+
+
+status_t
+ClosedTabStore::Load()
+{
+	BAutolock _(this);
+
+	fEntries.clear();
+	fLogRecords = 0;
+	fGeneration++;
+
+	BFile log(fPath.Path(), B_READ_ONLY);
+	off_t size;
+	if (log.InitCheck() == B_OK && log.GetSize(&size) == B_OK && size > 0) {
+		char* buffer = new(std::nothrow) char[size];
+		if (buffer == NULL)
+			return B_NO_MEMORY;
+
+		ssize_t bytesRead = log.Read(buffer, size);
+		off_t offset = 0;
+		while (bytesRead > 0 && offset + (off_t)sizeof(int32) <= bytesRead) {
+			int32 recordSize;
+			memcpy(&recordSize, buffer + offset, sizeof(recordSize));
+			offset += sizeof(recordSize);
+			if (recordSize <= 0 || recordSize > kMaxRecordSize
+				|| offset + recordSize > bytesRead) {
+				// Torn write of the last record before a crash
+				break;
+			}
+
+			BMessage record;
+			if (record.Unflatten(buffer + offset) != B_OK)
+				break;
+			_Apply(record);
+			offset += recordSize;
+			fLogRecords++;
+		}
+		delete[] buffer;
+	}
+
+	// Start over with a clean log, which also drops a torn record
+	return _Compact();
+}
+
+
+uint32
+ClosedTabStore::AddTab(const BMessage& state, int32 index, bool isPrivate,
+	uint32 window)
+{
+	BMessage archive(state);
+	archive.AddInt32("index", index);
+	return _Add(kTab, archive, isPrivate, window);
+}
+
+
+void
+ClosedTabStore::AddTabs(const std::vector<BMessage>& states, bool isPrivate,
+	uint32 window)
+{
+	// The states already carry the index of their tab. Only the newest ones
+	// fit into the store, the others are not even written to the log.
+	BAutolock _(this);
+
+	size_t capacity = isPrivate ? fPrivateCapacity : fCapacity;
+	size_t first = 0;
+	if (states.size() > capacity)
+		first = states.size() - capacity;
+	for (size_t i = first; i < states.size(); i++)
+		_Add(kTab, states[i], isPrivate, window);
+}
+
+
+uint32
+ClosedTabStore::AddWindow(const BMessage& archive, bool isPrivate)
+{
+	return _Add(kWindow, archive, isPrivate);
+}
+
+
+bool
+ClosedTabStore::Take(uint32 id, Entry& entry)
+{
+	BAutolock _(this);
+
+	for (size_t i = 0; i < fEntries.size(); i++) {
+		if (fEntries[i].id == id) {
+			entry = fEntries[i];
+			_Remove(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool
+ClosedTabStore::TakeLast(uint32 kind, bool includePrivate, Entry& entry)
+{
+	BAutolock _(this);
+
+	for (size_t i = fEntries.size(); i-- > 0;) {
+		if (fEntries[i].kind != kind
+			|| (fEntries[i].isPrivate && !includePrivate)) {
+			continue;
+		}
+		entry = fEntries[i];
+		_Remove(i);
+		return true;
+	}
+	return false;
+}
+
+
+void
+ClosedTabStore::RemovePrivate(uint32 window)
+{
+	BAutolock _(this);
+
+	for (size_t i = fEntries.size(); i-- > 0;) {
+		if (fEntries[i].isPrivate && fEntries[i].window == window)
+			_Remove(i);
+	}
+}
+
+
+void
+ClosedTabStore::Clear()
+{
+	BAutolock _(this);
+
+	fEntries.clear();
+	fGeneration++;
+	_Compact();
+}
+
+
+const ClosedTabStore::Entry*
+ClosedTabStore::EntryAt(int32 index) const
+{
+	if (index < 0 || index >= (int32)fEntries.size())
+		return NULL;
+	return &fEntries[fEntries.size() - 1 - index];
+}
+
+
+uint32
+ClosedTabStore::_Add(uint32 kind, const BMessage& archive, bool isPrivate,
+	uint32 window)
+{
+	BAutolock _(this);
+
+	Entry entry;
+	entry.id = fNextId++;
+	entry.kind = kind;
+	entry.isPrivate = isPrivate;
+	entry.window = isPrivate ? window : 0;
+	entry.archive = archive;
+	try {
+		fEntries.push_back(entry);
+	} catch (...) {
+		return 0;
+	}
+	_Trim(isPrivate);
+	fGeneration++;
+
+	if (!isPrivate) {
+		BMessage record(kind);
+		record.AddUInt32("id", entry.id);
+		record.AddMessage("archive", &archive);
+		_Append(record);
+	}
+	return entry.id;
+}
+
+
+void
+ClosedTabStore::_Remove(size_t index)
+{
+	bool isPrivate = fEntries[index].isPrivate;
+	uint32 id = fEntries[index].id;
+	fEntries.erase(fEntries.begin() + index);
+	fGeneration++;
+
+	if (!isPrivate) {
+		BMessage record(kRemoved);
+		record.AddUInt32("id", id);
+		_Append(record);
+	}
+}
+
+
+void
+ClosedTabStore::_Trim(bool isPrivate)
+{
+	// Drops the oldest entries of the given kind that no longer fit. This is
+	// not logged: replaying the log drops the same persisted entries again.
+	int32 capacity = isPrivate ? fPrivateCapacity : fCapacity;
+	int32 count = 0;
+	for (size_t i = fEntries.size(); i-- > 0;) {
+		if (fEntries[i].isPrivate != isPrivate)
+			continue;
+		if (++count > capacity)
+			fEntries.erase(fEntries.begin() + i);
+	}
+}
+
+
+void
+ClosedTabStore::_Apply(const BMessage& record)
+{
+	uint32 id = record.GetUInt32("id", 0);
+	if (id >= fNextId)
+		fNextId = id + 1;
+
+	switch (record.what) {
+		case kTab:
+		case kWindow:
+		{
+			Entry entry;
+			entry.id = id;
+			entry.kind = record.what;
+			if (record.FindMessage("archive", &entry.archive) != B_OK)
+				break;
+			try {
+				fEntries.push_back(entry);
+			} catch (...) {
+				break;
+			}
+			_Trim(false);
+			break;
+		}
+
+		case kRemoved:
+			for (size_t i = 0; i < fEntries.size(); i++) {
+				if (fEntries[i].id == id) {
+					fEntries.erase(fEntries.begin() + i);
+					break;
+				}
+			}
+			break;
+	}
+}
+
+
+status_t
+ClosedTabStore::_Append(const BMessage& record)
+{
+	status_t status = fLog.InitCheck();
+	if (status != B_OK)
+		return status;
+
+	// Write the record with a single call, so a crash can at worst leave it
+	// incomplete, which loading detects.
+	ssize_t flattenedSize = record.FlattenedSize();
+	if (flattenedSize <= 0 || flattenedSize > kMaxRecordSize)
+		return B_BAD_VALUE;
+
+	int32 recordSize = (int32)flattenedSize;
+	char* buffer = new(std::nothrow) char[sizeof(recordSize) + recordSize];
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	memcpy(buffer, &recordSize, sizeof(recordSize));
+	status = record.Flatten(buffer + sizeof(recordSize), recordSize);
+	if (status == B_OK) {
+		ssize_t written = fLog.Write(buffer, sizeof(recordSize) + recordSize);
+		if (written < 0)
+			status = written;
+		else if (written != (ssize_t)(sizeof(recordSize) + recordSize))
+			status = B_IO_ERROR;
+	}
+	delete[] buffer;
+
+	if (status == B_OK && ++fLogRecords >= 2 * fCapacity)
+		status = _Compact();
+	return status;
+}
+
+
+status_t
+ClosedTabStore::_Compact()
+{
+	fLog.Unset();
+	fLogRecords = 0;
+
+	// Write the new log next to the old one and move it over it, so there
+	// always is a complete log on disk.
+	BString tempPath(fPath.Path());
+	tempPath << ".new";
+	status_t status = fLog.SetTo(tempPath.String(),
+		B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+
+	BEntry entry(tempPath.String());
+	if (status == B_OK) {
+		for (size_t i = 0; status == B_OK && i < fEntries.size(); i++) {
+			if (fEntries[i].isPrivate)
+				continue;
+			BMessage record(fEntries[i].kind);
+			record.AddUInt32("id", fEntries[i].id);
+			record.AddMessage("archive", &fEntries[i].archive);
+			status = _Append(record);
+		}
+		if (status == B_OK)
+			status = fLog.Sync();
+		if (status == B_OK)
+			status = entry.Rename(fPath.Leaf(), true);
+	}
+	if (status != B_OK) {
+		fLog.Unset();
+		entry.Remove();
+		return status;
+	}
+	return B_OK;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef CLOSED_TAB_STORE_H
+#define CLOSED_TAB_STORE_H
+
+#include <File.h>
+#include <Locker.h>
+#include <Message.h>
+#include <Path.h>
+
+#include <deque>
+#include <vector>
+
+
+// Recently closed tabs and windows of all windows, kept across restarts.
+//
+// Tabs are stored with their full archived state (URL, title, favicon,
+// scroll position, pin state and color) and the index they had, windows
+// with their archive, so reopening them restores them without anything
+// being looked up again. At most a fixed number of entries is kept, the
+// oldest being dropped first. Entries of private windows have a limit of
+// their own, so a busy private window cannot push the persisted entries out.
+//
+// Like the session journal, every change is appended to a log file as a
+// small record; once the log holds twice as many records as there is room
+// for entries, it is rewritten with only the current ones. Closing a tab
+// thus costs a single small write, and the file stays bounded. Entries of
+// private windows are only kept in memory, tagged with their window, and
+// are dropped when that window closes.
+//
+// Should Lock() the object when using CountEntries() and EntryAt() in a loop.
+class ClosedTabStore : public BLocker {
+public:
+	enum {
+		kTab		= 'cstt',
+		kWindow		= 'cstw',
+		kRemoved	= 'cstr'
+	};
+
+	struct Entry {
+									Entry();
+
+				uint32				id;
+				uint32				kind;
+				bool				isPrivate;
+				uint32				window;
+									// of private entries
+				BMessage			archive;
+	};
+
+								ClosedTabStore(const BPath& path,
+									int32 capacity = kDefaultCapacity,
+									int32 privateCapacity
+										= kDefaultPrivateCapacity);
+								~ClosedTabStore();
+
+	static	ClosedTabStore*		Default();
+	static	void				SetDefault(ClosedTabStore* store);
+
+			status_t			Load();
+
+			uint32				AddTab(const BMessage& state, int32 index,
+									bool isPrivate, uint32 window = 0);
+			void				AddTabs(const std::vector<BMessage>& states,
+									bool isPrivate, uint32 window = 0);
+			uint32				AddWindow(const BMessage& archive,
+									bool isPrivate);
+			bool				Take(uint32 id, Entry& entry);
+			bool				TakeLast(uint32 kind, bool includePrivate,
+									Entry& entry);
+			void				RemovePrivate(uint32 window);
+			void				Clear();
+
+			int32				CountEntries() const
+									{ return (int32)fEntries.size(); }
+			const Entry*		EntryAt(int32 index) const;
+									// 0 is the most recently closed one
+			uint32				Generation() const { return fGeneration; }
+
+	static	const int32			kDefaultCapacity = 25;
+	static	const int32			kDefaultPrivateCapacity = 25;
+
+private:
+			uint32				_Add(uint32 kind, const BMessage& archive,
+									bool isPrivate, uint32 window = 0);
+			void				_Remove(size_t index);
+			void				_Trim(bool isPrivate);
+			void				_Apply(const BMessage& record);
+			status_t			_Append(const BMessage& record);
+			status_t			_Compact();
+
+private:
+			BPath				fPath;
+			BFile				fLog;
+			int32				fCapacity;
+			int32				fPrivateCapacity;
+			int32				fLogRecords;
+			uint32				fNextId;
+			uint32				fGeneration;
+			std::deque<Entry>	fEntries;
+				// oldest first
+};
+
+#endif // CLOSED_TAB_STORE_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "CompletionRanker.h"
+
+#include <algorithm>
+#include <ctype.h>
+
+#include "BaseURL.h"
+
+
+static const int32 kHostStartScore = 100;
+static const int32 kWordStartScore = 40;
+static const int32 kURLMatchScore = 20;
+static const int32 kTitleMatchScore = 10;
+
+
+static bool
+rankedHigher(const CompletionRanker::Candidate& a,
+	const CompletionRanker::Candidate& b)
+{
+	if (a.score != b.score)
+		return a.score > b.score;
+	// Shorter URLs first, they are usually the page the user is after
+	return a.url.Length() < b.url.Length();
+}
+
+
+CompletionRanker::CompletionRanker(const BString& pattern)
+	:
+	fPattern(pattern)
+{
+}
+
+
+bool
+CompletionRanker::Add(uint32 source, const BString& url, const BString& title,
+	int32 score, bool matched)
+{
+	if (url.IsEmpty())
+		return false;
+
+	// Sources which did their own matching, by words or tags for example,
+	// get in even if the pattern is not found as it is.
+	int32 matchPos;
+	int32 matchScore = _MatchScore(url, title, matchPos);
+	if (matchScore < 0) {
+		if (!matched)
+			return false;
+		matchScore = 0;
+		matchPos = -1;
+	}
+
+	score += matchScore;
+	if (source == kBookmark)
+		score += kBookmarkBoost;
+	else if (source == kOpenTab)
+		score += kOpenTabBoost;
+
+	BString key;
+	normalizeURL(url, key);
+
+	std::map<BString, size_t>::iterator it = fIndices.find(key);
+	if (it != fIndices.end()) {
+		Candidate& candidate = fCandidates[it->second];
+		if ((candidate.sources & source) == 0) {
+			// Boosts add up: a bookmark open in a tab ranks above either
+			if (source == kBookmark)
+				candidate.score += kBookmarkBoost;
+			else if (source == kOpenTab)
+				candidate.score += kOpenTabBoost;
+		}
+		candidate.sources |= source;
+		if (score > candidate.score)
+			candidate.score = score;
+		if (candidate.title.IsEmpty())
+			candidate.title = title;
+		return true;
+	}
+
+	Candidate candidate;
+	candidate.url = url;
+	candidate.title = title;
+	candidate.sources = source;
+	candidate.score = score;
+	candidate.matchPos = matchPos;
+
+	try {
+		fCandidates.push_back(candidate);
+		fIndices[key] = fCandidates.size() - 1;
+	} catch (...) {
+		if (fCandidates.size() > fIndices.size())
+			fCandidates.pop_back();
+		return false;
+	}
+	return true;
+}
+
+
+void
+CompletionRanker::Rank(int32 maxResults, std::vector<Candidate>& results) const
+{
+	results = fCandidates;
+	std::stable_sort(results.begin(), results.end(), rankedHigher);
+	if (maxResults >= 0 && (int32)results.size() > maxResults)
+		results.resize(maxResults);
+}
+
+
+int32
+CompletionRanker::_MatchScore(const BString& url, const BString& title,
+	int32& matchPos) const
+{
+	matchPos = fPattern.IsEmpty() ? 0 : url.IFindFirst(fPattern);
+	if (matchPos >= 0) {
+		if (matchPos <= urlHostStart(url))
+			return kHostStartScore;
+		if (!isalnum((unsigned char)url.ByteAt(matchPos - 1)))
+			return kWordStartScore;
+		return kURLMatchScore;
+	}
+
+	if (!title.IsEmpty() && title.IFindFirst(fPattern) >= 0)
+		return kTitleMatchScore;
+	return -1;
+}
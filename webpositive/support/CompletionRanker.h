@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef COMPLETION_RANKER_H
+#define COMPLETION_RANKER_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <vector>
+
+
+// Merges the URL bar suggestions of several sources into one ranked list.
+//
+// Every source adds the URLs matching the typed text with a score of its
+// own (how recent or how often visited, for example). URLs differing only
+// in scheme, a leading "www." or a trailing slash count as the same page;
+// a page offered by several sources is listed once and keeps the best
+// score. On top of that, pages matching at the start of the host name rank
+// higher than ones matching somewhere in the path, and bookmarks and open
+// tabs get a fixed boost, since the user chose to keep them.
+class CompletionRanker {
+public:
+	enum {
+		kHistory	= 1 << 0,
+		kBookmark	= 1 << 1,
+		kOpenTab	= 1 << 2
+	};
+
+	struct Candidate {
+			BString				url;
+			BString				title;
+			uint32				sources;
+			int32				score;
+			int32				matchPos;
+									// in the URL, -1 if it only matched
+									// elsewhere
+	};
+
+								CompletionRanker(const BString& pattern);
+
+			bool				Add(uint32 source, const BString& url,
+									const BString& title, int32 score,
+									bool matched = false);
+			int32				CountCandidates() const
+									{ return (int32)fCandidates.size(); }
+			void				Rank(int32 maxResults,
+									std::vector<Candidate>& results) const;
+
+	static	const int32			kBookmarkBoost = 300;
+	static	const int32			kOpenTabBoost = 150;
+
+private:
+			int32				_MatchScore(const BString& url,
+									const BString& title,
+									int32& matchPos) const;
+
+private:
+			BString				fPattern;
+			std::vector<Candidate> fCandidates;
+			std::map<BString, size_t> fIndices;
+									// by normalized URL
+};
+
+#endif // COMPLETION_RANKER_H
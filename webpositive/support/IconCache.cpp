@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "IconCache.h"
+
+#include <Autolock.h>
+#include <Bitmap.h>
+
+#include <new>
+#include <string.h>
+
+
+IconCache::IconCache(int32 capacity)
+	:
+	fLock("icon cache"),
+	fCapacity(capacity > 0 ? capacity : kDefaultCapacity)
+{
+}
+
+
+IconCache::~IconCache()
+{
+}
+
+
+/*static*/ IconCache&
+IconCache::Default()
+{
+	static IconCache sDefault;
+	return sDefault;
+}
+
+
+/*static*/ BString
+IconCache::KeyForURL(const BString& url)
+{
+	// The host, as the favicons are stored by it as well
+	const char* start = strstr(url.String(), "://");
+	if (start == NULL)
+		return BString();
+	start += 3;
+
+	const char* end = start + strcspn(start, "/?#");
+	const char* at = start;
+	while (at < end && *at != '@')
+		at++;
+	if (at < end)
+		start = at + 1;
+
+	const char* host = start;
+	if (*host == '[') {
+		// IPv6 address, the port follows the closing bracket
+		const char* bracket = strchr(host, ']');
+		if (bracket != NULL && bracket < end)
+			end = bracket + 1;
+	} else {
+		const char* colon = host;
+		while (colon < end && *colon != ':')
+			colon++;
+		end = colon;
+	}
+
+	BString key;
+	key.SetTo(host, end - host);
+	key.ToLower();
+	return key;
+}
+
+
+bool
+IconCache::Put(const BString& key, const BBitmap* icon)
+{
+	if (key.IsEmpty() || icon == NULL
+		|| icon->Bounds().IntegerWidth() + 1 != kIconSize
+		|| icon->Bounds().IntegerHeight() + 1 != kIconSize) {
+		return false;
+	}
+
+	BBitmap* copy = new(std::nothrow) BBitmap(BRect(0, 0, kIconSize - 1,
+		kIconSize - 1), B_BITMAP_NO_SERVER_LINK, B_RGBA32);
+	if (copy == NULL || copy->InitCheck() != B_OK
+		|| copy->ImportBits(icon->Bits(), icon->BitsLength(),
+			icon->BytesPerRow(), 0, icon->ColorSpace()) != B_OK) {
+		delete copy;
+		return false;
+	}
+
+	BAutolock _(fLock);
+
+	try {
+		std::map<BString, Entry>::iterator it = fEntries.find(key);
+		if (it == fEntries.end()) {
+			it = fEntries.insert(std::make_pair(key, Entry())).first;
+			it->second.lruPosition = fLRU.end();
+		}
+		it->second.icon.reset(copy);
+		_Touch(key, it->second);
+	} catch (...) {
+		return false;
+	}
+
+	while ((int32)fEntries.size() > fCapacity) {
+		fEntries.erase(fLRU.back());
+		fLRU.pop_back();
+	}
+	return true;
+}
+
+
+IconCache::IconRef
+IconCache::Get(const BString& key)
+{
+	BAutolock _(fLock);
+
+	std::map<BString, Entry>::iterator it = fEntries.find(key);
+	if (it == fEntries.end())
+		return IconRef();
+
+	_Touch(key, it->second);
+	return it->second.icon;
+}
+
+
+void
+IconCache::Remove(const BString& key)
+{
+	BAutolock _(fLock);
+
+	std::map<BString, Entry>::iterator it = fEntries.find(key);
+	if (it == fEntries.end())
+		return;
+
+	fLRU.erase(it->second.lruPosition);
+	fEntries.erase(it);
+}
+
+
+void
+IconCache::Clear()
+{
+	BAutolock _(fLock);
+
+	fEntries.clear();
+	fLRU.clear();
+}
+
+
+int32
+IconCache::CountEntries()
+{
+	BAutolock _(fLock);
+	return (int32)fEntries.size();
+}
+
+
+void
+IconCache::_Touch(const BString& key, Entry& entry)
+{
+	if (entry.lruPosition != fLRU.end())
+		fLRU.erase(entry.lruPosition);
+	fLRU.push_front(key);
+	entry.lruPosition = fLRU.begin();
+}
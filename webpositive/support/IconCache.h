@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#include <Locker.h>
+#include <String.h>
+
+#include <list>
+#include <map>
+#include <memory>
+
+class BBitmap;
+
+
+// Application-wide store for decoded site icons, keyed by host name.
+//
+// The windows put the favicons of the pages they show here, and the
+// bookmark bar those it reads from bookmark files, so a site's icon is
+// decoded once and then shared by all bookmarks and tabs of that site.
+// Only icons of menu item size are kept. The least recently used ones are
+// dropped once the capacity is reached.
+//
+// Icons are handed out as shared pointers, so an icon being copied stays
+// valid even if the cache drops it meanwhile.
+class IconCache {
+public:
+	typedef std::shared_ptr<const BBitmap> IconRef;
+
+								IconCache(int32 capacity = kDefaultCapacity);
+								~IconCache();
+
+	static	IconCache&			Default();
+
+	static	BString				KeyForURL(const BString& url);
+
+			bool				Put(const BString& key, const BBitmap* icon);
+			IconRef				Get(const BString& key);
+			void				Remove(const BString& key);
+			void				Clear();
+
+			int32				CountEntries();
+
+	static	const int32			kIconSize = 16;
+									// the size of B_MINI_ICON
+	static	const int32			kDefaultCapacity = 256;
+
+private:
+			struct Entry {
+				IconRef				icon;
+				std::list<BString>::iterator lruPosition;
+			};
+
+			void				_Touch(const BString& key, Entry& entry);
+
+private:
+			BLocker				fLock;
+			std::map<BString, Entry> fEntries;
+			std::list<BString>	fLRU;
+				// most recently used first
+			int32				fCapacity;
+};
+
+#endif // ICON_CACHE_H
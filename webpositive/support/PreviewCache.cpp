@@ -0,0 +1,433 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "PreviewCache.h"
+
+#include <Autolock.h>
+#include <Bitmap.h>
+
+#include <new>
+#include <string.h>
+
+
+// Encoded previews store three bytes per pixel (the alpha channel of a
+// B_RGB32 screen capture carries no information) and collapse runs of equal
+// pixels, which are common in the flat backgrounds of web pages. A control
+// byte below 128 starts a literal run of (byte + 1) pixels, one of 128 or
+// above repeats the following pixel (byte - 128 + 2) times.
+static const int32 kMaxLiteralRun = 128;
+static const int32 kMaxRepeatRun = 129;
+
+
+static inline bool
+samePixel(const uint8* a, const uint8* b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+
+PreviewCache::Entry::Entry()
+	:
+	width(0),
+	height(0),
+	generation(0)
+{
+}
+
+
+PreviewCache::PreviewCache(size_t budget)
+	:
+	fLock("preview cache"),
+	fBudget(budget),
+	fHotSize(0),
+	fColdSize(0),
+	fNextGeneration(1)
+{
+}
+
+
+PreviewCache::~PreviewCache()
+{
+}
+
+
+/*static*/ PreviewCache&
+PreviewCache::Default()
+{
+	static PreviewCache sDefault;
+	return sDefault;
+}
+
+
+/*static*/ PreviewCache&
+PreviewCache::Snapshots()
+{
+	static PreviewCache sSnapshots(kDefaultSnapshotBudget);
+	return sSnapshots;
+}
+
+
+void
+PreviewCache::SetBudget(size_t bytes)
+{
+	BAutolock _(fLock);
+	fBudget = bytes;
+	_Enforce(0);
+}
+
+
+size_t
+PreviewCache::Budget()
+{
+	BAutolock _(fLock);
+	return fBudget;
+}
+
+
+void
+PreviewCache::Put(uint32 tabId, BBitmap* preview)
+{
+	if (preview == NULL)
+		return;
+
+	BAutolock _(fLock);
+
+	Entry& entry = fEntries[tabId];
+	if (entry.generation != 0) {
+		_Unlink(entry);
+		entry.compressed.clear();
+		entry.compressed.shrink_to_fit();
+	} else
+		entry.lruPosition = fLRU.end();
+
+	entry.bitmap.reset(preview);
+	entry.width = preview->Bounds().IntegerWidth() + 1;
+	entry.height = preview->Bounds().IntegerHeight() + 1;
+	entry.generation = fNextGeneration++;
+	if (fNextGeneration == 0)
+		fNextGeneration = 1;
+	fHotSize += _EntrySize(entry);
+
+	_Touch(tabId, entry);
+	_Enforce(tabId);
+}
+
+
+PreviewCache::PreviewRef
+PreviewCache::Get(uint32 tabId, uint32* generation)
+{
+	BAutolock _(fLock);
+
+	if (generation != NULL)
+		*generation = 0;
+
+	std::map<uint32, Entry>::iterator it = fEntries.find(tabId);
+	if (it == fEntries.end())
+		return PreviewRef();
+
+	Entry& entry = it->second;
+	if (entry.bitmap == NULL) {
+		// Regenerate the bitmap from its encoded form
+		size_t coldSize = _EntrySize(entry);
+		if (!_Decompress(entry))
+			return PreviewRef();
+		fColdSize -= coldSize;
+		fHotSize += _EntrySize(entry);
+	}
+
+	_Touch(tabId, entry);
+	_Enforce(tabId);
+
+	if (generation != NULL)
+		*generation = entry.generation;
+	return entry.bitmap;
+}
+
+
+uint32
+PreviewCache::GenerationFor(uint32 tabId)
+{
+	BAutolock _(fLock);
+
+	std::map<uint32, Entry>::iterator it = fEntries.find(tabId);
+	if (it == fEntries.end())
+		return 0;
+	return it->second.generation;
+}
+
+
+void
+PreviewCache::Compress(uint32 tabId)
+{
+	// For entries which will not be drawn for a while: encode them right
+	// away instead of waiting for the budget to run out.
+	BAutolock _(fLock);
+
+	std::map<uint32, Entry>::iterator it = fEntries.find(tabId);
+	if (it == fEntries.end() || it->second.bitmap == NULL)
+		return;
+
+	Entry& entry = it->second;
+	size_t hotSize = _EntrySize(entry);
+	if (!_Compress(entry))
+		return;
+	fHotSize -= hotSize;
+	fColdSize += _EntrySize(entry);
+}
+
+
+void
+PreviewCache::Remove(uint32 tabId)
+{
+	BAutolock _(fLock);
+
+	std::map<uint32, Entry>::iterator it = fEntries.find(tabId);
+	if (it == fEntries.end())
+		return;
+
+	_Unlink(it->second);
+	fEntries.erase(it);
+}
+
+
+void
+PreviewCache::Clear()
+{
+	BAutolock _(fLock);
+
+	fEntries.clear();
+	fLRU.clear();
+	fHotSize = 0;
+	fColdSize = 0;
+}
+
+
+size_t
+PreviewCache::MemoryUsage()
+{
+	BAutolock _(fLock);
+	return fHotSize + fColdSize;
+}
+
+
+int32
+PreviewCache::CountEntries()
+{
+	BAutolock _(fLock);
+	return (int32)fEntries.size();
+}
+
+
+int32
+PreviewCache::CountCompressedEntries()
+{
+	BAutolock _(fLock);
+
+	int32 count = 0;
+	std::map<uint32, Entry>::const_iterator it = fEntries.begin();
+	for (; it != fEntries.end(); it++) {
+		if (it->second.bitmap == NULL)
+			count++;
+	}
+	return count;
+}
+
+
+size_t
+PreviewCache::_EntrySize(const Entry& entry) const
+{
+	if (entry.bitmap != NULL)
+		return (size_t)entry.width * entry.height * 4;
+	return entry.compressed.size();
+}
+
+
+void
+PreviewCache::_Touch(uint32 tabId, Entry& entry)
+{
+	if (entry.lruPosition != fLRU.end())
+		fLRU.erase(entry.lruPosition);
+	fLRU.push_front(tabId);
+	entry.lruPosition = fLRU.begin();
+}
+
+
+void
+PreviewCache::_Unlink(Entry& entry)
+{
+	if (entry.bitmap != NULL)
+		fHotSize -= _EntrySize(entry);
+	else
+		fColdSize -= _EntrySize(entry);
+
+	if (entry.lruPosition != fLRU.end()) {
+		fLRU.erase(entry.lruPosition);
+		entry.lruPosition = fLRU.end();
+	}
+}
+
+
+void
+PreviewCache::_Enforce(uint32 keepTabId)
+{
+	// First encode the least recently used bitmaps until they fit into half
+	// of the budget...
+	std::list<uint32>::reverse_iterator it = fLRU.rbegin();
+	while (fHotSize > fBudget / 2 && it != fLRU.rend()) {
+		uint32 tabId = *it++;
+		if (tabId == keepTabId)
+			continue;
+
+		Entry& entry = fEntries[tabId];
+		if (entry.bitmap == NULL)
+			continue;
+
+		size_t hotSize = _EntrySize(entry);
+		if (!_Compress(entry))
+			continue;
+		fHotSize -= hotSize;
+		fColdSize += _EntrySize(entry);
+	}
+
+	// ...then forget the oldest previews altogether until everything fits.
+	while (fHotSize + fColdSize > fBudget && !fLRU.empty()) {
+		uint32 tabId = fLRU.back();
+		if (tabId == keepTabId) {
+			if (fLRU.size() == 1)
+				break;
+			// Move the preview being kept out of the way
+			fLRU.pop_back();
+			fLRU.push_front(tabId);
+			fEntries[tabId].lruPosition = fLRU.begin();
+			continue;
+		}
+
+		std::map<uint32, Entry>::iterator entry = fEntries.find(tabId);
+		_Unlink(entry->second);
+		fEntries.erase(entry);
+	}
+}
+
+
+bool
+PreviewCache::_Compress(Entry& entry)
+{
+	const BBitmap* bitmap = entry.bitmap.get();
+	if (bitmap->ColorSpace() != B_RGB32 && bitmap->ColorSpace() != B_RGBA32)
+		return false;
+
+	const int32 bytesPerRow = bitmap->BytesPerRow();
+	const uint8* bits = static_cast<const uint8*>(bitmap->Bits());
+
+	// Flatten the pixels first so runs can span rows
+	const int32 pixelCount = entry.width * entry.height;
+	std::vector<uint8> pixels;
+	std::vector<uint8> encoded;
+	try {
+		pixels.resize((size_t)pixelCount * 3);
+		encoded.reserve(pixels.size() / 2);
+	} catch (...) {
+		return false;
+	}
+	uint8* out = pixels.data();
+	for (int32 y = 0; y < entry.height; y++) {
+		const uint8* row = bits + y * bytesPerRow;
+		for (int32 x = 0; x < entry.width; x++) {
+			*out++ = row[0];
+			*out++ = row[1];
+			*out++ = row[2];
+			row += 4;
+		}
+	}
+
+	const uint8* pixel = pixels.data();
+	int32 i = 0;
+	while (i < pixelCount) {
+		int32 run = 1;
+		while (i + run < pixelCount && run < kMaxRepeatRun
+			&& samePixel(pixel + i * 3, pixel + (i + run) * 3)) {
+			run++;
+		}
+
+		if (run >= 2) {
+			encoded.push_back((uint8)(128 + run - 2));
+			encoded.insert(encoded.end(), pixel + i * 3, pixel + i * 3 + 3);
+			i += run;
+			continue;
+		}
+
+		// Collect literals up to the start of the next run
+		int32 literals = 1;
+		while (i + literals < pixelCount && literals < kMaxLiteralRun
+			&& (i + literals + 1 >= pixelCount
+				|| !samePixel(pixel + (i + literals) * 3,
+					pixel + (i + literals + 1) * 3))) {
+			literals++;
+		}
+		encoded.push_back((uint8)(literals - 1));
+		encoded.insert(encoded.end(), pixel + i * 3,
+			pixel + (i + literals) * 3);
+		i += literals;
+	}
+
+	encoded.shrink_to_fit();
+	entry.compressed.swap(encoded);
+	entry.bitmap.reset();
+	return true;
+}
+
+
+bool
+PreviewCache::_Decompress(Entry& entry)
+{
+	BBitmap* bitmap = new(std::nothrow) BBitmap(
+		BRect(0, 0, entry.width - 1, entry.height - 1), B_RGB32);
+	if (bitmap == NULL || bitmap->InitCheck() != B_OK) {
+		delete bitmap;
+		return false;
+	}
+
+	const int32 bytesPerRow = bitmap->BytesPerRow();
+	uint8* bits = static_cast<uint8*>(bitmap->Bits());
+	const uint8* in = entry.compressed.data();
+	const uint8* end = in + entry.compressed.size();
+
+	int32 x = 0;
+	int32 y = 0;
+	while (in < end && y < entry.height) {
+		uint8 control = *in++;
+		bool repeat = control >= 128;
+		int32 count = repeat ? control - 128 + 2 : control + 1;
+		const uint8* source = in;
+		in += repeat ? 3 : count * 3;
+		if (in > end)
+			break;
+
+		for (int32 i = 0; i < count && y < entry.height; i++) {
+			uint8* target = bits + y * bytesPerRow + x * 4;
+			target[0] = source[0];
+			target[1] = source[1];
+			target[2] = source[2];
+			target[3] = 255;
+			if (!repeat)
+				source += 3;
+			if (++x == entry.width) {
+				x = 0;
+				y++;
+			}
+		}
+	}
+
+	if (y < entry.height) {
+		// Corrupted data, should never happen
+		delete bitmap;
+		return false;
+	}
+
+	entry.bitmap.reset(bitmap);
+	entry.compressed.clear();
+	entry.compressed.shrink_to_fit();
+	return true;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PREVIEW_CACHE_H
+#define PREVIEW_CACHE_H
+
+#include <Locker.h>
+#include <SupportDefs.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+class BBitmap;
+
+
+// Application-wide store for tab preview thumbnails, keyed by tab id.
+//
+// Recently used previews are kept as ready to draw bitmaps. Once those
+// exceed half of the memory budget, the least recently used ones are
+// run-length encoded; if the budget is still exceeded, the oldest encoded
+// previews are dropped and will be captured again the next time their tab
+// is left. Encoded previews are decoded again on first access.
+//
+// Bitmaps are handed out as shared pointers, so a preview being displayed
+// stays valid even if the cache evicts it meanwhile.
+//
+// A second instance holds the larger snapshots which stand in for the page
+// of a discarded tab while it is being loaded again.
+class PreviewCache {
+public:
+	typedef std::shared_ptr<const BBitmap> PreviewRef;
+
+								PreviewCache(size_t budget = kDefaultBudget);
+								~PreviewCache();
+
+	static	PreviewCache&		Default();
+	static	PreviewCache&		Snapshots();
+
+			void				SetBudget(size_t bytes);
+			size_t				Budget();
+
+			void				Put(uint32 tabId, BBitmap* preview);
+			PreviewRef			Get(uint32 tabId, uint32* generation = NULL);
+			uint32				GenerationFor(uint32 tabId);
+			void				Compress(uint32 tabId);
+			void				Remove(uint32 tabId);
+			void				Clear();
+
+			size_t				MemoryUsage();
+			int32				CountEntries();
+			int32				CountCompressedEntries();
+
+	static	const size_t		kDefaultBudget = 8 * 1024 * 1024;
+	static	const size_t		kDefaultSnapshotBudget = 32 * 1024 * 1024;
+	static	const size_t		kLowRAMSnapshotBudget = 8 * 1024 * 1024;
+
+private:
+			struct Entry {
+				Entry();
+
+				PreviewRef			bitmap;
+				std::vector<uint8>	compressed;
+				int32				width;
+				int32				height;
+				uint32				generation;
+				std::list<uint32>::iterator lruPosition;
+			};
+
+			size_t				_EntrySize(const Entry& entry) const;
+			void				_Touch(uint32 tabId, Entry& entry);
+			void				_Unlink(Entry& entry);
+			void				_Enforce(uint32 keepTabId);
+			bool				_Compress(Entry& entry);
+			bool				_Decompress(Entry& entry);
+
+private:
+			BLocker				fLock;
+			std::map<uint32, Entry> fEntries;
+			std::list<uint32>	fLRU;
+				// most recently used first
+			size_t				fBudget;
+			size_t				fHotSize;
+			size_t				fColdSize;
+			uint32				fNextGeneration;
+};
+
+#endif // PREVIEW_CACHE_H
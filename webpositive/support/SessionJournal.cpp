@@ -0,0 +1,391 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "SessionJournal.h"
+
+#include <Entry.h>
+#include <String.h>
+#include <Window.h>
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+
+// Records are stored as their flattened size followed by the flattened
+// message. Anything beyond this is certainly not a record of ours.
+static const int32 kMaxRecordSize = 1024 * 1024;
+
+
+SessionJournal::Window::Window()
+	:
+	id(0),
+	workspaces(B_CURRENT_WORKSPACE),
+	selectedTab(0)
+{
+}
+
+
+SessionJournal::SessionJournal(const BPath& snapshotPath,
+	const BPath& journalPath)
+	:
+	fSnapshotPath(snapshotPath),
+	fJournalPath(journalPath),
+	fPendingRecords(0)
+{
+}
+
+
+SessionJournal::~SessionJournal()
+{
+}
+
+
+bool
+SessionJournal::HasSession() const
+{
+	return BEntry(fSnapshotPath.Path()).Exists()
+		|| BEntry(fJournalPath.Path()).Exists();
+}
+
+
+status_t
+SessionJournal::Recover(BMessage& session)
+{
+	fWindows.clear();
+
+	bool found = false;
+	BFile snapshot(fSnapshotPath.Path(), B_READ_ONLY);
+	BMessage archive;
+	if (snapshot.InitCheck() == B_OK && archive.Unflatten(&snapshot) == B_OK) {
+		_LoadSnapshot(archive);
+		found = true;
+	}
+
+	BFile journal(fJournalPath.Path(), B_READ_ONLY);
+	off_t size;
+	if (journal.InitCheck() == B_OK && journal.GetSize(&size) == B_OK
+		&& size > 0) {
+		char* buffer = new(std::nothrow) char[size];
+		if (buffer == NULL)
+			return B_NO_MEMORY;
+
+		ssize_t bytesRead = journal.Read(buffer, size);
+		off_t offset = 0;
+		while (bytesRead > 0 && offset + (off_t)sizeof(int32) <= bytesRead) {
+			int32 recordSize;
+			memcpy(&recordSize, buffer + offset, sizeof(recordSize));
+			offset += sizeof(recordSize);
+			if (recordSize <= 0 || recordSize > kMaxRecordSize
+				|| offset + recordSize > bytesRead) {
+				// Torn write of the last record before a crash
+				break;
+			}
+
+			BMessage event;
+			if (event.Unflatten(buffer + offset) != B_OK)
+				break;
+			_Apply(event);
+			offset += recordSize;
+			found = true;
+		}
+		delete[] buffer;
+	}
+
+	if (!found)
+		return B_ENTRY_NOT_FOUND;
+
+	_Archive(session);
+	return B_OK;
+}
+
+
+status_t
+SessionJournal::Start()
+{
+	fWindows.clear();
+	fPendingRecords = 0;
+
+	BEntry(fSnapshotPath.Path()).Remove();
+	return fJournal.SetTo(fJournalPath.Path(),
+		B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+}
+
+
+status_t
+SessionJournal::Record(const BMessage& event)
+{
+	// Nothing of a private window may end up on disk, nor come back as a
+	// normal window after a crash
+	if (event.GetBool("private", false))
+		return B_OK;
+
+	status_t status = fJournal.InitCheck();
+	if (status != B_OK)
+		return status;
+
+	_Apply(event);
+
+	// Write the record with a single call, so a crash can at worst leave it
+	// incomplete, which replaying detects.
+	ssize_t flattenedSize = event.FlattenedSize();
+	if (flattenedSize <= 0 || flattenedSize > kMaxRecordSize)
+		return B_BAD_VALUE;
+
+	int32 recordSize = (int32)flattenedSize;
+	char* buffer = new(std::nothrow) char[sizeof(recordSize) + recordSize];
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	memcpy(buffer, &recordSize, sizeof(recordSize));
+	status = event.Flatten(buffer + sizeof(recordSize), recordSize);
+	if (status == B_OK) {
+		ssize_t written = fJournal.Write(buffer,
+			sizeof(recordSize) + recordSize);
+		if (written < 0)
+			status = written;
+		else if (written != (ssize_t)(sizeof(recordSize) + recordSize))
+			status = B_IO_ERROR;
+	}
+	delete[] buffer;
+
+	if (status == B_OK && ++fPendingRecords >= kCompactionThreshold)
+		status = Compact();
+	return status;
+}
+
+
+status_t
+SessionJournal::Compact()
+{
+	status_t status = fJournal.InitCheck();
+	if (status != B_OK)
+		return status;
+
+	BMessage session;
+	_Archive(session);
+
+	// Write the new snapshot next to the old one and move it over it, so
+	// there always is a complete snapshot on disk.
+	BString tempPath(fSnapshotPath.Path());
+	tempPath << ".new";
+	BFile snapshot(tempPath.String(),
+		B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status = snapshot.InitCheck();
+	if (status == B_OK)
+		status = session.Flatten(&snapshot);
+	if (status == B_OK)
+		status = snapshot.Sync();
+	snapshot.Unset();
+
+	BEntry entry(tempPath.String());
+	if (status == B_OK)
+		status = entry.Rename(fSnapshotPath.Leaf(), true);
+	if (status != B_OK) {
+		entry.Remove();
+		return status;
+	}
+
+	status = fJournal.SetSize(0);
+	if (status == B_OK) {
+		fJournal.Seek(0, SEEK_SET);
+		fPendingRecords = 0;
+	}
+	return status;
+}
+
+
+void
+SessionJournal::Discard()
+{
+	fJournal.Unset();
+	fWindows.clear();
+	fPendingRecords = 0;
+
+	BEntry(fJournalPath.Path()).Remove();
+	BEntry(fSnapshotPath.Path()).Remove();
+}
+
+
+void
+SessionJournal::_Apply(const BMessage& event)
+{
+	uint32 windowId = event.GetUInt32("window", 0);
+	uint32 tabId = event.GetUInt32("tab", 0);
+
+	switch (event.what) {
+		case kWindowOpened:
+		case kWindowChanged:
+		{
+			Window* window = _FindWindow(windowId,
+				event.what == kWindowOpened);
+			if (window == NULL)
+				break;
+			window->frame = event.GetRect("frame", window->frame);
+			window->workspaces = event.GetUInt32("workspaces",
+				window->workspaces);
+			break;
+		}
+
+		case kWindowClosed:
+			for (size_t i = 0; i < fWindows.size(); i++) {
+				if (fWindows[i].id == windowId) {
+					fWindows.erase(fWindows.begin() + i);
+					break;
+				}
+			}
+			break;
+
+		case kTabOpened:
+		case kTabMoved:
+		{
+			Window* window = _FindWindow(windowId, event.what == kTabOpened);
+			if (window == NULL)
+				break;
+
+			Tab tab;
+			tab.id = tabId;
+			int32 index = _IndexOfTab(*window, tabId);
+			if (index >= 0) {
+				tab.state = window->tabs[index].state;
+				window->tabs.erase(window->tabs.begin() + index);
+			} else if (event.what == kTabMoved)
+				break;
+
+			if (event.what == kTabOpened)
+				event.FindMessage("state", &tab.state);
+
+			index = event.GetInt32("index", -1);
+			if (index < 0 || index > (int32)window->tabs.size())
+				index = window->tabs.size();
+			window->tabs.insert(window->tabs.begin() + index, tab);
+			break;
+		}
+
+		case kTabClosed:
+		{
+			Window* window = _FindWindow(windowId, false);
+			if (window == NULL)
+				break;
+			int32 index = _IndexOfTab(*window, tabId);
+			if (index >= 0)
+				window->tabs.erase(window->tabs.begin() + index);
+			if (window->selectedTab == tabId)
+				window->selectedTab = 0;
+			break;
+		}
+
+		case kTabNavigated:
+		{
+			Window* window = _FindWindow(windowId, false);
+			if (window == NULL)
+				break;
+			int32 index = _IndexOfTab(*window, tabId);
+			if (index >= 0)
+				event.FindMessage("state", &window->tabs[index].state);
+			break;
+		}
+
+		case kTabSelected:
+		{
+			Window* window = _FindWindow(windowId, false);
+			if (window != NULL)
+				window->selectedTab = tabId;
+			break;
+		}
+	}
+}
+
+
+SessionJournal::Window*
+SessionJournal::_FindWindow(uint32 id, bool create)
+{
+	for (size_t i = 0; i < fWindows.size(); i++) {
+		if (fWindows[i].id == id)
+			return &fWindows[i];
+	}
+
+	if (!create)
+		return NULL;
+
+	try {
+		fWindows.push_back(Window());
+	} catch (...) {
+		return NULL;
+	}
+	fWindows.back().id = id;
+	return &fWindows.back();
+}
+
+
+int32
+SessionJournal::_IndexOfTab(const Window& window, uint32 tabId) const
+{
+	for (size_t i = 0; i < window.tabs.size(); i++) {
+		if (window.tabs[i].id == tabId)
+			return i;
+	}
+	return -1;
+}
+
+
+void
+SessionJournal::_LoadSnapshot(const BMessage& archive)
+{
+	BMessage windowArchive;
+	for (int32 i = 0; archive.FindMessage("window", i, &windowArchive) == B_OK;
+			i++) {
+		Window* window = _FindWindow(windowArchive.GetUInt32("window id", 0),
+			true);
+		if (window == NULL)
+			break;
+		window->frame = windowArchive.GetRect("window frame", BRect());
+		window->workspaces = windowArchive.GetUInt32("window workspaces",
+			B_CURRENT_WORKSPACE);
+
+		int32 selectedIndex = windowArchive.GetInt32("selected tab", 0);
+		Tab tab;
+		for (int32 j = 0; windowArchive.FindMessage("tab state", j, &tab.state)
+				== B_OK; j++) {
+			tab.id = tab.state.GetUInt32("id", 0);
+			tab.state.RemoveName("id");
+			window->tabs.push_back(tab);
+			if (j == selectedIndex)
+				window->selectedTab = tab.id;
+		}
+	}
+}
+
+
+void
+SessionJournal::_Archive(BMessage& session) const
+{
+	// Produces the same layout as BrowserWindow::Archive(), plus the ids
+	// needed to replay the journal against it.
+	for (size_t i = 0; i < fWindows.size(); i++) {
+		const Window& window = fWindows[i];
+		if (window.tabs.empty())
+			continue;
+
+		BMessage windowArchive;
+		windowArchive.AddRect("window frame", window.frame);
+		windowArchive.AddUInt32("window workspaces", window.workspaces);
+		windowArchive.AddUInt32("window id", window.id);
+
+		int32 selectedIndex = 0;
+		for (size_t j = 0; j < window.tabs.size(); j++) {
+			const Tab& tab = window.tabs[j];
+			BMessage state(tab.state);
+			state.AddUInt32("id", tab.id);
+			windowArchive.AddString("tab", state.GetString("url", ""));
+			windowArchive.AddMessage("tab state", &state);
+			if (tab.id == window.selectedTab)
+				selectedIndex = j;
+		}
+		windowArchive.AddInt32("selected tab", selectedIndex);
+
+		session.AddMessage("window", &windowArchive);
+	}
+}
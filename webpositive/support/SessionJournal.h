@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SESSION_JOURNAL_H
+#define SESSION_JOURNAL_H
+
+#include <File.h>
+#include <Message.h>
+#include <Path.h>
+#include <Rect.h>
+
+#include <vector>
+
+
+// Crash recovery log of the browsing session.
+//
+// Windows report every change to their tabs as a small record message, which
+// is applied to an in-memory copy of the session and appended to the journal
+// file right away. Every so often the journal is compacted: the in-memory
+// session is written as a snapshot and the journal starts over. Recovering
+// reads the snapshot and replays the journal on top of it; a record that was
+// cut short by a crash is ignored, so at most the last event is lost.
+//
+// Replaying a record twice has no further effect, which keeps recovery
+// correct if the application died between writing a snapshot and
+// truncating the journal. Records marked "private" are not recorded at all.
+class SessionJournal {
+public:
+	enum {
+		kWindowOpened	= 'sjwo',
+		kWindowClosed	= 'sjwc',
+		kWindowChanged	= 'sjwm',
+		kTabOpened		= 'sjto',
+		kTabClosed		= 'sjtc',
+		kTabNavigated	= 'sjtn',
+		kTabMoved		= 'sjtm',
+		kTabSelected	= 'sjts'
+	};
+
+									SessionJournal(const BPath& snapshotPath,
+										const BPath& journalPath);
+									~SessionJournal();
+
+			bool					HasSession() const;
+			status_t				Recover(BMessage& session);
+
+			status_t				Start();
+			status_t				Record(const BMessage& event);
+			status_t				Compact();
+			void					Discard();
+
+			int32					CountPendingRecords() const
+										{ return fPendingRecords; }
+
+	static	const int32				kCompactionThreshold = 500;
+
+private:
+			struct Tab {
+				uint32				id;
+				BMessage			state;
+			};
+
+			struct Window {
+									Window();
+
+				uint32				id;
+				BRect				frame;
+				uint32				workspaces;
+				uint32				selectedTab;
+				std::vector<Tab>	tabs;
+			};
+
+			void					_Apply(const BMessage& event);
+			Window*					_FindWindow(uint32 id, bool create);
+			int32					_IndexOfTab(const Window& window,
+										uint32 tabId) const;
+			void					_LoadSnapshot(const BMessage& archive);
+			void					_Archive(BMessage& session) const;
+
+private:
+			BPath					fSnapshotPath;
+			BPath					fJournalPath;
+			BFile					fJournal;
+			int32					fPendingRecords;
+			std::vector<Window>		fWindows;
+};
+
+#endif // SESSION_JOURNAL_H
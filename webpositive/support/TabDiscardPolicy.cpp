@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "TabDiscardPolicy.h"
+
+#include <algorithm>
+
+
+// WebKit offers no way to query the memory used by a single page, so it is
+// estimated from a fixed overhead per page plus a share per DOM node.
+static const uint64 kBasePageCost = 24 * 1024 * 1024;
+static const uint64 kCostPerNode = 2 * 1024;
+
+
+static bool
+activatedEarlier(const TabDiscardPolicy::TabInfo& a,
+	const TabDiscardPolicy::TabInfo& b)
+{
+	return a.lastActivation < b.lastActivation;
+}
+
+
+TabDiscardPolicy::TabInfo::TabInfo()
+	:
+	id(0),
+	lastActivation(0),
+	estimatedCost(0),
+	loaded(true),
+	current(false),
+	loading(false),
+	pinned(false),
+	playingMedia(false),
+	dirtyForm(false)
+{
+}
+
+
+TabDiscardPolicy::TabDiscardPolicy()
+	:
+	fTargetPercent(kDefaultTargetPercent),
+	fTriggerPercent(kDefaultTriggerPercent)
+{
+}
+
+
+void
+TabDiscardPolicy::SetTargetPercent(int32 percent)
+{
+	fTargetPercent = std::max((int32)0, std::min(percent, (int32)100));
+	if (fTriggerPercent < fTargetPercent)
+		fTriggerPercent = fTargetPercent;
+}
+
+
+void
+TabDiscardPolicy::SetTriggerPercent(int32 percent)
+{
+	fTriggerPercent = std::max(fTargetPercent, std::min(percent, (int32)100));
+}
+
+
+bool
+TabDiscardPolicy::IsUnderPressure(uint64 used, uint64 total) const
+{
+	return total > 0 && used * 100 > total * (uint64)fTriggerPercent;
+}
+
+
+uint64
+TabDiscardPolicy::TargetBytes(uint64 total) const
+{
+	return total / 100 * (uint64)fTargetPercent;
+}
+
+
+bool
+TabDiscardPolicy::IsDiscardable(const TabInfo& tab) const
+{
+	return tab.loaded && !tab.current && !tab.loading && !tab.pinned
+		&& !tab.playingMedia && !tab.dirtyForm;
+}
+
+
+std::vector<uint32>
+TabDiscardPolicy::SelectVictims(std::vector<TabInfo> tabs, uint64 used,
+	uint64 target) const
+{
+	std::vector<uint32> victims;
+	if (used <= target)
+		return victims;
+
+	std::stable_sort(tabs.begin(), tabs.end(), activatedEarlier);
+
+	uint64 freed = 0;
+	for (size_t i = 0; i < tabs.size() && used - freed > target; i++) {
+		if (!IsDiscardable(tabs[i]))
+			continue;
+		victims.push_back(tabs[i].id);
+		freed = std::min(used, freed + tabs[i].estimatedCost);
+	}
+	return victims;
+}
+
+
+/*static*/ uint64
+TabDiscardPolicy::EstimateCost(int32 domNodes)
+{
+	return kBasePageCost + (uint64)std::max(domNodes, (int32)0) * kCostPerNode;
+}
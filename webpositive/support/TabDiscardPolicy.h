@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TAB_DISCARD_POLICY_H
+#define TAB_DISCARD_POLICY_H
+
+#include <SupportDefs.h>
+
+#include <vector>
+
+
+// Decides which tabs to unload when memory runs low.
+//
+// Tabs are considered least recently activated first. Tabs which cannot be
+// restored without losing something, or which the user would notice being
+// unloaded (the visible tab, pinned tabs, tabs playing media or with edited
+// form fields, pages still loading), are never picked. Tabs are picked one
+// at a time, until the estimated memory they use adds up to what is needed
+// to get below the target.
+class TabDiscardPolicy {
+public:
+	struct TabInfo {
+								TabInfo();
+
+			uint32				id;
+			bigtime_t			lastActivation;
+			uint64				estimatedCost;
+			bool				loaded;
+			bool				current;
+			bool				loading;
+			bool				pinned;
+			bool				playingMedia;
+			bool				dirtyForm;
+	};
+
+								TabDiscardPolicy();
+
+			void				SetTargetPercent(int32 percent);
+			int32				TargetPercent() const
+									{ return fTargetPercent; }
+			void				SetTriggerPercent(int32 percent);
+			int32				TriggerPercent() const
+									{ return fTriggerPercent; }
+
+			bool				IsUnderPressure(uint64 used,
+									uint64 total) const;
+			uint64				TargetBytes(uint64 total) const;
+
+			bool				IsDiscardable(const TabInfo& tab) const;
+			std::vector<uint32>	SelectVictims(std::vector<TabInfo> tabs,
+									uint64 used, uint64 target) const;
+
+	static	uint64				EstimateCost(int32 domNodes);
+
+	static	const int32			kDefaultTargetPercent = 80;
+	static	const int32			kDefaultTriggerPercent = 90;
+
+private:
+			int32				fTargetPercent;
+			int32				fTriggerPercent;
+};
+
+#endif // TAB_DISCARD_POLICY_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "TabRegistry.h"
+
+
+TabRegistry::TabRegistry()
+{
+}
+
+
+void
+TabRegistry::Update(uint32 windowId, const TabDiscardPolicy::TabInfo& tab)
+{
+	if (tab.id == 0)
+		return;
+
+	try {
+		Entry& entry = fTabs[tab.id];
+		entry.windowId = windowId;
+		entry.tab = tab;
+	} catch (...) {
+	}
+}
+
+
+void
+TabRegistry::Remove(uint32 tabId)
+{
+	fTabs.erase(tabId);
+}
+
+
+void
+TabRegistry::RemoveWindow(uint32 windowId)
+{
+	std::map<uint32, Entry>::iterator it = fTabs.begin();
+	while (it != fTabs.end()) {
+		if (it->second.windowId == windowId)
+			fTabs.erase(it++);
+		else
+			it++;
+	}
+}
+
+
+int32
+TabRegistry::CountTabs() const
+{
+	return (int32)fTabs.size();
+}
+
+
+int32
+TabRegistry::CountLoadedTabs() const
+{
+	int32 count = 0;
+	std::map<uint32, Entry>::const_iterator it = fTabs.begin();
+	for (; it != fTabs.end(); it++) {
+		if (it->second.tab.loaded)
+			count++;
+	}
+	return count;
+}
+
+
+uint64
+TabRegistry::EstimatedUsage() const
+{
+	uint64 usage = 0;
+	std::map<uint32, Entry>::const_iterator it = fTabs.begin();
+	for (; it != fTabs.end(); it++) {
+		if (it->second.tab.loaded)
+			usage += it->second.tab.estimatedCost;
+	}
+	return usage;
+}
+
+
+std::vector<TabRegistry::Victim>
+TabRegistry::SelectVictims(const TabDiscardPolicy& policy, uint64 used,
+	uint64 target) const
+{
+	std::vector<Victim> victims;
+
+	std::vector<TabDiscardPolicy::TabInfo> tabs;
+	try {
+		tabs.reserve(fTabs.size());
+		std::map<uint32, Entry>::const_iterator it = fTabs.begin();
+		for (; it != fTabs.end(); it++)
+			tabs.push_back(it->second.tab);
+	} catch (...) {
+		return victims;
+	}
+
+	std::vector<uint32> ids = policy.SelectVictims(tabs, used, target);
+	for (size_t i = 0; i < ids.size(); i++) {
+		Victim victim;
+		victim.windowId = fTabs.find(ids[i])->second.windowId;
+		victim.tabId = ids[i];
+		try {
+			victims.push_back(victim);
+		} catch (...) {
+			break;
+		}
+	}
+	return victims;
+}
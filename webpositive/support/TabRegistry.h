@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TAB_REGISTRY_H
+#define TAB_REGISTRY_H
+
+#include <SupportDefs.h>
+
+#include <map>
+#include <vector>
+
+#include "TabDiscardPolicy.h"
+
+
+// Application-wide record of the tabs of all windows.
+//
+// Windows report every change of a tab which matters for unloading it, so
+// memory pressure can be handled in one place: a single budget applies to
+// all tabs, and the least recently used ones are unloaded first no matter
+// which window they belong to.
+class TabRegistry {
+public:
+	struct Victim {
+			uint32				windowId;
+			uint32				tabId;
+	};
+
+								TabRegistry();
+
+			void				Update(uint32 windowId,
+									const TabDiscardPolicy::TabInfo& tab);
+			void				Remove(uint32 tabId);
+			void				RemoveWindow(uint32 windowId);
+
+			int32				CountTabs() const;
+			int32				CountLoadedTabs() const;
+			uint64				EstimatedUsage() const;
+
+			std::vector<Victim>	SelectVictims(const TabDiscardPolicy& policy,
+									uint64 used, uint64 target) const;
+
+private:
+			struct Entry {
+				uint32				windowId;
+				TabDiscardPolicy::TabInfo tab;
+			};
+
+			std::map<uint32, Entry> fTabs;
+};
+
+#endif // TAB_REGISTRY_H
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "TabSearchIndex.h"
+
+#include <algorithm>
+#include <string.h>
+
+
+static const int32 kConsecutiveBonus = 5;
+static const int32 kWordStartBonus = 3;
+
+
+static bool
+isWordStart(const BString& text, int32 position)
+{
+	if (position == 0)
+		return true;
+	char previous = text[position - 1];
+	return previous == ' ' || previous == '/' || previous == '.'
+		|| previous == '-' || previous == '_' || previous == ':'
+		|| previous == '?' || previous == '=';
+}
+
+
+static bool
+betterMatch(const TabSearchIndex::Match& a, const TabSearchIndex::Match& b)
+{
+	return a.score > b.score;
+}
+
+
+TabSearchIndex::TabSearchIndex()
+	:
+	fLastMatchesValid(false),
+	fLastCandidateCount(0)
+{
+}
+
+
+void
+TabSearchIndex::SetWindowTabs(uint32 windowId, const std::vector<Tab>& tabs)
+{
+	// Keep the window's place among the others if it was known before
+	size_t position = fTabs.size();
+	for (size_t i = 0; i < fTabs.size(); i++) {
+		if (fTabs[i].tab.windowId == windowId) {
+			position = i;
+			break;
+		}
+	}
+	RemoveWindow(windowId);
+
+	std::vector<Entry> entries;
+	for (size_t i = 0; i < tabs.size(); i++) {
+		Entry entry;
+		entry.tab = tabs[i];
+		entry.tab.windowId = windowId;
+		entry.lowerTitle = tabs[i].title;
+		entry.lowerTitle.ToLower();
+		entry.lowerURL = tabs[i].url;
+		entry.lowerURL.ToLower();
+		entries.push_back(entry);
+	}
+	fTabs.insert(fTabs.begin() + std::min(position, fTabs.size()),
+		entries.begin(), entries.end());
+	_Invalidate();
+}
+
+
+void
+TabSearchIndex::RemoveWindow(uint32 windowId)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < fTabs.size(); i++) {
+		if (fTabs[i].tab.windowId != windowId) {
+			if (kept != i)
+				fTabs[kept] = fTabs[i];
+			kept++;
+		}
+	}
+	fTabs.resize(kept);
+	_Invalidate();
+}
+
+
+void
+TabSearchIndex::Clear()
+{
+	fTabs.clear();
+	_Invalidate();
+}
+
+
+std::vector<TabSearchIndex::Match>
+TabSearchIndex::Search(const char* query)
+{
+	BString lowerQuery(query);
+	lowerQuery.ToLower();
+
+	std::vector<Match> matches;
+	std::vector<int32> matched;
+
+	bool narrowing = fLastMatchesValid && fLastQuery.Length() > 0
+		&& lowerQuery.Length() > fLastQuery.Length()
+		&& strncmp(lowerQuery.String(), fLastQuery.String(),
+			fLastQuery.Length()) == 0;
+	int32 candidateCount = narrowing
+		? (int32)fLastMatches.size() : CountTabs();
+
+	for (int32 i = 0; i < candidateCount; i++) {
+		int32 index = narrowing ? fLastMatches[i] : i;
+		int32 score = lowerQuery.Length() == 0
+			? 0 : _Score(fTabs[index], lowerQuery);
+		if (score < 0)
+			continue;
+
+		Match match;
+		match.index = index;
+		match.score = score;
+		matches.push_back(match);
+		matched.push_back(index);
+	}
+
+	// Tabs of equal score stay in window and tab order
+	std::stable_sort(matches.begin(), matches.end(), betterMatch);
+
+	fLastQuery = lowerQuery;
+	fLastMatches.swap(matched);
+	fLastMatchesValid = true;
+	fLastCandidateCount = candidateCount;
+	return matches;
+}
+
+
+/*static*/ int32
+TabSearchIndex::Score(const BString& text, const BString& query)
+{
+	// Both are expected in lower case. Returns -1 if the query does not
+	// match at all.
+	int32 length = text.Length();
+	int32 queryLength = query.Length();
+	if (queryLength == 0)
+		return 0;
+	if (queryLength > length)
+		return -1;
+
+	int32 score = 0;
+	int32 position = 0;
+	int32 previous = -2;
+	for (int32 i = 0; i < queryLength; i++) {
+		char c = query[i];
+		while (position < length && text[position] != c)
+			position++;
+		if (position == length)
+			return -1;
+
+		score++;
+		if (position == previous + 1)
+			score += kConsecutiveBonus;
+		if (isWordStart(text, position))
+			score += kWordStartBonus;
+		previous = position;
+		position++;
+	}
+
+	// The greedy walk above may have missed a contiguous occurrence
+	int32 substring = text.FindFirst(query.String());
+	if (substring >= 0) {
+		score = std::max(score,
+			queryLength * (1 + kConsecutiveBonus) + (isWordStart(text,
+				substring) ? kWordStartBonus : 0));
+	}
+	return score;
+}
+
+
+int32
+TabSearchIndex::_Score(const Entry& entry, const BString& query) const
+{
+	int32 titleScore = Score(entry.lowerTitle, query);
+	int32 urlScore = Score(entry.lowerURL, query);
+	if (urlScore > 0)
+		urlScore = urlScore * 3 / 4;
+	return std::max(titleScore, urlScore);
+}
+
+
+void
+TabSearchIndex::_Invalidate()
+{
+	fLastMatchesValid = false;
+	fLastMatches.clear();
+}
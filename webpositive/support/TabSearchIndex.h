@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TAB_SEARCH_INDEX_H
+#define TAB_SEARCH_INDEX_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+
+// Searchable snapshot of the titles and URLs of the tabs of all windows.
+//
+// Queries match fuzzily: all characters of the query have to appear in
+// order, and matches score higher when the characters follow each other,
+// start words, or hit the title rather than the URL. When a query extends
+// the previous one, only the previous matches are searched again, since
+// nothing else can match the longer query.
+class TabSearchIndex {
+public:
+	struct Tab {
+			uint32				windowId;
+			uint32				tabId;
+			BString				title;
+			BString				url;
+	};
+
+	struct Match {
+			int32				index;
+			int32				score;
+	};
+
+								TabSearchIndex();
+
+			void				SetWindowTabs(uint32 windowId,
+									const std::vector<Tab>& tabs);
+			void				RemoveWindow(uint32 windowId);
+			void				Clear();
+
+			int32				CountTabs() const
+									{ return (int32)fTabs.size(); }
+			const Tab&			TabAt(int32 index) const
+									{ return fTabs[index].tab; }
+
+			std::vector<Match>	Search(const char* query);
+			int32				LastCandidateCount() const
+									{ return fLastCandidateCount; }
+
+	static	int32				Score(const BString& text,
+									const BString& query);
+
+private:
+			struct Entry {
+				Tab					tab;
+				BString				lowerTitle;
+				BString				lowerURL;
+			};
+
+			int32				_Score(const Entry& entry,
+									const BString& query) const;
+			void				_Invalidate();
+
+private:
+			std::vector<Entry>	fTabs;
+			BString				fLastQuery;
+			std::vector<int32>	fLastMatches;
+			bool				fLastMatchesValid;
+			int32				fLastCandidateCount;
+};
+
+#endif // TAB_SEARCH_INDEX_H
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "ThumbnailScaler.h"
+
+#include <new>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#	define THUMBNAIL_SCALER_X86 1
+#	include <immintrin.h>
+#endif
+
+
+static const int32 kBytesPerPixel = 4;
+
+// Row sums are kept in 16 bit so twice as many fit into a vector register;
+// this many rows of 8 bit values can be added up before they could overflow.
+static const int32 kMaxRowsPerBatch = 65535 / 255;
+
+
+static void
+_AccumulateRowScalar(uint16* accumulator, const uint8* row, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		accumulator[i] += row[i];
+}
+
+
+#ifdef THUMBNAIL_SCALER_X86
+
+__attribute__((target("sse2")))
+static void
+_AccumulateRowSSE2(uint16* accumulator, const uint8* row, int32 count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int32 i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i* sums = (__m128i*)(accumulator + i);
+		_mm_storeu_si128(sums, _mm_add_epi16(_mm_loadu_si128(sums),
+			_mm_unpacklo_epi8(bytes, zero)));
+		_mm_storeu_si128(sums + 1, _mm_add_epi16(_mm_loadu_si128(sums + 1),
+			_mm_unpackhi_epi8(bytes, zero)));
+	}
+	_AccumulateRowScalar(accumulator + i, row + i, count - i);
+}
+
+
+__attribute__((target("avx2")))
+static void
+_AccumulateRowAVX2(uint16* accumulator, const uint8* row, int32 count)
+{
+	int32 i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i low = _mm256_cvtepu8_epi16(
+			_mm_loadu_si128((const __m128i*)(row + i)));
+		__m256i high = _mm256_cvtepu8_epi16(
+			_mm_loadu_si128((const __m128i*)(row + i + 16)));
+
+		__m256i* sums = (__m256i*)(accumulator + i);
+		_mm256_storeu_si256(sums,
+			_mm256_add_epi16(_mm256_loadu_si256(sums), low));
+		_mm256_storeu_si256(sums + 1,
+			_mm256_add_epi16(_mm256_loadu_si256(sums + 1), high));
+	}
+	_AccumulateRowScalar(accumulator + i, row + i, count - i);
+}
+
+#endif // THUMBNAIL_SCALER_X86
+
+
+typedef void (*AccumulateRowFunction)(uint16*, const uint8*, int32);
+
+
+static AccumulateRowFunction
+_AccumulateFunctionFor(int32 path)
+{
+#ifdef THUMBNAIL_SCALER_X86
+	if (path == ThumbnailScaler::kPathAVX2)
+		return _AccumulateRowAVX2;
+	if (path == ThumbnailScaler::kPathSSE2)
+		return _AccumulateRowSSE2;
+#endif
+	return _AccumulateRowScalar;
+}
+
+
+template<typename Sum>
+static void
+_AverageColumns(const Sum* accumulator, const int32* columnStart,
+	int32 destWidth, uint32 rowCount, uint8* destRow)
+{
+	for (int32 x = 0; x < destWidth; x++) {
+		int32 firstColumn = columnStart[x];
+		int32 lastColumn = columnStart[x + 1];
+		if (lastColumn <= firstColumn)
+			lastColumn = firstColumn + 1;
+
+		uint32 sum[kBytesPerPixel] = { 0, 0, 0, 0 };
+		const Sum* column = accumulator + firstColumn * kBytesPerPixel;
+		for (int32 i = firstColumn; i < lastColumn; i++) {
+			sum[0] += column[0];
+			sum[1] += column[1];
+			sum[2] += column[2];
+			sum[3] += column[3];
+			column += kBytesPerPixel;
+		}
+
+		const uint32 area = rowCount * (lastColumn - firstColumn);
+		for (int32 channel = 0; channel < kBytesPerPixel; channel++)
+			destRow[channel] = (uint8)((sum[channel] + area / 2) / area);
+		destRow += kBytesPerPixel;
+	}
+}
+
+
+/*static*/ bool
+ThumbnailScaler::IsPathSupported(int32 path)
+{
+	switch (path) {
+		case kPathScalar:
+			return true;
+#ifdef THUMBNAIL_SCALER_X86
+		case kPathSSE2:
+			return __builtin_cpu_supports("sse2");
+		case kPathAVX2:
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+
+/*static*/ int32
+ThumbnailScaler::BestPath()
+{
+	static int32 sBestPath = -1;
+	if (sBestPath < 0) {
+		if (IsPathSupported(kPathAVX2))
+			sBestPath = kPathAVX2;
+		else if (IsPathSupported(kPathSSE2))
+			sBestPath = kPathSSE2;
+		else
+			sBestPath = kPathScalar;
+	}
+	return sBestPath;
+}
+
+
+/*static*/ status_t
+ThumbnailScaler::Scale(const uint8* source, int32 sourceWidth,
+	int32 sourceHeight, int32 sourceBytesPerRow, uint8* dest, int32 destWidth,
+	int32 destHeight, int32 destBytesPerRow)
+{
+	return ScaleWithPath(BestPath(), source, sourceWidth, sourceHeight,
+		sourceBytesPerRow, dest, destWidth, destHeight, destBytesPerRow);
+}
+
+
+/*static*/ status_t
+ThumbnailScaler::ScaleWithPath(int32 path, const uint8* source,
+	int32 sourceWidth, int32 sourceHeight, int32 sourceBytesPerRow,
+	uint8* dest, int32 destWidth, int32 destHeight, int32 destBytesPerRow)
+{
+	if (source == NULL || dest == NULL || sourceWidth <= 0
+		|| sourceHeight <= 0 || destWidth <= 0 || destHeight <= 0
+		|| sourceBytesPerRow < sourceWidth * kBytesPerPixel
+		|| destBytesPerRow < destWidth * kBytesPerPixel) {
+		return B_BAD_VALUE;
+	}
+
+	if (!IsPathSupported(path))
+		path = kPathScalar;
+	AccumulateRowFunction accumulateRow = _AccumulateFunctionFor(path);
+
+	const int32 rowValues = sourceWidth * kBytesPerPixel;
+	uint16* accumulator = new(std::nothrow) uint16[rowValues];
+	int32* columnStart = new(std::nothrow) int32[destWidth + 1];
+	if (accumulator == NULL || columnStart == NULL) {
+		delete[] accumulator;
+		delete[] columnStart;
+		return B_NO_MEMORY;
+	}
+
+	// Extreme reduction factors need more rows per destination row than the
+	// 16 bit sums can hold; those batches are then added up in 32 bit.
+	uint32* wideAccumulator = NULL;
+	if ((sourceHeight + destHeight - 1) / destHeight > kMaxRowsPerBatch) {
+		wideAccumulator = new(std::nothrow) uint32[rowValues];
+		if (wideAccumulator == NULL) {
+			delete[] accumulator;
+			delete[] columnStart;
+			return B_NO_MEMORY;
+		}
+	}
+
+	// Precompute the source column span of every destination column. When
+	// enlarging, a span would be empty, so it always covers at least one
+	// source column.
+	for (int32 x = 0; x <= destWidth; x++)
+		columnStart[x] = (int32)((int64)x * sourceWidth / destWidth);
+
+	for (int32 y = 0; y < destHeight; y++) {
+		int32 firstRow = (int32)((int64)y * sourceHeight / destHeight);
+		int32 lastRow = (int32)((int64)(y + 1) * sourceHeight / destHeight);
+		if (lastRow <= firstRow)
+			lastRow = firstRow + 1;
+		const uint32 rowCount = lastRow - firstRow;
+		uint8* destRow = dest + y * destBytesPerRow;
+
+		if (wideAccumulator == NULL) {
+			memset(accumulator, 0, rowValues * sizeof(uint16));
+			for (int32 row = firstRow; row < lastRow; row++) {
+				accumulateRow(accumulator, source + row * sourceBytesPerRow,
+					rowValues);
+			}
+			_AverageColumns(accumulator, columnStart, destWidth, rowCount,
+				destRow);
+			continue;
+		}
+
+		memset(wideAccumulator, 0, rowValues * sizeof(uint32));
+		for (int32 row = firstRow; row < lastRow;) {
+			int32 batchEnd = row + kMaxRowsPerBatch;
+			if (batchEnd > lastRow)
+				batchEnd = lastRow;
+
+			memset(accumulator, 0, rowValues * sizeof(uint16));
+			for (; row < batchEnd; row++) {
+				accumulateRow(accumulator, source + row * sourceBytesPerRow,
+					rowValues);
+			}
+			for (int32 i = 0; i < rowValues; i++)
+				wideAccumulator[i] += accumulator[i];
+		}
+		_AverageColumns(wideAccumulator, columnStart, destWidth, rowCount,
+			destRow);
+	}
+
+	delete[] wideAccumulator;
+	delete[] accumulator;
+	delete[] columnStart;
+	return B_OK;
+}
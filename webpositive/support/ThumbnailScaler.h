@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef THUMBNAIL_SCALER_H
+#define THUMBNAIL_SCALER_H
+
+#include <SupportDefs.h>
+
+
+// Area-averaging ("box filter") downscaler for 32 bit pixel buffers, used to
+// turn screen captures of a tab into preview thumbnails. Every destination
+// pixel is the average of the source rectangle it covers, which avoids the
+// aliasing bilinear filtering produces at large reduction factors.
+//
+// The vertical accumulation pass, which touches every source byte, is
+// vectorized with SSE2 or AVX2 when the CPU supports it; the scalar code path
+// produces identical results.
+class ThumbnailScaler {
+public:
+	enum {
+		kPathScalar = 0,
+		kPathSSE2,
+		kPathAVX2
+	};
+
+	static	status_t			Scale(const uint8* source, int32 sourceWidth,
+									int32 sourceHeight, int32 sourceBytesPerRow,
+									uint8* dest, int32 destWidth,
+									int32 destHeight, int32 destBytesPerRow);
+
+	static	status_t			ScaleWithPath(int32 path, const uint8* source,
+									int32 sourceWidth, int32 sourceHeight,
+									int32 sourceBytesPerRow, uint8* dest,
+									int32 destWidth, int32 destHeight,
+									int32 destBytesPerRow);
+
+	static	int32				BestPath();
+	static	bool				IsPathSupported(int32 path);
+};
+
+#endif // THUMBNAIL_SCALER_H
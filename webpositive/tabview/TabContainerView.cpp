@@ -9,6 +9,8 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 #include <Application.h>
 #include <AbstractLayoutItem.h>
 #include <Bitmap.h>
@@ -17,9 +19,11 @@
 #include <Catalog.h>
 #include <ControlLook.h>
 #include <GroupView.h>
+#include <MessageRunner.h>
 #include <SpaceLayoutItem.h>
 #include <Window.h>
 
+#include "TabPreviewPresenter.h"
 #include "TabView.h"
 
 
@@ -31,6 +35,11 @@
 static const float kLeftTabInset = 4;
 static const float kRightTabInset = 4;
 
+// Resting the pointer on a tab for this long suggests it is about to be
+// clicked, so the tab may start loading already.
+static const bigtime_t kWarmUpHoverDelay = 300000;
+static const uint32 kMsgWarmUpHoveredTab = 'twuh';
+
 
 TabContainerView::TabContainerView(Controller* controller)
 	:
@@ -41,7 +50,12 @@ TabContainerView::TabContainerView(Controller* controller)
 	fSelectedTab(NULL),
 	fController(controller),
 	fFirstVisibleTabIndex(0),
-	fPreviewWindow(NULL)
+	fVisibleTabsEnd(0),
+	fPreviewPresenter(new TabPreviewPresenter(this, controller)),
+	fBatchDepth(0),
+	fBatchSelection(-1),
+	fBatchSelectionMoved(false),
+	fBatchTabsAdded(false)
 {
 	SetFlags(Flags() | B_WILL_DRAW | B_FULL_UPDATE_ON_RESIZE);
 	SetViewColor(B_TRANSPARENT_COLOR);
@@ -52,8 +66,10 @@ TabContainerView::TabContainerView(Controller* controller)
 
 TabContainerView::~TabContainerView()
 {
-	if (fPreviewWindow)
-		fPreviewWindow->Quit();
+	for (size_t i = 0; i < fTabs.size(); i++) {
+		fTabs[i]->SetContainerView(NULL);
+		delete fTabs[i];
+	}
 }
 
 
@@ -71,6 +87,23 @@ void
 TabContainerView::MessageReceived(BMessage* message)
 {
 	switch (message->what) {
+		case TabPreviewPresenter::kMsgPrefetchPreviews:
+		{
+			int32 index;
+			if (message->FindInt32("index", &index) == B_OK)
+				fPreviewPresenter->PrefetchAround(index, CountTabs());
+			break;
+		}
+		case kMsgWarmUpHoveredTab:
+		{
+			int32 index;
+			if (message->FindInt32("index", &index) == B_OK && !fMouseDown
+				&& fController != NULL && fLastMouseEventTab != NULL
+				&& IndexOf(fLastMouseEventTab) == index) {
+				fController->WarmUpTab(index);
+			}
+			break;
+		}
 		default:
 			BGroupView::MessageReceived(message);
 	}
@@ -194,83 +227,94 @@ TabContainerView::AddTab(TabView* tab, int32 index)
 {
 	tab->SetContainerView(this);
 
-	if (index == -1)
-		index = GroupLayout()->CountItems() - 1;
+	if (index < 0 || index > CountTabs())
+		index = CountTabs();
 
-	tab->Update();
+	try {
+		fTabs.insert(fTabs.begin() + index, tab);
+	} catch (...) {
+		tab->SetContainerView(NULL);
+		delete tab;
+		return;
+	}
+	_RenumberTabs(index, CountTabs() - 1);
 
-	GroupLayout()->AddItem(index, tab->LayoutItem());
+	if (fBatchDepth > 0) {
+		fBatchTabsAdded = true;
+		if (fSelectedTab != NULL && index <= fSelectedTab->fIndex)
+			fBatchSelectionMoved = true;
+		return;
+	}
 
 	if (fSelectedTab == NULL)
 		SelectTab(tab);
 
-	bool isLast = index == GroupLayout()->CountItems() - 1;
-	if (isLast) {
-		TabLayoutItem* item
-			= dynamic_cast<TabLayoutItem*>(GroupLayout()->ItemAt(index - 1));
-		if (item != NULL)
-			item->Parent()->Update();
-	}
-
+	bool isLast = index == CountTabs() - 1;
+	if (isLast && index > 0)
+		fTabs[index - 1]->Update();
 
 	SetFirstVisibleTabIndex(MaxFirstVisibleTabIndex());
 	_ValidateTabVisibility();
+	tab->Update();
 }
 
 
 TabView*
 TabContainerView::RemoveTab(int32 index)
 {
-	TabLayoutItem* item
-		= dynamic_cast<TabLayoutItem*>(GroupLayout()->RemoveItem(index));
-	if (item == NULL)
+	if (index < 0 || index >= CountTabs())
 		return NULL;
 
+	TabView* removedTab = fTabs[index];
 	BRect dirty(Bounds());
-	dirty.left = item->Frame().left;
-	TabView* removedTab = item->Parent();
+	BLayoutItem* removedItem = removedTab->LayoutItem();
+	if (removedItem->Layout() != NULL) {
+		dirty.left = removedItem->Frame().left;
+		GroupLayout()->RemoveItem(removedItem);
+	}
+	fTabs.erase(fTabs.begin() + index);
+	_RenumberTabs(index, CountTabs() - 1);
+	removedTab->fIndex = -1;
 	removedTab->SetContainerView(NULL);
 
 	if (removedTab == fLastMouseEventTab)
 		fLastMouseEventTab = NULL;
 
+	if (fBatchDepth > 0) {
+		// The new selection is chosen once, when the batch is committed
+		if (removedTab == fSelectedTab) {
+			fSelectedTab = NULL;
+			fBatchSelection = index;
+		} else if (fSelectedTab != NULL && index <= fSelectedTab->fIndex)
+			fBatchSelectionMoved = true;
+		return removedTab;
+	}
+
 	// Update tabs after or before the removed tab.
-	item = dynamic_cast<TabLayoutItem*>(GroupLayout()->ItemAt(index));
-	if (item != NULL) {
+	if (index < CountTabs()) {
 		// This tab is behind the removed tab.
-		TabView* tab = item->Parent();
+		TabView* tab = fTabs[index];
 		tab->Update();
 		if (removedTab == fSelectedTab) {
 			fSelectedTab = NULL;
 			SelectTab(tab);
 		} else if (fController != NULL && tab == fSelectedTab)
 			fController->UpdateSelection(index);
-	} else {
+	} else if (index > 0) {
 		// The removed tab was the last tab.
-		item = dynamic_cast<TabLayoutItem*>(GroupLayout()->ItemAt(index - 1));
-		if (item != NULL) {
-			TabView* tab = item->Parent();
-			tab->Update();
-			if (removedTab == fSelectedTab) {
-				fSelectedTab = NULL;
-				SelectTab(tab);
-			}
+		TabView* tab = fTabs[index - 1];
+		tab->Update();
+		if (removedTab == fSelectedTab) {
+			fSelectedTab = NULL;
+			SelectTab(tab);
 		}
-	}
+	} else if (removedTab == fSelectedTab)
+		fSelectedTab = NULL;
 
 	Invalidate(dirty);
 	_ValidateTabVisibility();
 
-	if (fPreviewWindow != NULL) {
-		if (fPreviewWindow->Lock()) {
-			BView* view = fPreviewWindow->ChildAt(0);
-			if (view != NULL)
-				view->SetViewBitmap(NULL);
-			if (!fPreviewWindow->IsHidden())
-				fPreviewWindow->Hide();
-			fPreviewWindow->Unlock();
-		}
-	}
+	fPreviewPresenter->Invalidate();
 
 	return removedTab;
 }
@@ -279,35 +323,27 @@ TabContainerView::RemoveTab(int32 index)
 TabView*
 TabContainerView::TabAt(int32 index) const
 {
-	TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-		GroupLayout()->ItemAt(index));
-	if (item != NULL)
-		return item->Parent();
+	if (index < 0 || index >= CountTabs())
+		return NULL;
 
-	return NULL;
+	return fTabs[index];
 }
 
 
 int32
 TabContainerView::IndexOf(TabView* tab) const
 {
-	if (tab == NULL || GroupLayout() == NULL)
+	if (tab == NULL || tab->ContainerView() != this)
 		return -1;
 
-	return GroupLayout()->IndexOfItem(tab->LayoutItem());
+	return tab->fIndex;
 }
 
 
 void
 TabContainerView::SelectTab(int32 index)
 {
-	TabView* tab = NULL;
-	TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-		GroupLayout()->ItemAt(index));
-	if (item != NULL)
-		tab = item->Parent();
-
-	SelectTab(tab);
+	SelectTab(TabAt(index));
 }
 
 
@@ -327,12 +363,11 @@ TabContainerView::SelectTab(TabView* tab)
 	if (fSelectedTab != NULL)
 		fSelectedTab->Update();
 
-	int32 index = -1;
-	if (fSelectedTab != NULL)
-		index = GroupLayout()->IndexOfItem(tab->LayoutItem());
-
-	if (!tab->LayoutItem()->IsVisible())
+	int32 index = IndexOf(fSelectedTab);
+	if (index >= 0
+		&& (index < fFirstVisibleTabIndex || index >= fVisibleTabsEnd)) {
 		SetFirstVisibleTabIndex(index);
+	}
 
 	if (fController != NULL)
 		fController->UpdateSelection(index);
@@ -342,47 +377,66 @@ TabContainerView::SelectTab(TabView* tab)
 void
 TabContainerView::SetTabLabel(int32 index, const char* label)
 {
-	TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-		GroupLayout()->ItemAt(index));
-	if (item == NULL)
+	TabView* tab = TabAt(index);
+	if (tab == NULL)
 		return;
 
-	item->Parent()->SetLabel(label);
+	tab->SetLabel(label);
 }
 
 
 status_t
 TabContainerView::MoveTab(int32 fromIndex, int32 toIndex)
 {
-	BGroupLayout* layout = GroupLayout();
-	BLayoutItem* item = layout->RemoveItem(fromIndex);
-	if (item) {
-		if (!layout->AddItem(toIndex, item)) {
-			// Failed to add at new index, try to restore
-			if (!layout->AddItem(fromIndex, item)) {
-				// We lost the item from the layout. Delete the item to avoid a leak.
-				// The caller (TabManager) is responsible for handling the failure
-				// and ensuring the view hierarchy remains consistent.
-				TabLayoutItem* tabItem = dynamic_cast<TabLayoutItem*>(item);
-				if (tabItem != NULL) {
-					TabView* tab = tabItem->Parent();
-					tab->SetContainerView(NULL);
-					delete tab;
-				} else {
-					if (item->View())
-						delete item->View();
-					delete item;
-				}
-				return B_NO_MEMORY;
-			}
-			return B_ERROR;
-		}
-		// Update selection logic or invalidation if needed
-		Invalidate();
-		_ValidateTabVisibility();
-		return B_OK;
+	if (fromIndex < 0 || fromIndex >= CountTabs() || toIndex < 0
+		|| toIndex >= CountTabs()) {
+		return B_BAD_VALUE;
 	}
-	return B_BAD_VALUE;
+
+	// Erasing first leaves room for the insertion, so this cannot fail
+	TabView* tab = fTabs[fromIndex];
+	fTabs.erase(fTabs.begin() + fromIndex);
+	fTabs.insert(fTabs.begin() + toIndex, tab);
+	_RenumberTabs(std::min(fromIndex, toIndex), std::max(fromIndex, toIndex));
+
+	Invalidate();
+	_ValidateTabVisibility();
+	return B_OK;
+}
+
+
+void
+TabContainerView::BeginBatch()
+{
+	// Until the batch is committed, adding and removing tabs only updates
+	// the list of tabs: the layout, the selection and the drawing are
+	// brought up to date once at the end.
+	fBatchDepth++;
+}
+
+
+void
+TabContainerView::CommitBatch()
+{
+	if (fBatchDepth == 0 || --fBatchDepth > 0)
+		return;
+
+	if (fBatchTabsAdded)
+		SetFirstVisibleTabIndex(MaxFirstVisibleTabIndex());
+
+	if (fSelectedTab == NULL && CountTabs() > 0) {
+		SelectTab(std::max((int32)0,
+			std::min(fBatchSelection, CountTabs() - 1)));
+	} else if (fBatchSelectionMoved && fController != NULL)
+		fController->UpdateSelection(IndexOf(fSelectedTab));
+
+	fBatchSelection = -1;
+	fBatchSelectionMoved = false;
+	fBatchTabsAdded = false;
+
+	_ValidateTabVisibility();
+	Invalidate();
+	fPreviewPresenter->Invalidate();
 }
 
 
@@ -417,15 +471,8 @@ TabContainerView::MaxFirstVisibleTabIndex() const
 		return 0;
 	float visibleTabsWidth = 0;
 
-	BGroupLayout* layout = GroupLayout();
-	int32 i = layout->CountItems() - 2;
-	for (; i >= 0; i--) {
-		TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-			layout->ItemAt(i));
-		if (item == NULL)
-			continue;
-
-		float itemWidth = item->MinSize().width;
+	for (int32 i = CountTabs() - 1; i >= 0; i--) {
+		float itemWidth = fTabs[i]->LayoutItem()->MinSize().width;
 		if (availableWidth >= visibleTabsWidth + itemWidth)
 			visibleTabsWidth += itemWidth;
 		else {
@@ -441,49 +488,17 @@ TabContainerView::MaxFirstVisibleTabIndex() const
 void
 TabContainerView::_UpdatePreview(BPoint where)
 {
-	if (!fController)
-		return;
-
 	TabView* tab = _TabAt(where);
 	if (tab == NULL) {
-		if (fPreviewWindow && !fPreviewWindow->IsHidden())
-			fPreviewWindow->Hide();
+		fPreviewPresenter->Hide();
 		return;
 	}
 
 	int32 index = IndexOf(tab);
-	if (index < 0) return;
-
-	const BBitmap* preview = fController->GetPreview(index);
-	if (preview == NULL) {
-		if (fPreviewWindow && !fPreviewWindow->IsHidden())
-			fPreviewWindow->Hide();
+	if (index < 0)
 		return;
-	}
 
-	if (fPreviewWindow == NULL) {
-		fPreviewWindow = new BWindow(BRect(0, 0, 200, 150), "TabPreview",
-			B_BORDERED_WINDOW_LOOK, B_FLOATING_ALL_WINDOW_FEEL,
-			B_NOT_MOVABLE | B_NOT_CLOSABLE | B_NOT_ZOOMABLE | B_NOT_MINIMIZABLE | B_AVOID_FOCUS);
-		BView* view = new BView(fPreviewWindow->Bounds(), "preview", B_FOLLOW_ALL, B_WILL_DRAW);
-		fPreviewWindow->AddChild(view);
-	}
-
-	// Update content (always, even if visible, to allow scrubbing)
-	BView* view = fPreviewWindow->ChildAt(0);
-	if (view->LockLooper()) {
-		view->SetViewBitmap(preview);
-		view->Invalidate();
-		view->UnlockLooper();
-	}
-
-	if (fPreviewWindow->IsHidden()) {
-		// Position below tab
-		BPoint screenPoint = ConvertToScreen(where);
-		// Center horizontally on mouse, place below tab
-		fPreviewWindow->MoveTo(screenPoint.x - 100, screenPoint.y + 20);
-		fPreviewWindow->Show();
-	}
+	fPreviewPresenter->Present(tab, index, ConvertToScreen(where));
 }
 
 
@@ -497,14 +512,7 @@ TabContainerView::CanScrollLeft() const
 bool
 TabContainerView::CanScrollRight() const
 {
-	BGroupLayout* layout = GroupLayout();
-	int32 count = layout->CountItems() - 1;
-	if (count > 0) {
-		TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-			layout->ItemAt(count - 1));
-		return !item->IsVisible();
-	}
-	return false;
+	return fVisibleTabsEnd < CountTabs();
 }
 
 
@@ -512,6 +520,7 @@ void
 TabContainerView::SetController(Controller* controller)
 {
 	fController = controller;
+	fPreviewPresenter->SetController(controller);
 }
 
 
@@ -559,9 +568,14 @@ TabContainerView::_MouseMoved(BPoint where, uint32 _transit,
 		if (fLastMouseEventTab)
 			fLastMouseEventTab->MouseMoved(where, B_EXITED_VIEW, dragMessage);
 		fLastMouseEventTab = tab;
-		if (fLastMouseEventTab)
+		if (fLastMouseEventTab) {
 			fLastMouseEventTab->MouseMoved(where, B_ENTERED_VIEW, dragMessage);
-		else if (fController) {
+
+			BMessage warmUp(kMsgWarmUpHoveredTab);
+			warmUp.AddInt32("index", IndexOf(fLastMouseEventTab));
+			BMessageRunner::StartSending(BMessenger(this), &warmUp,
+				kWarmUpHoverDelay, 1);
+		} else if (fController) {
 			fController->SetToolTip(
 				B_TRANSLATE("Double-click or middle-click to open new tab."));
 		}
@@ -585,29 +599,60 @@ TabContainerView::_UpdateTabVisibility()
 	float availableWidth = _AvailableWidthForTabs();
 	if (availableWidth < 0)
 		return;
+
+	// Only the tabs which fit are part of the layout, so resizing and
+	// scrolling cost as much as the number of visible tabs, no matter how
+	// many tabs there are.
 	float visibleTabsWidth = 0;
+	int32 end = fFirstVisibleTabIndex;
+	for (; end < CountTabs(); end++) {
+		float itemWidth = fTabs[end]->LayoutItem()->MinSize().width;
+		if (availableWidth < visibleTabsWidth + itemWidth)
+			break;
+		visibleTabsWidth += itemWidth;
+	}
 
-	bool canScrollTabsLeft = fFirstVisibleTabIndex > 0;
-	bool canScrollTabsRight = false;
+	_SetLayoutTabs(fFirstVisibleTabIndex, end);
 
+	if (fController) {
+		fController->UpdateTabScrollability(fFirstVisibleTabIndex > 0,
+			fVisibleTabsEnd < CountTabs());
+	}
+}
+
+
+void
+TabContainerView::_SetLayoutTabs(int32 first, int32 end)
+{
+	fVisibleTabsEnd = end;
+
+	// Leave the layout alone if it already shows these tabs
 	BGroupLayout* layout = GroupLayout();
-	int32 count = layout->CountItems() - 1;
+	int32 count = end - first;
+	bool unchanged = layout->CountItems() - 1 == count;
+	for (int32 i = 0; unchanged && i < count; i++)
+		unchanged = layout->ItemAt(i) == fTabs[first + i]->LayoutItem();
+	if (unchanged)
+		return;
+
+	// The glue item at the end stays in place
+	for (int32 i = layout->CountItems() - 2; i >= 0; i--)
+		layout->RemoveItem(i);
 	for (int32 i = 0; i < count; i++) {
-		TabLayoutItem* item = dynamic_cast<TabLayoutItem*>(
-			layout->ItemAt(i));
-		if (i < fFirstVisibleTabIndex)
-			item->SetVisible(false);
-		else {
-			float itemWidth = item->MinSize().width;
-			bool visible = availableWidth >= visibleTabsWidth + itemWidth;
-			item->SetVisible(visible && !canScrollTabsRight);
-			visibleTabsWidth += itemWidth;
-			if (!visible)
-				canScrollTabsRight = true;
+		if (!layout->AddItem(i, fTabs[first + i]->LayoutItem())) {
+			fVisibleTabsEnd = first + i;
+			break;
 		}
 	}
-	if (fController)
-		fController->UpdateTabScrollability(canScrollTabsLeft, canScrollTabsRight);
+	Invalidate();
+}
+
+
+void
+TabContainerView::_RenumberTabs(int32 first, int32 last)
+{
+	for (int32 i = first; i <= last; i++)
+		fTabs[i]->fIndex = i;
 }
 
 
@@ -8,7 +8,11 @@
 
 #include <GroupView.h>
 
+#include <memory>
+#include <vector>
 
+
+class TabPreviewPresenter;
 class TabView;
 
 
@@ -23,7 +27,10 @@ public:
 		virtual	void			UpdateTabScrollability(bool canScrollLeft,
 									bool canScrollRight) = 0;
 		virtual	void			SetToolTip(const BString& text) = 0;
-		virtual const BBitmap*	GetPreview(int32 index) = 0;
+		virtual std::shared_ptr<const BBitmap> GetPreview(int32 index,
+									uint32* generation) = 0;
+		virtual	uint32			PreviewGeneration(int32 index) = 0;
+		virtual	void			WarmUpTab(int32 index) = 0;
 	};
 
 public:
@@ -49,11 +56,12 @@ public:
 			TabView*			TabAt(int32 index) const;
 
 			int32				IndexOf(TabView* tab) const;
+			int32				CountTabs() const
+									{ return (int32)fTabs.size(); }
 
 			int32				FirstTabIndex() { return 0; };
 			int32				LastTabIndex()
-									{ return GroupLayout() == NULL ? -1
-										: GroupLayout()->CountItems() - 1; };
+									{ return CountTabs() - 1; };
 			int32				SelectedTabIndex()
 									{ return fSelectedTab == NULL ? -1
 										: IndexOf(fSelectedTab); };
@@ -67,6 +75,11 @@ public:
 
 			status_t			MoveTab(int32 fromIndex, int32 toIndex);
 
+			void				BeginBatch();
+			void				CommitBatch();
+			bool				IsInBatch() const
+									{ return fBatchDepth > 0; }
+
 			void				SetFirstVisibleTabIndex(int32 index);
 			int32				FirstVisibleTabIndex() const;
 			int32				MaxFirstVisibleTabIndex() const;
@@ -82,6 +95,8 @@ private:
 									const BMessage* dragMessage);
 			void				_ValidateTabVisibility();
 			void				_UpdateTabVisibility();
+			void				_SetLayoutTabs(int32 first, int32 end);
+			void				_RenumberTabs(int32 first, int32 last);
 			float				_AvailableWidthForTabs() const;
 			void				_SendFakeMouseMoved();
 			void				_UpdatePreview(BPoint where);
@@ -93,7 +108,16 @@ private:
 			TabView*			fSelectedTab;
 			Controller*			fController;
 			int32				fFirstVisibleTabIndex;
-			BWindow*			fPreviewWindow;
+			int32				fVisibleTabsEnd;
+			std::vector<TabView*> fTabs;
+				// all tabs; only the visible ones are part of the layout
+			std::unique_ptr<TabPreviewPresenter> fPreviewPresenter;
+
+			int32				fBatchDepth;
+			int32				fBatchSelection;
+				// where the selected tab was, if it was removed in a batch
+			bool				fBatchSelectionMoved;
+			bool				fBatchTabsAdded;
 };
 
 #endif // TAB_CONTAINER_VIEW_H
@@ -260,7 +260,7 @@ public:
 			case MSG_OPEN_TAB_MENU:
 			{
 				BPopUpMenu* tabMenu = new BPopUpMenu("tab menu", true, false);
-				int32 tabCount = fTabContainerView->GetLayout()->CountItems();
+				int32 tabCount = fTabContainerView->CountTabs();
 				for (int32 i = 0; i < tabCount; i++) {
 					TabView* tab = fTabContainerView->TabAt(i);
 					if (tab != NULL) {
@@ -396,9 +396,20 @@ public:
 		fManager->GetTabContainerView()->SetToolTip(fCurrentToolTip.String());
 	}
 
-	virtual const BBitmap* GetPreview(int32 index)
+	virtual std::shared_ptr<const BBitmap> GetPreview(int32 index,
+		uint32* generation)
 	{
-		return fManager->GetPreview(index);
+		return fManager->GetPreview(index, generation);
+	}
+
+	virtual uint32 PreviewGeneration(int32 index)
+	{
+		return fManager->PreviewGeneration(index);
+	}
+
+	virtual void WarmUpTab(int32 index)
+	{
+		fManager->WarmUpTab(index);
 	}
 
 	void CloseTab(int32 index);
@@ -638,14 +649,14 @@ WebTabView::MouseDown(BPoint where, uint32 buttons)
 		msg = new BMessage(CLOSE_OTHER_TABS);
 		msg->AddInt32("tab index", ContainerView()->IndexOf(this));
 		BMenuItem* closeOtherItem = new BMenuItem(B_TRANSLATE("Close other tabs"), msg);
-		closeOtherItem->SetEnabled(ContainerView()->GetLayout()->CountItems() > 1);
+		closeOtherItem->SetEnabled(ContainerView()->CountTabs() > 1);
 		menu->AddItem(closeOtherItem);
 
 		// Close tabs to the right
 		msg = new BMessage(CLOSE_TABS_TO_RIGHT);
 		msg->AddInt32("tab index", ContainerView()->IndexOf(this));
 		BMenuItem* closeRightItem = new BMenuItem(B_TRANSLATE("Close tabs to the right"), msg);
-		closeRightItem->SetEnabled(ContainerView()->IndexOf(this) < ContainerView()->GetLayout()->CountItems() - 1);
+		closeRightItem->SetEnabled(ContainerView()->IndexOf(this) < ContainerView()->LastTabIndex());
 		menu->AddItem(closeRightItem);
 
 		menu->SetTargetForItems(ContainerView()->Window()); // Send to BrowserWindow
@@ -939,13 +950,7 @@ TabManager::ViewForTab(int32 tabIndex) const
 int32
 TabManager::TabForView(const BView* containedView) const
 {
-	int32 count = fCardLayout->CountItems();
-	for (int32 i = 0; i < count; i++) {
-		BLayoutItem* item = fCardLayout->ItemAt(i);
-		if (item->View() == containedView)
-			return i;
-	}
-	return -1;
+	return fViewIndex.IndexOf(containedView);
 }
 
 
@@ -1008,7 +1013,10 @@ TabManager::AddTab(BView* view, const char* label, int32 index)
 		if (webView != NULL)
 			webView->Shutdown();
 		delete view;
+		return;
 	}
+
+	fViewIndex.Insert(index, view);
 }
 
 
@@ -1022,6 +1030,7 @@ TabManager::RemoveTab(int32 index)
 	BLayoutItem* item = fCardLayout->RemoveItem(index);
 	if (item == NULL)
 		return NULL;
+	fViewIndex.Remove(index);
 
 	TabView* tab = fTabContainerView->RemoveTab(index);
 	delete tab;
@@ -1032,6 +1041,34 @@ TabManager::RemoveTab(int32 index)
 }
 
 
+BView*
+TabManager::ReplaceView(int32 index, BView* view)
+{
+	// Swaps the view shown for a tab while keeping the tab itself, the
+	// previous view is returned to the caller.
+	bool visible = fCardLayout->VisibleIndex() == index;
+	BLayoutItem* item = fCardLayout->RemoveItem(index);
+	if (item == NULL)
+		return NULL;
+
+	BView* oldView = item->View();
+	delete item;
+
+	if (!fCardLayout->AddView(index, view)) {
+		// Put the old view back, the caller keeps ownership of the new one
+		fCardLayout->AddView(index, oldView);
+		if (visible)
+			fCardLayout->SetVisibleItem(index);
+		return NULL;
+	}
+
+	fViewIndex.Replace(index, view);
+	if (visible)
+		fCardLayout->SetVisibleItem(index);
+	return oldView;
+}
+
+
 int32
 TabManager::CountTabs() const
 {
@@ -1055,17 +1092,27 @@ TabManager::TabLabel(int32 tabIndex)
 		return kEmptyString;
 }
 
-const BBitmap*
-TabManager::GetPreview(int32 tabIndex) const
+std::shared_ptr<const BBitmap>
+TabManager::GetPreview(int32 tabIndex, uint32* generation) const
 {
-	BView* view = ViewForTab(tabIndex);
-	BWebView* webView = dynamic_cast<BWebView*>(view);
-	if (webView) {
-		PageUserData* data = static_cast<PageUserData*>(webView->GetUserData());
-		if (data)
-			return data->Preview();
-	}
-	return NULL;
+	// Tabs which are not loaded keep their preview in the user data of
+	// their placeholder view
+	PageUserData* data = PageUserData::ForTabView(ViewForTab(tabIndex));
+	if (data != NULL)
+		return data->Preview(generation);
+	if (generation != NULL)
+		*generation = 0;
+	return std::shared_ptr<const BBitmap>();
+}
+
+
+uint32
+TabManager::PreviewGeneration(int32 tabIndex) const
+{
+	PageUserData* data = PageUserData::ForTabView(ViewForTab(tabIndex));
+	if (data != NULL)
+		return data->PreviewGeneration();
+	return 0;
 }
 
 void
@@ -1101,6 +1148,7 @@ TabManager::MoveTab(int32 fromIndex, int32 toIndex)
 			// We must remove the corresponding card to keep sync.
 			BLayoutItem* item = fCardLayout->RemoveItem(fromIndex);
 			if (item) {
+				fViewIndex.Remove(fromIndex);
 				BWebView* webView = dynamic_cast<BWebView*>(item->View());
 				if (webView)
 					webView->Shutdown();
@@ -1123,6 +1171,7 @@ TabManager::MoveTab(int32 fromIndex, int32 toIndex)
 			// Try to restore to original index
 			if (!fCardLayout->AddItem(fromIndex, item)) {
 				// Fatal error: lost item. Clean up to avoid leak.
+				fViewIndex.Remove(fromIndex);
 				BWebView* webView = dynamic_cast<BWebView*>(item->View());
 				if (webView)
 					webView->Shutdown();
@@ -1138,6 +1187,31 @@ TabManager::MoveTab(int32 fromIndex, int32 toIndex)
 				// Now revert the move in tab container to keep them in sync.
 				fTabContainerView->MoveTab(toIndex, fromIndex);
 			}
-		}
+		} else
+			fViewIndex.Move(fromIndex, toIndex);
 	}
 }
+
+
+void
+TabManager::BeginBatch()
+{
+	fTabContainerView->BeginBatch();
+}
+
+
+void
+TabManager::CommitBatch()
+{
+	fTabContainerView->CommitBatch();
+}
+
+
+void
+TabManager::WarmUpTab(int32 tabIndex)
+{
+	// The target decides whether the tab needs and may get a head start
+	BMessage message(WARM_UP_TAB);
+	message.AddInt32("tab index", tabIndex);
+	fTarget.SendMessage(&message);
+}
@@ -12,8 +12,11 @@
 
 #include <memory>
 
+#include "TabViewIndex.h"
+
 enum {
-	TAB_CHANGED = 'tcha'
+	TAB_CHANGED = 'tcha',
+	WARM_UP_TAB = 'twup'
 };
 
 class BBitmap;
@@ -57,17 +60,25 @@ public:
 			void				AddTab(BView* view, const char* label,
 									int32 index = -1);
 			BView*				RemoveTab(int32 index);
+			BView*				ReplaceView(int32 index, BView* view);
 			int32				CountTabs() const;
 
 			void				SetTabLabel(int32 tabIndex, const char* label);
 	const	BString&			TabLabel(int32);
 			void				SetTabIcon(const BView* containedView,
 									const BBitmap* icon);
-	const	BBitmap*			GetPreview(int32 tabIndex) const;
+			std::shared_ptr<const BBitmap> GetPreview(int32 tabIndex,
+									uint32* generation = NULL) const;
+			uint32				PreviewGeneration(int32 tabIndex) const;
 			void				SetCloseButtonsAvailable(bool available);
 
 			void				MoveTab(int32 fromIndex, int32 toIndex);
 
+			void				BeginBatch();
+			void				CommitBatch();
+
+			void				WarmUpTab(int32 tabIndex);
+
 private:
 #if INTEGRATE_MENU_INTO_TAB_BAR
 			BGroupView*			fMenuContainer;
@@ -77,6 +88,7 @@ private:
 			BView*				fContainerView;
 			BCardLayout*		fCardLayout;
 			std::unique_ptr<TabManagerController> fController;
+			TabViewIndex		fViewIndex;
 
 			BMessenger			fTarget;
 };
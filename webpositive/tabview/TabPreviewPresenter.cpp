@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "TabPreviewPresenter.h"
+
+#include <Bitmap.h>
+#include <Looper.h>
+#include <Message.h>
+#include <View.h>
+#include <Window.h>
+
+
+static const float kPreviewWidth = 200;
+static const float kPreviewHeight = 150;
+
+// How many tabs on each side of the hovered one get their preview prepared
+static const int32 kPrefetchRadius = 2;
+
+
+TabPreviewPresenter::TabPreviewPresenter(BView* owner,
+	TabContainerView::Controller* controller)
+	:
+	fOwner(owner),
+	fController(controller),
+	fWindow(NULL),
+	fView(NULL),
+	fTab(NULL),
+	fGeneration(0),
+	fPrefetchedIndex(-1)
+{
+}
+
+
+TabPreviewPresenter::~TabPreviewPresenter()
+{
+	if (fWindow != NULL && fWindow->Lock())
+		fWindow->Quit();
+}
+
+
+void
+TabPreviewPresenter::SetController(TabContainerView::Controller* controller)
+{
+	fController = controller;
+	Invalidate();
+}
+
+
+void
+TabPreviewPresenter::Present(const TabView* tab, int32 index,
+	BPoint screenWhere)
+{
+	if (fController == NULL || tab == NULL) {
+		Hide();
+		return;
+	}
+
+	uint32 generation = fController->PreviewGeneration(index);
+	if (generation == 0) {
+		Hide();
+		return;
+	}
+
+	if (tab != fTab || generation != fGeneration) {
+		std::shared_ptr<const BBitmap> bitmap
+			= fController->GetPreview(index, &generation);
+		if (bitmap == NULL) {
+			Hide();
+			return;
+		}
+
+		_CreateWindow();
+		if (fWindow->Lock()) {
+			fView->SetViewBitmap(bitmap.get());
+			fView->Invalidate();
+			fWindow->Unlock();
+		}
+		fBitmap = bitmap;
+		fTab = tab;
+		fGeneration = generation;
+
+		if (index != fPrefetchedIndex && fOwner->Looper() != NULL) {
+			// Let the current preview appear first
+			BMessage message(kMsgPrefetchPreviews);
+			message.AddInt32("index", index);
+			fOwner->Looper()->PostMessage(&message, fOwner);
+		}
+	}
+
+	if (fWindow->IsHidden()) {
+		// Center horizontally on mouse, place below tab
+		fWindow->MoveTo(screenWhere.x - kPreviewWidth / 2,
+			screenWhere.y + 20);
+		fWindow->Show();
+	}
+}
+
+
+void
+TabPreviewPresenter::Hide()
+{
+	if (fWindow != NULL && !fWindow->IsHidden())
+		fWindow->Hide();
+}
+
+
+void
+TabPreviewPresenter::Invalidate()
+{
+	if (fWindow != NULL && fWindow->Lock()) {
+		fView->SetViewBitmap(NULL);
+		if (!fWindow->IsHidden())
+			fWindow->Hide();
+		fWindow->Unlock();
+	}
+
+	fBitmap.reset();
+	fTab = NULL;
+	fGeneration = 0;
+	fPrefetchedIndex = -1;
+}
+
+
+void
+TabPreviewPresenter::PrefetchAround(int32 index, int32 count)
+{
+	if (fController == NULL)
+		return;
+
+	fPrefetchedIndex = index;
+	for (int32 distance = 1; distance <= kPrefetchRadius; distance++) {
+		// Fetching is enough: it moves the previews to the front of the
+		// cache and decodes them if they had been compressed.
+		if (index - distance >= 0)
+			fController->GetPreview(index - distance, NULL);
+		if (index + distance < count)
+			fController->GetPreview(index + distance, NULL);
+	}
+}
+
+
+void
+TabPreviewPresenter::_CreateWindow()
+{
+	if (fWindow != NULL)
+		return;
+
+	fWindow = new BWindow(BRect(0, 0, kPreviewWidth, kPreviewHeight),
+		"TabPreview", B_BORDERED_WINDOW_LOOK, B_FLOATING_ALL_WINDOW_FEEL,
+		B_NOT_MOVABLE | B_NOT_CLOSABLE | B_NOT_ZOOMABLE | B_NOT_MINIMIZABLE
+			| B_AVOID_FOCUS);
+	fView = new BView(fWindow->Bounds(), "preview", B_FOLLOW_ALL,
+		B_WILL_DRAW);
+	fWindow->AddChild(fView);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TAB_PREVIEW_PRESENTER_H
+#define TAB_PREVIEW_PRESENTER_H
+
+#include <Point.h>
+#include <SupportDefs.h>
+
+#include <memory>
+
+#include "TabContainerView.h"
+
+class BBitmap;
+class BView;
+class BWindow;
+class TabView;
+
+
+// Shows the hover preview of a tab in a floating window. The presenter
+// remembers which tab and which preview generation it currently shows, so
+// moving the mouse within a tab does not re-upload the bitmap, and it asks
+// the controller for the previews of the neighbouring tabs in advance, so
+// scrubbing along the tab strip does not wait for them to be decoded.
+class TabPreviewPresenter {
+public:
+								TabPreviewPresenter(BView* owner,
+									TabContainerView::Controller* controller);
+								~TabPreviewPresenter();
+
+			void				SetController(
+									TabContainerView::Controller* controller);
+
+			void				Present(const TabView* tab, int32 index,
+									BPoint screenWhere);
+			void				Hide();
+			void				Invalidate();
+
+			void				PrefetchAround(int32 index, int32 count);
+
+			const TabView*		PresentedTab() const { return fTab; }
+
+	static	const uint32		kMsgPrefetchPreviews = 'tpfp';
+
+private:
+			void				_CreateWindow();
+
+private:
+			BView*				fOwner;
+			TabContainerView::Controller* fController;
+			BWindow*			fWindow;
+			BView*				fView;
+
+			const TabView*		fTab;
+			uint32				fGeneration;
+			std::shared_ptr<const BBitmap> fBitmap;
+				// keeps the displayed preview alive if the cache drops it
+			int32				fPrefetchedIndex;
+};
+
+#endif // TAB_PREVIEW_PRESENTER_H
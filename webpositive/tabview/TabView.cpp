@@ -29,6 +29,7 @@ TabView::TabView()
 	:
 	fContainerView(NULL),
 	fLayoutItem(new TabLayoutItem(this)),
+	fIndex(-1),
 	fLabel(),
 	fPinned(false),
 	fGroupColor(ui_color(B_PANEL_BACKGROUND_COLOR))
@@ -38,9 +39,11 @@ TabView::TabView()
 
 TabView::~TabView()
 {
-	// The layout item is deleted for us by the layout which contains it.
-	if (fContainerView == NULL)
-		delete fLayoutItem;
+	// Only visible tabs are part of the container's layout, the tab always
+	// owns its layout item.
+	if (fLayoutItem->Layout() != NULL)
+		fLayoutItem->Layout()->RemoveItem(fLayoutItem);
+	delete fLayoutItem;
 }
 
 
@@ -220,6 +223,10 @@ TabView::SetPinned(bool pinned)
 
 	fPinned = pinned;
 	fLayoutItem->InvalidateLayout();
+	if (fContainerView != NULL) {
+		// The width changes which tabs fit, even if this one is not shown
+		fContainerView->InvalidateLayout();
+	}
 }
 
 
@@ -364,6 +371,10 @@ TabLayoutItem::InvalidateContainer()
 void
 TabLayoutItem::InvalidateContainer(BRect frame)
 {
+	// Tabs which are scrolled out of view are not drawn at all
+	if (Layout() == NULL || fParent->ContainerView() == NULL)
+		return;
+
 	// Invalidate more than necessary, to help the TabContainerView
 	// redraw the parts outside any tabs... need 2px
 	frame.bottom += 2;
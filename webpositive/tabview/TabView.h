@@ -59,8 +59,12 @@ private:
 			float				_LabelHeight() const;
 
 private:
+	friend class TabContainerView;
+
 			TabContainerView*	fContainerView;
 			TabLayoutItem*		fLayoutItem;
+			int32				fIndex;
+				// maintained by the container view
 
 			BString				fLabel;
 			bool				fPinned;
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "TabViewIndex.h"
+
+#include <algorithm>
+
+
+TabViewIndex::TabViewIndex()
+{
+}
+
+
+void
+TabViewIndex::Insert(int32 index, const BView* view)
+{
+	if (index < 0 || index > CountViews())
+		index = CountViews();
+
+	fViews.insert(fViews.begin() + index, view);
+	_Renumber(index, CountViews() - 1);
+}
+
+
+void
+TabViewIndex::Remove(int32 index)
+{
+	if (index < 0 || index >= CountViews())
+		return;
+
+	std::unordered_map<const BView*, int32>::iterator it
+		= fIndices.find(fViews[index]);
+	if (it != fIndices.end() && it->second == index)
+		fIndices.erase(it);
+	fViews.erase(fViews.begin() + index);
+	_Renumber(index, CountViews() - 1);
+}
+
+
+void
+TabViewIndex::Replace(int32 index, const BView* view)
+{
+	if (index < 0 || index >= CountViews())
+		return;
+
+	std::unordered_map<const BView*, int32>::iterator it
+		= fIndices.find(fViews[index]);
+	if (it != fIndices.end() && it->second == index)
+		fIndices.erase(it);
+	fViews[index] = view;
+	fIndices[view] = index;
+}
+
+
+void
+TabViewIndex::Move(int32 fromIndex, int32 toIndex)
+{
+	if (fromIndex < 0 || fromIndex >= CountViews() || toIndex < 0
+		|| toIndex >= CountViews() || fromIndex == toIndex) {
+		return;
+	}
+
+	const BView* view = fViews[fromIndex];
+	fViews.erase(fViews.begin() + fromIndex);
+	fViews.insert(fViews.begin() + toIndex, view);
+	_Renumber(std::min(fromIndex, toIndex), std::max(fromIndex, toIndex));
+}
+
+
+void
+TabViewIndex::Clear()
+{
+	fViews.clear();
+	fIndices.clear();
+}
+
+
+int32
+TabViewIndex::IndexOf(const BView* view) const
+{
+	std::unordered_map<const BView*, int32>::const_iterator it
+		= fIndices.find(view);
+	if (it == fIndices.end())
+		return -1;
+	return it->second;
+}
+
+
+void
+TabViewIndex::_Renumber(int32 first, int32 last)
+{
+	for (int32 i = first; i <= last; i++)
+		fIndices[fViews[i]] = i;
+}
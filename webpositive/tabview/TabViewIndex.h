@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TAB_VIEW_INDEX_H
+#define TAB_VIEW_INDEX_H
+
+#include <SupportDefs.h>
+
+#include <unordered_map>
+#include <vector>
+
+class BView;
+
+
+// Maps the views of the tabs of a TabManager to their tab index.
+//
+// Web view callbacks look up their tab by view all the time, so the lookup
+// is a hash table access. The order of the views is mirrored next to it,
+// which makes changing the order cost as much as walking the tabs after
+// the changed position. That happens far less often.
+class TabViewIndex {
+public:
+								TabViewIndex();
+
+			void				Insert(int32 index, const BView* view);
+			void				Remove(int32 index);
+			void				Replace(int32 index, const BView* view);
+			void				Move(int32 fromIndex, int32 toIndex);
+			void				Clear();
+
+			int32				IndexOf(const BView* view) const;
+			int32				CountViews() const
+									{ return (int32)fViews.size(); }
+
+private:
+			void				_Renumber(int32 first, int32 last);
+
+private:
+			std::vector<const BView*> fViews;
+			std::unordered_map<const BView*, int32> fIndices;
+};
+
+#endif // TAB_VIEW_INDEX_H
@@ -0,0 +1,388 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Runs the bookmark operations on synthetic bookmark trees in the mock
+// filesystem and reports how often each of them opens a file, reads an
+// attribute and lists a directory entry, along with the time it took.
+//
+// Usage: BookmarkBenchmark [depth width size]
+//   depth	levels of folders below the bookmark folder
+//   width	sub folders in every folder
+//   size	bookmarks in every folder
+// Without arguments, a few shapes are run one after the other.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/Path.h"
+#include "mocks/MockFileSystem.cpp"
+#include "mocks/Entry.h"
+#include "mocks/Node.h"
+#include "mocks/File.h"
+#include "mocks/Directory.h"
+#include "mocks/String.h"
+#include "mocks/Message.h"
+#include "mocks/Invoker.h"
+#include "mocks/Alert.h"
+#include "mocks/Roster.h"
+#include "mocks/FindDirectory.h"
+#include "mocks/NodeInfo.h"
+#include "mocks/Catalog.h"
+
+std::string BFile::content = "";
+
+status_t find_directory(directory_which which, BPath* path) {
+    if (path) path->SetTo("/boot/home/config/settings");
+    return B_OK;
+}
+
+BRoster* be_roster = new BRoster();
+
+status_t create_directory(const char* path, mode_t mode) {
+    if (path != NULL && !MockFileSystem::GetEntry(path, NULL)) {
+        MockEntryData data;
+        const char* leaf = strrchr(path, '/');
+        data.name = leaf != NULL ? leaf + 1 : path;
+        data.path = path;
+        data.isDirectory = true;
+        MockFileSystem::AddEntry(path, data);
+    }
+    return B_OK;
+}
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "Benchmark"
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
+#include "../bookmarks/BookmarkManager.cpp"
+
+
+static const char* kBookmarkDir = "/boot/home/config/settings/WebPositive/Bookmarks";
+static const char* kExportPath = "/tmp/bookmark-benchmark.html";
+static const int kMaxExistsChecks = 1000;
+
+
+struct TreeShape {
+    int depth;
+    int width;
+    int size;
+};
+
+
+struct Bookmark {
+    std::string folder;
+    std::string name;
+    std::string url;
+};
+
+
+// #pragma mark - Tree
+
+
+static void
+AddFolder(const std::string& path)
+{
+    MockEntryData data;
+    data.name = path.substr(path.rfind('/') + 1);
+    data.path = path;
+    data.isDirectory = true;
+    MockFileSystem::AddEntry(path, data);
+}
+
+
+static void
+GenerateFolder(const std::string& path, int depth, const TreeShape& shape,
+    std::vector<Bookmark>& bookmarks)
+{
+    for (int i = 0; i < shape.size; i++) {
+        char name[64];
+        sprintf(name, "Bookmark %d", (int)bookmarks.size());
+        char url[96];
+        sprintf(url, "https://example.com/%d/page?id=%d", i,
+            (int)bookmarks.size());
+
+        Bookmark bookmark;
+        bookmark.folder = path;
+        bookmark.name = name;
+        bookmark.url = url;
+        bookmarks.push_back(bookmark);
+
+        MockEntryData data;
+        data.name = name;
+        data.path = path + "/" + name;
+        data.isDirectory = false;
+        data.attributes["META:url"] = url;
+        data.attributes["META:title"] = name;
+        MockFileSystem::AddEntry(data.path, data);
+    }
+
+    if (depth == 0)
+        return;
+
+    for (int i = 0; i < shape.width; i++) {
+        char name[32];
+        sprintf(name, "Folder %d", i);
+        std::string folderPath = path + "/" + name;
+        AddFolder(folderPath);
+        GenerateFolder(folderPath, depth - 1, shape, bookmarks);
+    }
+}
+
+
+static void
+GenerateTree(const TreeShape& shape, std::vector<Bookmark>& bookmarks)
+{
+    MockFileSystem::Reset();
+    bookmarks.clear();
+    AddFolder(kBookmarkDir);
+    GenerateFolder(kBookmarkDir, shape.depth, shape, bookmarks);
+}
+
+
+static int
+CountBookmarkFiles()
+{
+    int count = 0;
+    std::map<std::string, MockEntryData>::iterator it;
+    for (it = MockFileSystem::sEntries.begin();
+            it != MockFileSystem::sEntries.end(); ++it) {
+        if (!it->second.isDirectory
+            && it->second.attributes.count("META:url") > 0)
+            count++;
+    }
+    return count;
+}
+
+
+// Fills the index from the files, like the BookmarkMonitor does at start
+static void
+FillIndex(BookmarkIndex& index)
+{
+    index.Clear();
+    ino_t node = 1;
+    std::map<std::string, MockEntryData>::iterator it;
+    for (it = MockFileSystem::sEntries.begin();
+            it != MockFileSystem::sEntries.end(); ++it) {
+        if (it->second.isDirectory)
+            continue;
+        index.Put(node++, it->first.c_str(),
+            it->second.attributes["META:title"].c_str(),
+            it->second.attributes["META:url"].c_str());
+    }
+    index.SetReady(true);
+}
+
+
+// #pragma mark - Measuring
+
+
+static struct timeval sStart;
+
+
+static void
+StartMeasuring()
+{
+    MockFileSystem::sGetNextEntryCount = 0;
+    MockFileSystem::sOpenCount = 0;
+    MockFileSystem::sReadAttrCount = 0;
+    gettimeofday(&sStart, NULL);
+}
+
+
+static void
+Report(const char* scenario, bool useIndex, int items)
+{
+    struct timeval end;
+    gettimeofday(&end, NULL);
+    double elapsed = (end.tv_sec - sStart.tv_sec) * 1000.0
+        + (end.tv_usec - sStart.tv_usec) / 1000.0;
+
+    printf("%-12s %-6s %8d %12.3f %10ld %10ld %10ld\n", scenario,
+        useIndex ? "index" : "files", items, elapsed,
+        MockFileSystem::sOpenCount, MockFileSystem::sReadAttrCount,
+        MockFileSystem::sGetNextEntryCount);
+}
+
+
+// #pragma mark - Scenarios
+
+
+static void
+RunOpenFolder(BookmarkIndex& index, bool useIndex, int total)
+{
+    BookmarkIndex::SetDefault(useIndex ? &index : NULL);
+
+    BDirectory directory(kBookmarkDir);
+    BMessage message;
+    uint32 addedCount = 0;
+
+    StartMeasuring();
+    BookmarkManager::AddBookmarkURLsRecursively(directory, &message,
+        addedCount);
+    Report("open-folder", useIndex, (int)addedCount);
+
+    check((int)addedCount == total, "opening the folder finds every bookmark");
+    BookmarkIndex::SetDefault(NULL);
+}
+
+
+static void
+RunExistsCheck(BookmarkIndex& index, bool useIndex,
+    const std::vector<Bookmark>& bookmarks)
+{
+    BookmarkIndex::SetDefault(useIndex ? &index : NULL);
+
+    // The folders are listed before measuring, the mock does that on
+    // construction
+    int count = std::min((int)bookmarks.size(), kMaxExistsChecks);
+    std::map<std::string, BDirectory*> directories;
+    for (int i = 0; i < count; i++) {
+        const std::string& folder = bookmarks[i].folder;
+        if (directories.find(folder) == directories.end())
+            directories[folder] = new BDirectory(folder.c_str());
+    }
+
+    int found = 0;
+    StartMeasuring();
+    for (int i = 0; i < count; i++) {
+        const Bookmark& bookmark = bookmarks[i];
+        BDirectory& directory = *directories[bookmark.folder];
+        if (BookmarkManager::CheckBookmarkExists(directory,
+                bookmark.name.c_str(), bookmark.url.c_str()))
+            found++;
+        if (BookmarkManager::CheckBookmarkExists(directory,
+                bookmark.name.c_str(), "https://example.org/"))
+            found--;
+    }
+    Report("exists-check", useIndex, count * 2);
+
+    check(found == count, "existing bookmarks are found, others are not");
+
+    std::map<std::string, BDirectory*>::iterator it;
+    for (it = directories.begin(); it != directories.end(); ++it)
+        delete it->second;
+    BookmarkIndex::SetDefault(NULL);
+}
+
+
+static std::string
+RunExport(BookmarkIndex& index, bool useIndex, int total)
+{
+    BookmarkIndex::SetDefault(useIndex ? &index : NULL);
+    BFile::content = "";
+
+    StartMeasuring();
+    status_t status = BookmarkManager::ExportBookmarks(BPath(kExportPath));
+    Report("export", useIndex, total);
+
+    check(status == B_OK, "export succeeds");
+    MockFileSystem::sEntries.erase(kExportPath);
+    BookmarkIndex::SetDefault(NULL);
+    return BFile::content;
+}
+
+
+static void
+RunImport(BookmarkIndex& index, const std::string& html, int total)
+{
+    // Into an empty bookmark folder first
+    MockFileSystem::Reset();
+    AddFolder(kBookmarkDir);
+    BFile::content = html;
+
+    StartMeasuring();
+    BookmarkManager::ImportBookmarks(BPath(kExportPath));
+    int created = CountBookmarkFiles();
+    Report("import", false, created);
+    check(created == total, "import creates every bookmark");
+
+    // Importing the same file again has nothing left to do, whether the
+    // folder is walked or the index is asked
+    for (int pass = 0; pass < 2; pass++) {
+        bool useIndex = pass == 1;
+        if (useIndex)
+            FillIndex(index);
+        BookmarkIndex::SetDefault(useIndex ? &index : NULL);
+        BFile::content = html;
+
+        StartMeasuring();
+        BookmarkManager::ImportBookmarks(BPath(kExportPath), BMessenger(),
+            true);
+        int count = CountBookmarkFiles();
+        Report("reimport", useIndex, count - created);
+        check(count == created, "importing again adds no duplicates");
+        BookmarkIndex::SetDefault(NULL);
+    }
+}
+
+
+static void
+RunShape(const TreeShape& shape)
+{
+    std::vector<Bookmark> bookmarks;
+    GenerateTree(shape, bookmarks);
+    int total = (int)bookmarks.size();
+
+    printf("\nTree: depth %d, width %d, size %d (%d bookmarks, %d entries)\n",
+        shape.depth, shape.width, shape.size, total,
+        (int)MockFileSystem::sEntries.size());
+    printf("%-12s %-6s %8s %12s %10s %10s %10s\n", "scenario", "mode",
+        "items", "time (ms)", "opens", "read attr", "entries");
+
+    BookmarkIndex index;
+    FillIndex(index);
+
+    std::string html;
+    for (int pass = 0; pass < 2; pass++) {
+        bool useIndex = pass == 1;
+        RunOpenFolder(index, useIndex, total);
+        RunExistsCheck(index, useIndex, bookmarks);
+        std::string output = RunExport(index, useIndex, total);
+        if (useIndex)
+            check(output == html, "index and files export the same");
+        html = output;
+    }
+
+    RunImport(index, html, total);
+}
+
+
+int
+main(int argc, char** argv)
+{
+    printf("Running BookmarkBenchmark...\n");
+    // Only failures interrupt the tables
+    sQuietChecks = true;
+
+    if (argc == 4) {
+        TreeShape shape = { atoi(argv[1]), atoi(argv[2]), atoi(argv[3]) };
+        if (shape.depth < 0 || shape.width < 0 || shape.size < 0) {
+            fprintf(stderr, "usage: %s [depth width size]\n", argv[0]);
+            return 1;
+        }
+        RunShape(shape);
+    } else {
+        static const TreeShape kShapes[] = {
+            { 0, 0, 1000 },
+            { 2, 10, 20 },
+            { 4, 4, 10 }
+        };
+        for (size_t i = 0; i < sizeof(kShapes) / sizeof(kShapes[0]); i++)
+            RunShape(kShapes[i]);
+    }
+
+    printf("\n");
+    return checkResult();
+}
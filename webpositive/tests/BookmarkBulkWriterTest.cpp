@@ -0,0 +1,165 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+#include <map>
+#include <string>
+
+#include "Check.h"
+#include "mocks/MockFileSystem.h"
+#include "mocks/String.h"
+#include "mocks/File.h"
+#include "mocks/Path.h"
+#include "mocks/Directory.h"
+#include "mocks/FindDirectory.h"
+#include "mocks/Entry.h"
+#include "mocks/Message.h"
+#include "mocks/Autolock.h"
+#include "mocks/Alert.h"
+#include "mocks/Catalog.h"
+#include "mocks/Locale.h"
+
+std::map<std::string, MockEntryData> MockFileSystem::sEntries;
+long MockFileSystem::sGetNextEntryCount = 0;
+long MockFileSystem::sOpenCount = 0;
+long MockFileSystem::sReadAttrCount = 0;
+
+status_t create_directory(const char* path, mode_t mode) { return B_OK; }
+
+#include "mocks/NodeInfo.h"
+#include "mocks/Roster.h"
+BRoster* be_roster = NULL;
+
+#define _NODE_INFO_H
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
+#include "../bookmarks/BookmarkManager.cpp"
+
+std::string BFile::content = "";
+
+status_t find_directory(directory_which which, BPath* path) {
+	path->SetTo("/boot/home/config/settings");
+	return B_OK;
+}
+
+
+static const char* kFolder = "/boot/home/config/settings/WebPositive/Imported";
+
+
+static std::string
+urlOf(const std::string& name)
+{
+	MockEntryData data;
+	if (!MockFileSystem::GetEntry(std::string(kFolder) + "/" + name, &data))
+		return "";
+	return data.attributes["META:url"];
+}
+
+
+static void
+addFile(const BString& name)
+{
+	MockEntryData data;
+	data.name = name.String();
+	data.path = std::string(kFolder) + "/" + name.String();
+	data.isDirectory = false;
+	data.attributes["META:url"] = "https://example.com/existing";
+	MockFileSystem::AddEntry(data.path, data);
+}
+
+
+int
+main()
+{
+	printf("Testing BookmarkBulkWriter...\n");
+
+	BPath folder(kFolder);
+
+	// Enough bookmarks for several workers
+	{
+		MockFileSystem::Reset();
+		sSpawnedThreads = 0;
+
+		const int32 count = 3 * BookmarkBulkWriter::kProgressInterval;
+		BookmarkBulkWriter writer((BMessenger()));
+		for (int32 i = 0; i < count; i++) {
+			BString title;
+			title << "Page " << i;
+			BString url;
+			url << "https://example.com/" << i;
+			writer.Add(folder, title, url);
+		}
+		check(writer.Flush() == B_OK && writer.CountCreated() == count
+			&& writer.CountFailed() == 0, "all bookmarks are written");
+		check(sSpawnedThreads == 3, "the jobs are shared by workers");
+
+		bool matching = true;
+		for (int32 i = 0; i < count && matching; i++) {
+			BString name;
+			name << "Page " << i;
+			BString url;
+			url << "https://example.com/" << i;
+			matching = urlOf(name.String()) == url.String();
+		}
+		check(matching, "every job is written once, under its own name");
+	}
+
+	// Names taken by earlier bookmarks of the same import
+	{
+		MockFileSystem::Reset();
+
+		BookmarkBulkWriter writer((BMessenger()));
+		for (int32 i = 0; i < 4; i++) {
+			BString url;
+			url << "https://example.com/same/" << i;
+			writer.Add(folder, "Same", url);
+		}
+		writer.Flush();
+		check(writer.CountCreated() == 4
+			&& urlOf("Same") == "https://example.com/same/0"
+			&& urlOf("Same 1") == "https://example.com/same/1"
+			&& urlOf("Same 3") == "https://example.com/same/3",
+			"suffixes follow the order of the bookmarks");
+	}
+
+	// Names taken after the folder was listed
+	{
+		MockFileSystem::Reset();
+
+		BookmarkBulkWriter writer((BMessenger()));
+		writer.Add(folder, "Busy", "https://example.com/busy");
+		addFile("Busy");
+		for (int32 i = 1; i < BookmarkBulkWriter::kMaxNameRetries; i++) {
+			BString name;
+			name << "Busy " << i;
+			addFile(name);
+		}
+		BString lastName;
+		lastName << "Busy " << BookmarkBulkWriter::kMaxNameRetries;
+		check(writer.Flush() == B_OK && writer.CountCreated() == 1
+			&& urlOf("Busy") == "https://example.com/existing"
+			&& urlOf(lastName.String()) == "https://example.com/busy",
+			"the next free name is tried up to the retry limit");
+
+		MockFileSystem::Reset();
+		BookmarkBulkWriter full((BMessenger()));
+		full.Add(folder, "Busy", "https://example.com/full");
+		addFile("Busy");
+		for (int32 i = 1; i <= BookmarkBulkWriter::kMaxNameRetries; i++) {
+			BString name;
+			name << "Busy " << i;
+			addFile(name);
+		}
+		check(full.Flush() == B_FILE_EXISTS && full.CountCreated() == 0
+			&& full.CountFailed() == 1,
+			"beyond the retry limit the bookmark fails");
+	}
+
+	return checkResult();
+}
@@ -48,39 +48,72 @@ status_t create_directory(const char* path, mode_t mode) { return B_OK; }
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Benchmark"
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
 #include "../bookmarks/BookmarkManager.cpp"
 
-void SetupBookmarks(int numEntries) {
+static const char* kBookmarkDir = "/boot/home/config/settings/WebPositive/Bookmarks";
+
+void SetupBookmarks(int numEntries, BookmarkIndex* index = NULL) {
     MockFileSystem::Reset();
 
     // Create entries in MockFileSystem
     // Note: The MockDirectory implementation scans MockFileSystem::sEntries to find children.
     // So we just need to add entries with the correct path prefix.
+    // Every tenth bookmark goes into one of a few sub folders.
+
+    static const char* kFolders[] = { "", "/Work", "/Work/Docs & Specs", "/Misc" };
+    for (int f = 1; f < 4; ++f) {
+        BString folderPath = kBookmarkDir;
+        folderPath << kFolders[f];
 
-    std::string baseDir = "/boot/home/config/settings/WebPositive/Bookmarks";
+        MockEntryData data;
+        data.name = strrchr(kFolders[f], '/') + 1;
+        data.path = folderPath.String();
+        data.isDirectory = true;
+        MockFileSystem::AddEntry(folderPath.String(), data);
+    }
 
     for (int i = 0; i < numEntries; ++i) {
         char name[64];
         sprintf(name, "bookmark_%d", i);
-        BString fullPath = baseDir.c_str();
-        fullPath << "/" << name;
+        BString fullPath = kBookmarkDir;
+        fullPath << (i % 10 == 0 ? kFolders[(i / 10) % 4] : "") << "/" << name;
+
+        char url[64];
+        sprintf(url, "http://example.com/%d?a=1&b=2", i);
+        BString title = name;
+        title << " <" << i << ">";
 
         MockEntryData data;
         data.name = name;
         data.path = fullPath.String();
         data.isDirectory = false;
-        data.attributes["META:url"] = "http://example.com";
-        data.attributes["META:title"] = name;
+        data.attributes["META:url"] = url;
+        data.attributes["META:title"] = title.String();
 
         MockFileSystem::AddEntry(fullPath.String(), data);
+        if (index != NULL)
+            index->Put(i + 1, fullPath, title, url);
     }
 }
 
-void RunBenchmark(int numEntries) {
-    SetupBookmarks(numEntries);
+std::string RunBenchmark(int numEntries, bool useIndex) {
+    BookmarkIndex index;
+    SetupBookmarks(numEntries, useIndex ? &index : NULL);
+    if (useIndex) {
+        index.SetReady(true);
+        BookmarkIndex::SetDefault(&index);
+    }
 
     // Reset counters before running the target function
     MockFileSystem::sOpenCount = 0;
+    MockFileSystem::sReadAttrCount = 0;
+    BFile::content = "";
 
     BPath exportPath("/tmp/bookmarks.html");
 
@@ -91,18 +124,38 @@ void RunBenchmark(int numEntries) {
 
     gettimeofday(&end, NULL);
 
+    BookmarkIndex::SetDefault(NULL);
+
     double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
 
-    printf("Entries: %d\n", numEntries);
+    printf("Entries: %d (%s)\n", numEntries, useIndex ? "index" : "files");
     printf("Result: %d\n", result);
     printf("Time: %.6f s\n", elapsed);
     printf("OpenCount: %ld\n", MockFileSystem::sOpenCount);
+    printf("ReadAttrCount: %ld\n", MockFileSystem::sReadAttrCount);
+    printf("Bytes: %zu\n", BFile::content.length());
     printf("----------------------------------------\n");
+    return BFile::content;
 }
 
 int main() {
     printf("Running BookmarkExportBenchmark...\n");
-    RunBenchmark(100);
-    RunBenchmark(1000);
-    return 0;
+    int sizes[] = { 100, 1000, 10000 };
+    bool same = true;
+    for (int i = 0; i < 3; ++i) {
+        std::string fromFiles = RunBenchmark(sizes[i], false);
+        std::string fromIndex = RunBenchmark(sizes[i], true);
+        same &= fromFiles == fromIndex;
+    }
+
+    std::string output = RunBenchmark(20, false);
+    bool escaped = output.find("<DT><H3>Docs &amp; Specs</H3>") != std::string::npos
+        && output.find("bookmark_3 &lt;3&gt;</A>") != std::string::npos
+        && output.find("HREF=\"http://example.com/3?a=1&b=2\"") != std::string::npos;
+    bool closed = output.compare(output.length() - 9, 9, "</DL><p>\n") == 0;
+
+    printf("%s: index and files give the same output\n", same ? "SUCCESS" : "FAILURE");
+    printf("%s: names and titles are escaped\n", escaped ? "SUCCESS" : "FAILURE");
+    printf("%s: all lists are closed\n", closed ? "SUCCESS" : "FAILURE");
+    return same && escaped && closed ? 0 : 1;
 }
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+#include <string>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+
+
+// Records the events as a compact string, e.g. "F(Name)[B(url|title)]"
+class RecordingListener : public BookmarkHTMLParser::Listener {
+public:
+	virtual void FolderFound(const BString& name)
+	{
+		events += "F(";
+		events += name.String();
+		events += ")";
+	}
+
+	virtual void ListStarted()
+	{
+		events += "[";
+	}
+
+	virtual void ListEnded()
+	{
+		events += "]";
+	}
+
+	virtual void BookmarkFound(const BString& url, const BString& title)
+	{
+		events += "B(";
+		events += url.String();
+		events += "|";
+		events += title.String();
+		events += ")";
+	}
+
+	std::string events;
+};
+
+
+static std::string
+parse(const std::string& html, size_t chunkSize)
+{
+	RecordingListener listener;
+	BookmarkHTMLParser parser(&listener);
+	for (size_t offset = 0; offset < html.length(); offset += chunkSize) {
+		parser.Feed(html.data() + offset,
+			std::min(chunkSize, html.length() - offset));
+	}
+	return listener.events;
+}
+
+
+int
+main()
+{
+	printf("Testing BookmarkHTMLParser...\n");
+
+	std::string html =
+		"<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+		"<!-- This is an automatically generated file.\n"
+		"     <DL> in a comment is no list -->\n"
+		"<TITLE>Bookmarks</TITLE>\n"
+		"<DL><p>\n"
+		"    <DT><H3 ADD_DATE=\"1\">Tools &amp; Docs</H3>\n"
+		"    <DL><p>\n"
+		"        <DT><A HREF=\"https://example.com/?a=1&amp;b=2\" "
+			"ICON=\"data:image/png;base64,AAAA\">Caf&#233; &lt;3</A>\n"
+		"        <DT><a href='https://haiku-os.org/'>Haiku <b>OS</b></a>\n"
+		"    </DL><p>\n"
+		"    <DT><H3>Empty</H3>\n"
+		"    <DT><A HREF=https://unquoted.org/>Unquoted &unknown; &#x1F600;</A>\n"
+		"    <DT><A>No link</A>\n"
+		"</DL><p>\n";
+
+	std::string expected =
+		"[F(Tools & Docs)["
+		"B(https://example.com/?a=1&b=2|Caf\xc3\xa9 <3)"
+		"B(https://haiku-os.org/|Haiku OS)]"
+		"F(Empty)"
+		"B(https://unquoted.org/|Unquoted &unknown; \xf0\x9f\x98\x80)]";
+
+	std::string events = parse(html, html.length());
+	check(events == expected, "folders, lists and bookmarks are reported");
+	if (events != expected)
+		printf("  got %s\n", events.c_str());
+
+	bool sameInPieces = true;
+	for (size_t chunkSize = 1; chunkSize < 20; chunkSize++)
+		sameInPieces &= parse(html, chunkSize) == expected;
+	check(sameInPieces, "the result does not depend on the chunk size");
+
+	// A huge icon attribute is skipped without being kept
+	std::string icon(10 * BookmarkHTMLParser::kMaxURLLength, 'A');
+	events = parse("<DT><A ICON=\"" + icon + "\" HREF=\"http://a.b/\">x</A>",
+		4096);
+	check(events == "B(http://a.b/|x)", "large attributes are skipped");
+
+	std::string longURL(BookmarkHTMLParser::kMaxURLLength + 1, 'u');
+	events = parse("<A HREF=\"" + longURL + "\">x</A>", 4096);
+	check(events.empty(), "links too long to be kept are dropped");
+
+	return checkResult();
+}
@@ -47,6 +47,12 @@ status_t create_directory(const char* path, mode_t mode) {
 BRoster* be_roster = NULL;
 
 #define _NODE_INFO_H
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
 #include "../bookmarks/BookmarkManager.cpp"
 
 // BFile::content static definition
@@ -112,5 +118,131 @@ int main() {
 
     if (!foundEmpty || !foundLast) return 1;
 
+    // Folder names that are no file names of their own are renamed, so
+    // nothing lands outside of the folder it belongs in
+    sCreatedDirectories.clear();
+    BFile::content =
+        "<DL><p>\n"
+        "<DT><H3>..</H3>\n"
+        "<DL><p>\n"
+        "<DT><A HREF=\"http://example.com/up\">Up</A>\n"
+        "</DL><p>\n"
+        "<DT><H3>.</H3>\n"
+        "<DT><H3></H3>\n"
+        "</DL><p>\n";
+    BookmarkManager::ImportBookmarks(BPath("/tmp/bookmarks.html"));
+    std::string untitled = std::string(basePath.Path()) + "/Untitled folder";
+    bool dotsRenamed = !sCreatedDirectories.empty();
+    for (const auto& dir : sCreatedDirectories) {
+        if (dir != basePath.Path() && dir != untitled)
+            dotsRenamed = false;
+    }
+    MockEntryData up;
+    dotsRenamed = dotsRenamed
+        && MockFileSystem::GetEntry(untitled + "/Up", &up)
+        && up.attributes["META:url"] == "http://example.com/up";
+    printf("%s: \".\", \"..\" and empty folder names are renamed\n",
+        dotsRenamed ? "SUCCESS" : "FAILURE");
+    if (!dotsRenamed) return 1;
+
+    // A merging import skips URLs bookmarked anywhere in the tree, in
+    // the same form, and repeated ones; other schemes and fragments are
+    // other pages
+    create_directory((std::string(basePath.Path()) + "/Old").c_str(), 0755);
+    MockEntryData existing;
+    existing.name = "Haiku";
+    existing.path = std::string(basePath.Path()) + "/Old/Haiku";
+    existing.isDirectory = false;
+    existing.attributes["META:url"] = "https://www.haiku-os.org/";
+    MockFileSystem::AddEntry(existing.path, existing);
+
+    BPath folder(basePath.Path());
+    folder.Append("Imported");
+
+    BookmarkBulkWriter merging((BMessenger()), true);
+    merging.Add(folder, "Haiku", "https://www.Haiku-OS.org");
+    merging.Add(folder, "WebKit", "https://webkit.org/");
+    merging.Add(basePath, "WebKit", "https://webkit.org");
+    merging.Add(folder, "Settings", "https://webkit.org/#/settings");
+    merging.Add(folder, "Insecure", "http://webkit.org/");
+    merging.Flush();
+    bool merged = merging.CountCreated() == 3
+        && merging.CountSkipped() == 2;
+    printf("%s: merging import skips duplicates across the tree\n",
+        merged ? "SUCCESS" : "FAILURE");
+
+    // Once the index knows the bookmarks, it answers instead
+    BookmarkIndex index;
+    index.Put(1, existing.path.c_str(), "Haiku", "https://www.haiku-os.org/");
+    index.Put(2, (BString(folder.Path()) << "/WebKit"), "WebKit",
+        "https://webkit.org/");
+    index.SetReady(true);
+    BookmarkIndex::SetDefault(&index);
+
+    BookmarkBulkWriter again((BMessenger()), true);
+    again.Add(folder, "Haiku", "https://www.haiku-os.org");
+    again.Add(basePath, "WebKit", "https://WebKit.org");
+    again.Flush();
+    bool idempotent = again.CountCreated() == 0
+        && again.CountSkipped() == 2;
+    printf("%s: importing the same bookmarks again adds nothing\n",
+        idempotent ? "SUCCESS" : "FAILURE");
+
+    BookmarkBulkWriter plain((BMessenger()));
+    plain.Add(basePath, "Haiku", "https://haiku-os.org/");
+    plain.Flush();
+    bool notMerged = plain.CountCreated() == 1;
+    printf("%s: without merging, other folders are not looked at\n",
+        notMerged ? "SUCCESS" : "FAILURE");
+    BookmarkIndex::SetDefault(NULL);
+
+    // A file that shows up under a planned name before the writer gets to
+    // it is kept, the bookmark takes the next name
+    BookmarkBulkWriter racing((BMessenger()));
+    racing.Add(basePath, "Taken", "https://example.com/new");
+    MockEntryData taken;
+    taken.name = "Taken";
+    taken.path = std::string(basePath.Path()) + "/Taken";
+    taken.isDirectory = false;
+    taken.attributes["META:url"] = "https://example.com/old";
+    MockFileSystem::AddEntry(taken.path, taken);
+    racing.Flush();
+    MockEntryData renamed;
+    bool kept = racing.CountCreated() == 1
+        && MockFileSystem::GetEntry(taken.path, &taken)
+        && taken.attributes["META:url"] == "https://example.com/old"
+        && MockFileSystem::GetEntry(taken.path + " 1", &renamed)
+        && renamed.attributes["META:url"] == "https://example.com/new";
+    printf("%s: a bookmark created meanwhile is not overwritten\n",
+        kept ? "SUCCESS" : "FAILURE");
+
+    // Long names leave room for the " N" suffix and are not cut in the
+    // middle of a UTF-8 character
+    BString longTitle;
+    for (int i = 0; i < 200; i++)
+        longTitle << "\xc3\xa9";
+    BookmarkBulkWriter longNames((BMessenger()));
+    longNames.Add(basePath, longTitle, "https://example.com/long");
+    longNames.Add(basePath, longTitle, "https://example.com/longer");
+    longNames.Flush();
+    std::string first(254, '\0');
+    for (int i = 0; i < 127; i++)
+        first.replace(i * 2, 2, "\xc3\xa9");
+    std::string second = first.substr(0, 252) + " 1";
+    MockEntryData firstEntry;
+    MockEntryData secondEntry;
+    bool shortened = longNames.CountCreated() == 2
+        && MockFileSystem::GetEntry(std::string(basePath.Path()) + "/"
+            + first, &firstEntry)
+        && firstEntry.attributes["META:url"] == "https://example.com/long"
+        && MockFileSystem::GetEntry(std::string(basePath.Path()) + "/"
+            + second, &secondEntry)
+        && secondEntry.attributes["META:url"] == "https://example.com/longer";
+    printf("%s: long names are shortened to fit with their suffix\n",
+        shortened ? "SUCCESS" : "FAILURE");
+
+    if (!merged || !idempotent || !notMerged || !kept || !shortened)
+        return 1;
+
     return 0;
 }
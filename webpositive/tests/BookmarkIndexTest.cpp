@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/File.h"
+
+std::string BFile::content = "";
+std::map<std::string, MockEntryData> MockFileSystem::sEntries;
+long MockFileSystem::sGetNextEntryCount = 0;
+long MockFileSystem::sOpenCount = 0;
+long MockFileSystem::sReadAttrCount = 0;
+
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
+
+
+int
+main()
+{
+	printf("Testing BookmarkIndex...\n");
+
+	BookmarkIndex index;
+	index.Put(1, "/b/Haiku", "Haiku Project", "https://www.haiku-os.org/");
+	index.Put(2, "/b/Dev/Bugs", "Bug tracker", "https://dev.haiku-os.org/");
+	index.Put(3, "/b/Dev/WebKit", "WebKit", "https://webkit.org/");
+	index.Put(4, "/b/Dev/Old/Trac", "Old tracker", "https://dev.haiku-os.org/");
+	index.Put(5, "/b/Notes", "", "");
+	check(index.CountEntries() == 5, "files are indexed");
+
+	check(index.IsBookmarked("https://webkit.org/"), "bookmarked URL is found");
+	check(!index.IsBookmarked("https://example.com/"),
+		"other URL is not found");
+	check(!index.IsBookmarked(""), "files without URL are no bookmarks");
+	check(index.HasBookmark("/b/Dev/Bugs", "https://dev.haiku-os.org/"),
+		"bookmark is found by path and URL");
+	check(!index.HasBookmark("/b/Dev/Bugs", "https://webkit.org/"),
+		"bookmark with another URL does not match");
+
+	BMessage message;
+	check(index.AddURLs("/b/Dev", &message) == 3,
+		"URLs below a folder are collected");
+	message.MakeEmpty();
+	check(index.AddURLs("/b/De", &message) == 0,
+		"a folder name prefix is no folder");
+
+	// The same URL stays bookmarked until its last file is gone
+	index.Remove(2);
+	check(index.IsBookmarked("https://dev.haiku-os.org/"),
+		"URL of a remaining duplicate is still bookmarked");
+	index.Remove(4);
+	check(!index.IsBookmarked("https://dev.haiku-os.org/"),
+		"URL is forgotten with its last bookmark");
+
+	index.Put(3, "/b/Dev/WebKit", "WebKit", "https://www.webkit.org/");
+	check(!index.IsBookmarked("https://webkit.org/")
+		&& index.IsBookmarked("https://www.webkit.org/"),
+		"changed attributes replace the old URL");
+
+	check(index.IsBookmarkedSimilar("https://www.WebKit.org")
+		&& !index.IsBookmarked("https://www.WebKit.org"),
+		"URLs differing in host case or trailing slash are similar");
+	check(!index.IsBookmarkedSimilar("https://www.webkit.org/blog")
+		&& !index.IsBookmarkedSimilar("http://www.webkit.org/")
+		&& !index.IsBookmarkedSimilar("https://www.webkit.org/#/news"),
+		"other paths, schemes or fragments are not similar");
+	index.Remove(3);
+	check(!index.IsBookmarkedSimilar("https://www.webkit.org"),
+		"similar URL is forgotten with its last bookmark");
+	index.Put(3, "/b/Dev/WebKit", "WebKit", "https://www.webkit.org/");
+
+	index.MovePath("/b/Dev", "/b/Development");
+	check(index.FindPath("/b/Dev/WebKit") == NULL
+		&& index.FindPath("/b/Development/WebKit") != NULL
+		&& index.FindNode(3)->path == "/b/Development/WebKit",
+		"moving a folder moves what is below it");
+
+	std::vector<BookmarkIndex::Entry> results;
+	index.Search("haiku", 10, results);
+	check(results.size() == 1 && results[0].node == 1,
+		"search finds titles and URLs");
+	index.Put(6, "/b/Haiku Bugs", "Haiku bugs", "https://dev.haiku-os.org/");
+	index.Search("haiku bug", 10, results);
+	check(results.size() == 1 && results[0].node == 6,
+		"every word has to match");
+	index.Search("org", 1, results);
+	check(results.size() == 1, "search results are limited");
+
+	std::vector<ino_t> nodes;
+	index.Put(7, "/b/Recipes", "Bread", "https://example.com/r?id=1",
+		"cooking, Baking");
+	index.Query("bak", nodes);
+	check(nodes.size() == 1 && nodes[0] == 7, "tags are indexed");
+	index.Query("HAI deV", nodes);
+	check(nodes.size() == 1 && nodes[0] == 6,
+		"query words are prefixes which all have to match");
+	index.Query("https", nodes);
+	check(nodes.empty(), "URL schemes are not indexed");
+	index.Search("https://www.haiku", 10, results);
+	check(results.size() == 1 && results[0].node == 1,
+		"typed URLs are searched without their scheme");
+	index.Query("http://haiku", nodes);
+	index.Search("http://haiku", 10, results);
+	check(nodes.size() == 2 && results.size() == 2,
+		"the scheme of a typed URL does not have to match");
+	index.Search("cooking", 10, results);
+	check(results.size() == 1 && results[0].tags == "cooking, Baking",
+		"search finds tags");
+	index.Put(7, "/b/Recipes", "Bread", "https://example.com/r?id=1", "");
+	index.Query("baking", nodes);
+	check(nodes.empty(), "words of changed attributes are forgotten");
+
+	BMessage archive;
+	check(index.Archive(archive) == B_OK, "the index is archived");
+	BookmarkIndex loaded;
+	check(loaded.Unarchive(archive) == B_OK
+		&& loaded.CountEntries() == index.CountEntries()
+		&& loaded.IsSearchable() && !loaded.IsReady(),
+		"a loaded index can be searched, but is not ready");
+	loaded.Query("bread", nodes);
+	check(nodes.size() == 1 && nodes[0] == 7,
+		"a loaded index has its words");
+
+	loaded.StartRescan();
+	loaded.Put(1, "/b/Haiku", "Haiku Project", "https://www.haiku-os.org/");
+	loaded.Put(8, "/b/New", "New", "https://new.example.com/");
+	loaded.FinishRescan();
+	check(loaded.CountEntries() == 2 && loaded.FindNode(7) == NULL,
+		"what was not found again is dropped after a rescan");
+
+	index.RemovePath("/b/Development");
+	check(index.FindNode(3) == NULL && index.FindNode(1) != NULL,
+		"removing a folder removes what is below it");
+
+	return checkResult();
+}
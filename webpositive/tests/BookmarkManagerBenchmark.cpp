@@ -44,6 +44,12 @@ status_t create_directory(const char* path, mode_t mode) { return B_OK; }
 // We need to define B_TRANSLATION_CONTEXT to avoid errors if it's redefined
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Benchmark"
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
 #include "../bookmarks/BookmarkManager.cpp"
 
 // Benchmark function
@@ -38,6 +38,12 @@ status_t create_directory(const char* path, mode_t mode) { return B_OK; }
 
 // Include source
 #define B_TRANSLATION_CONTEXT "Benchmark"
+#include "mocks/MockThreads.cpp"
+
+#include "../bookmarks/BookmarkBulkWriter.cpp"
+#include "../bookmarks/BookmarkHTMLParser.cpp"
+#include "../bookmarks/BookmarkIndex.cpp"
+#include "../support/BaseURL.cpp"
 #include "../bookmarks/BookmarkManager.cpp"
 
 void PopulateRecursive(BDirectory& dir, int depth, int filesPerDir, int dirsPerDir) {
@@ -74,7 +80,7 @@ void PopulateRecursive(BDirectory& dir, int depth, int filesPerDir, int dirsPerD
     }
 }
 
-void RunBenchmark() {
+void RunBenchmark(bool useIndex) {
     MockFileSystem::Reset();
 
     // Root dir
@@ -85,6 +91,22 @@ void RunBenchmark() {
 
     printf("Total entries in FS: %lu\n", MockFileSystem::sEntries.size());
 
+    // The index answers with a range of its paths instead of the folders
+    BookmarkIndex index;
+    if (useIndex) {
+        ino_t node = 1;
+        std::map<std::string, MockEntryData>::iterator it;
+        for (it = MockFileSystem::sEntries.begin();
+                it != MockFileSystem::sEntries.end(); ++it) {
+            if (it->second.isDirectory)
+                continue;
+            index.Put(node++, it->first.c_str(), "",
+                it->second.attributes["META:url"].c_str());
+        }
+        index.SetReady(true);
+        BookmarkIndex::SetDefault(&index);
+    }
+
     // Reset counters
     MockFileSystem::sGetNextEntryCount = 0;
     MockFileSystem::sOpenCount = 0;
@@ -103,7 +125,10 @@ void RunBenchmark() {
     gettimeofday(&end, NULL);
     double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
 
-    printf("AddBookmarkURLsRecursively finished in %.6f seconds\n", elapsed);
+    BookmarkIndex::SetDefault(NULL);
+
+    printf("AddBookmarkURLsRecursively (%s) finished in %.6f seconds\n",
+        useIndex ? "index" : "folders", elapsed);
     printf("Bookmarks found: %d\n", (int)addedCount);
     printf("GetNextEntry calls: %ld\n", MockFileSystem::sGetNextEntryCount);
     printf("BFile Open calls: %ld\n", MockFileSystem::sOpenCount);
@@ -112,6 +137,7 @@ void RunBenchmark() {
 
 int main() {
     printf("Running BookmarkQueryBenchmark...\n");
-    RunBenchmark();
+    RunBenchmark(false);
+    RunBenchmark(true);
     return 0;
 }
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <stdio.h>
+
+
+// The checks of a test. Each one prints whether it succeeded, unless
+// sQuietChecks is set, in which case only failures are printed. main()
+// ends with "return checkResult();".
+
+static int sFailures = 0;
+static bool sQuietChecks = false;
+
+
+static void
+check(bool condition, const char* what)
+{
+	if (!condition || !sQuietChecks)
+		printf("%s: %s\n", condition ? "SUCCESS" : "FAILURE", what);
+	if (!condition)
+		sFailures++;
+}
+
+
+static int
+checkResult()
+{
+	if (sFailures > 0) {
+		printf("%d check(s) failed\n", sFailures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
+
+#endif // TESTS_CHECK_H
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/MockFileSystem.cpp"
+#include "mocks/File.h"
+
+std::string BFile::content = "";
+
+#include "../support/ClosedTabStore.cpp"
+
+
+static const char* kLogPath = "/settings/ClosedTabs";
+
+
+static BMessage
+tabState(const char* url)
+{
+	BMessage state;
+	state.AddString("url", url);
+	return state;
+}
+
+
+static BString
+urlAt(const ClosedTabStore& store, int32 index)
+{
+	const ClosedTabStore::Entry* entry = store.EntryAt(index);
+	if (entry == NULL)
+		return "";
+	return entry->archive.GetString("url", "");
+}
+
+
+static size_t
+logSize()
+{
+	MockEntryData data;
+	if (!MockFileSystem::GetEntry(kLogPath, &data))
+		return 0;
+	return data.content.size();
+}
+
+
+int
+main()
+{
+	printf("Testing ClosedTabStore...\n");
+
+	MockFileSystem::Reset();
+	MockFileSystem::sFileContents = true;
+
+	// Replay
+	{
+		ClosedTabStore store((BPath(kLogPath)), 5, 2);
+		check(store.Load() == B_OK, "an empty store is loaded");
+		store.AddTab(tabState("https://a.example/"), 0, false);
+		uint32 b = store.AddTab(tabState("https://b.example/"), 1, false);
+		store.AddWindow(tabState("https://c.example/"), false);
+		store.AddTab(tabState("https://d.example/"), 2, false);
+		ClosedTabStore::Entry entry;
+		check(store.Take(b, entry)
+			&& BString(entry.archive.GetString("url", ""))
+				== "https://b.example/"
+			&& entry.archive.GetInt32("index", -1) == 1,
+			"a tab is taken with its index");
+
+		ClosedTabStore replayed((BPath(kLogPath)), 5, 2);
+		check(replayed.Load() == B_OK && replayed.CountEntries() == 3
+			&& urlAt(replayed, 0) == "https://d.example/"
+			&& urlAt(replayed, 1) == "https://c.example/"
+			&& replayed.EntryAt(1)->kind == ClosedTabStore::kWindow
+			&& urlAt(replayed, 2) == "https://a.example/",
+			"the log is replayed without the taken tab");
+		uint32 e = replayed.AddTab(tabState("https://e.example/"), 0, false);
+		check(e > 4, "ids are not reused after replay");
+	}
+
+	// Compaction
+	{
+		MockFileSystem::Reset();
+		MockFileSystem::sFileContents = true;
+
+		ClosedTabStore store((BPath(kLogPath)), 3, 2);
+		store.Load();
+		size_t largest = 0;
+		for (int32 i = 0; i < 20; i++) {
+			BString url;
+			url << "https://" << i << ".example/";
+			store.AddTab(tabState(url.String()), i, false);
+			if (logSize() > largest)
+				largest = logSize();
+		}
+		check(store.CountEntries() == 3
+			&& urlAt(store, 0) == "https://19.example/"
+			&& urlAt(store, 2) == "https://17.example/",
+			"only the newest entries are kept");
+		check(!MockFileSystem::GetEntry(std::string(kLogPath) + ".new", NULL),
+			"the compacted log replaced the old one");
+
+		ClosedTabStore replayed((BPath(kLogPath)), 3, 2);
+		check(replayed.Load() == B_OK && replayed.CountEntries() == 3
+			&& urlAt(replayed, 0) == "https://19.example/"
+			&& urlAt(replayed, 2) == "https://17.example/",
+			"the compacted log holds the same entries");
+		check(logSize() < largest, "loading compacts the log");
+	}
+
+	// Torn records
+	{
+		MockFileSystem::Reset();
+		MockFileSystem::sFileContents = true;
+
+		ClosedTabStore store((BPath(kLogPath)), 5, 2);
+		store.Load();
+		store.AddTab(tabState("https://a.example/"), 0, false);
+		store.AddTab(tabState("https://b.example/"), 1, false);
+
+		// A crash in the middle of writing the next record
+		BMessage record(ClosedTabStore::kTab);
+		record.AddUInt32("id", 100);
+		BMessage archive(tabState("https://torn.example/"));
+		record.AddMessage("archive", &archive);
+		int32 recordSize = record.FlattenedSize();
+		std::vector<char> buffer(recordSize);
+		record.Flatten(buffer.data(), recordSize);
+		std::string& content = MockFileSystem::sEntries[kLogPath].content;
+		content.append((const char*)&recordSize, sizeof(recordSize));
+		content.append(buffer.data(), recordSize / 2);
+
+		ClosedTabStore replayed((BPath(kLogPath)), 5, 2);
+		check(replayed.Load() == B_OK && replayed.CountEntries() == 2
+			&& urlAt(replayed, 0) == "https://b.example/",
+			"a torn record is ignored");
+		replayed.AddTab(tabState("https://c.example/"), 2, false);
+
+		ClosedTabStore again((BPath(kLogPath)), 5, 2);
+		check(again.Load() == B_OK && again.CountEntries() == 3
+			&& urlAt(again, 0) == "https://c.example/",
+			"records after a torn one are not lost");
+
+		MockFileSystem::sEntries[kLogPath].content.append("\xff\xff", 2);
+		ClosedTabStore truncated((BPath(kLogPath)), 5, 2);
+		check(truncated.Load() == B_OK && truncated.CountEntries() == 3,
+			"a torn record size is ignored");
+	}
+
+	// Private and persisted entries
+	{
+		MockFileSystem::Reset();
+		MockFileSystem::sFileContents = true;
+
+		ClosedTabStore store((BPath(kLogPath)), 3, 2);
+		store.Load();
+		store.AddTab(tabState("https://a.example/"), 0, false);
+		store.AddTab(tabState("https://b.example/"), 1, false);
+		for (int32 i = 0; i < 10; i++)
+			store.AddTab(tabState("https://private.example/"), i, true, 7);
+		check(store.CountEntries() == 4,
+			"private entries have their own limit");
+
+		int32 persisted = 0;
+		for (int32 i = 0; i < store.CountEntries(); i++) {
+			if (!store.EntryAt(i)->isPrivate)
+				persisted++;
+		}
+		check(persisted == 2, "private entries do not evict persisted ones");
+
+		std::vector<BMessage> states;
+		for (int32 i = 0; i < 5; i++)
+			states.push_back(tabState("https://window.example/"));
+		store.AddTabs(states, true, 8);
+		check(store.CountEntries() == 4, "a private window adds at most the "
+			"private limit");
+
+		ClosedTabStore::Entry entry;
+		check(store.TakeLast(ClosedTabStore::kTab, false, entry)
+			&& BString(entry.archive.GetString("url", ""))
+				== "https://b.example/",
+			"private entries are skipped unless asked for");
+
+		ClosedTabStore replayed((BPath(kLogPath)), 3, 2);
+		check(replayed.Load() == B_OK && replayed.CountEntries() == 1
+			&& urlAt(replayed, 0) == "https://a.example/",
+			"private entries are never written");
+
+		store.RemovePrivate(8);
+		check(store.CountEntries() == 1 && !store.EntryAt(0)->isPrivate,
+			"closing the private window drops its entries");
+	}
+
+	return checkResult();
+}
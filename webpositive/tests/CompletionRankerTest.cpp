@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+
+#include "../support/BaseURL.cpp"
+#include "../support/CompletionRanker.cpp"
+
+
+int
+main()
+{
+	printf("Testing CompletionRanker...\n");
+
+	BString key;
+	normalizeURL("https://www.Haiku-OS.org/Blog/#top", key);
+	check(key == "haiku-os.org/Blog", "scheme, www, fragment and trailing "
+		"slash are ignored, the host is lower cased");
+
+	CompletionRanker ranker("haiku");
+	check(ranker.Add(CompletionRanker::kHistory,
+		"https://www.haiku-os.org/", "", 10), "history match is added");
+	check(ranker.Add(CompletionRanker::kHistory,
+		"https://example.com/haiku", "", 50), "path match is added");
+	check(!ranker.Add(CompletionRanker::kHistory,
+		"https://example.com/", "", 50), "other URLs are not added");
+	check(ranker.Add(CompletionRanker::kBookmark,
+		"http://haiku-os.org", "Haiku Project", 0),
+		"bookmark of a known page is merged");
+	check(ranker.Add(CompletionRanker::kBookmark,
+		"https://webkit.org/", "Haiku WebKit port", 0),
+		"bookmark matching by title is added");
+	check(ranker.CountCandidates() == 3, "pages are listed once");
+
+	std::vector<CompletionRanker::Candidate> results;
+	ranker.Rank(10, results);
+	check(results[0].url == "https://www.haiku-os.org/"
+		&& results[0].sources
+			== (CompletionRanker::kHistory | CompletionRanker::kBookmark)
+		&& results[0].title == "Haiku Project",
+		"merged page ranks first and keeps what both sources know");
+	check(results[1].url == "https://webkit.org/" && results[1].matchPos < 0,
+		"bookmarks rank above history");
+	check(results[2].url == "https://example.com/haiku",
+		"history is ranked last");
+
+	CompletionRanker words("haiku news");
+	check(!words.Add(CompletionRanker::kHistory,
+		"https://www.haiku-os.org/news/", "", 0)
+		&& words.Add(CompletionRanker::kBookmark,
+			"https://www.haiku-os.org/news/", "", 0, true),
+		"pages matched by their source are added");
+
+	CompletionRanker tabs("example");
+	tabs.Add(CompletionRanker::kHistory, "https://example.com/a", "", 0);
+	tabs.Add(CompletionRanker::kOpenTab, "https://example.com/b", "", 0);
+	tabs.Add(CompletionRanker::kHistory, "https://example.com/b", "", 0);
+	tabs.Rank(1, results);
+	check(results.size() == 1 && results[0].url == "https://example.com/b",
+		"open tabs are boosted and results are limited");
+
+	return checkResult();
+}
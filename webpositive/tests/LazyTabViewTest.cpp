@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/Autolock.h"
+#include "mocks/Bitmap.h"
+#include "mocks/WebView.h"
+
+#include "../support/PreviewCache.cpp"
+#include "../LazyTabView.cpp"
+
+
+static PageUserData*
+makeUserData(uint32 id)
+{
+	PageUserData* userData = new PageUserData(NULL);
+	userData->SetId(id);
+	userData->SetPreview(new BBitmap(BRect(0, 0, 199, 149), B_RGB32));
+	return userData;
+}
+
+
+int
+main()
+{
+	printf("Testing LazyTabView...\n");
+
+	// What TabManager::GetPreview() does when a tab is hovered
+	BWebView webView("web view");
+	PageUserData* loaded = makeUserData(1);
+	webView.SetUserData(loaded);
+	check(PageUserData::ForTabView(&webView) == loaded
+		&& PageUserData::ForTabView(&webView)->Preview() != NULL,
+		"a loaded tab has a preview");
+	webView.SetUserData(NULL);
+	delete loaded;
+
+	PageUserData* discarded = makeUserData(2);
+	discarded->SetIsLazy(true);
+	discarded->SetIsDiscarded(true);
+	LazyTabView lazyView(discarded);
+	uint32 generation = 0;
+	check(PageUserData::ForTabView(&lazyView) == discarded
+		&& PageUserData::ForTabView(&lazyView)->Preview(&generation) != NULL
+		&& generation != 0,
+		"a discarded tab still has its preview");
+
+	LazyTabView emptyView(NULL);
+	BView otherView("other", 0);
+	check(PageUserData::ForTabView(&emptyView) == NULL
+		&& PageUserData::ForTabView(&otherView) == NULL
+		&& PageUserData::ForTabView(NULL) == NULL,
+		"other views have no user data");
+
+	// Discarding a tab and loading it again, as BrowserWindow does it
+	BWebView* page = new BWebView("web view");
+	PageUserData* tabData = makeUserData(3);
+	page->SetUserData(tabData);
+	LazyTabView* placeholder = LazyTabView::TakeOver(page);
+	check(placeholder != NULL && placeholder->UserData() == tabData
+		&& page->GetUserData() == NULL,
+		"the placeholder of a discarded tab takes over its user data");
+	page->Shutdown();
+	delete page;
+
+	BWebView* reloaded = new BWebView("web view");
+	placeholder->HandOver(reloaded);
+	check(reloaded->GetUserData() == tabData
+		&& placeholder->UserData() == NULL,
+		"the user data moves into the web view of the reloaded tab");
+	delete placeholder;
+	check(PreviewCache::Default().Get(3) != NULL,
+		"the user data outlives the placeholder");
+	reloaded->Shutdown();
+	delete tabData;
+	delete reloaded;
+	check(PreviewCache::Default().Get(3) == NULL,
+		"the user data is gone with the tab");
+
+	PageUserData* detached = lazyView.DetachUserData();
+	check(detached == discarded && PageUserData::ForTabView(&lazyView) == NULL,
+		"user data moves out with the page");
+	delete detached;
+
+	return checkResult();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/Autolock.h"
+#include "mocks/Bitmap.h"
+
+#include "../support/PreviewCache.cpp"
+
+
+static const int32 kWidth = 200;
+static const int32 kHeight = 150;
+static const size_t kPreviewSize = kWidth * kHeight * 4;
+
+
+static BBitmap*
+makePreview(uint8 seed)
+{
+	BBitmap* bitmap = new BBitmap(BRect(0, 0, kWidth - 1, kHeight - 1),
+		B_RGB32);
+	uint8* bits = (uint8*)bitmap->Bits();
+	for (int32 y = 0; y < kHeight; y++) {
+		uint8* row = bits + y * bitmap->BytesPerRow();
+		for (int32 x = 0; x < kWidth; x++) {
+			// A flat page background with a few noisy "text" lines
+			bool text = (y % 20) < 3 && x > 20 && x < 180;
+			row[x * 4 + 0] = text ? (uint8)(x * 7 + seed) : 0xf0;
+			row[x * 4 + 1] = text ? (uint8)(y * 13 + seed) : 0xf0;
+			row[x * 4 + 2] = text ? (uint8)(x ^ y) : (uint8)(0xf0 - seed);
+			row[x * 4 + 3] = 255;
+		}
+	}
+	return bitmap;
+}
+
+
+static bool
+samePixels(const BBitmap* a, const BBitmap* b)
+{
+	for (int32 y = 0; y < kHeight; y++) {
+		const uint8* rowA = (const uint8*)a->Bits() + y * a->BytesPerRow();
+		const uint8* rowB = (const uint8*)b->Bits() + y * b->BytesPerRow();
+		if (memcmp(rowA, rowB, kWidth * 4) != 0)
+			return false;
+	}
+	return true;
+}
+
+
+int
+main()
+{
+	printf("Testing PreviewCache...\n");
+
+	// Room for two uncompressed previews; at most one stays uncompressed.
+	PreviewCache cache(kPreviewSize * 2);
+
+	BBitmap* reference = makePreview(1);
+	cache.Put(1, new BBitmap(reference));
+	uint32 generation1 = cache.GenerationFor(1);
+	check(generation1 != 0, "stored preview has a generation");
+
+	cache.Put(2, makePreview(2));
+	check(cache.CountCompressedEntries() == 1,
+		"least recently used preview got compressed");
+	check(cache.MemoryUsage() <= cache.Budget(), "usage within budget");
+
+	// Keep a reference to the hot preview, then let the cache evict it.
+	PreviewCache::PreviewRef held = cache.Get(2);
+	check(held != NULL, "hot preview is returned");
+
+	uint32 generation = 0;
+	PreviewCache::PreviewRef decoded = cache.Get(1, &generation);
+	check(decoded != NULL, "compressed preview is regenerated on access");
+	check(generation == generation1, "regeneration keeps the generation");
+	check(decoded != NULL && samePixels(decoded.get(), reference),
+		"compression round trip is lossless");
+	check(held->Bits() != NULL && cache.CountCompressedEntries() == 1,
+		"handed out preview survives compression");
+
+	// Replacing a preview bumps its generation
+	cache.Put(1, makePreview(3));
+	check(cache.GenerationFor(1) != generation1,
+		"new preview gets a new generation");
+
+	// Fill way past the budget: old previews get dropped entirely
+	for (uint32 id = 10; id < 100; id++)
+		cache.Put(id, makePreview((uint8)id));
+	check(cache.MemoryUsage() <= cache.Budget(), "usage within budget after "
+		"many inserts");
+	check(cache.Get(99) != NULL, "most recent preview is kept");
+	check(cache.Get(10) == NULL, "oldest preview was dropped");
+
+	// Explicitly encoded previews decode to the same pixels
+	cache.Put(98, new BBitmap(reference));
+	size_t usage = cache.MemoryUsage();
+	cache.Compress(98);
+	check(cache.MemoryUsage() < usage, "compressing shrinks the preview");
+	PreviewCache::PreviewRef frozen = cache.Get(98);
+	check(frozen != NULL && samePixels(frozen.get(), reference),
+		"compressed preview decodes unchanged");
+
+	cache.Remove(99);
+	check(cache.GenerationFor(99) == 0, "removed preview is gone");
+
+	// Shrinking the budget evicts immediately
+	cache.SetBudget(0);
+	check(cache.CountEntries() == 0, "zero budget empties the cache");
+
+	delete reference;
+
+	return checkResult();
+}
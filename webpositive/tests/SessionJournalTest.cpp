@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+#include "mocks/MockFileSystem.cpp"
+#include "mocks/File.h"
+
+std::string BFile::content = "";
+
+#include "../support/SessionJournal.cpp"
+
+
+static const char* kSnapshotPath = "/settings/Session";
+static const char* kJournalPath = "/settings/SessionJournal";
+
+
+static BMessage
+makeEvent(uint32 what, uint32 window, uint32 tab, const char* url,
+	bool isPrivate)
+{
+	BMessage event(what);
+	event.AddUInt32("window", window);
+	if (tab != 0)
+		event.AddUInt32("tab", tab);
+	if (isPrivate)
+		event.AddBool("private", true);
+	if (what == SessionJournal::kWindowOpened)
+		event.AddRect("frame", BRect(10, 10, 610, 410));
+	if (url != NULL) {
+		BMessage state;
+		state.AddString("url", url);
+		event.AddMessage("state", &state);
+	}
+	return event;
+}
+
+
+static void
+recordWindow(SessionJournal& journal, uint32 window, uint32 tab,
+	const char* url, bool isPrivate)
+{
+	journal.Record(makeEvent(SessionJournal::kWindowOpened, window, 0, NULL,
+		isPrivate));
+	journal.Record(makeEvent(SessionJournal::kTabOpened, window, tab, url,
+		isPrivate));
+	journal.Record(makeEvent(SessionJournal::kTabSelected, window, tab, NULL,
+		isPrivate));
+}
+
+
+static bool
+onDisk(const char* text)
+{
+	std::map<std::string, MockEntryData>::iterator it;
+	for (it = MockFileSystem::sEntries.begin();
+			it != MockFileSystem::sEntries.end(); ++it) {
+		if (it->second.content.find(text) != std::string::npos)
+			return true;
+	}
+	return false;
+}
+
+
+static int32
+countWindows(const BMessage& session)
+{
+	type_code type;
+	int32 count;
+	if (session.GetInfo("window", &type, &count) != B_OK)
+		return 0;
+	return count;
+}
+
+
+int
+main()
+{
+	printf("Testing SessionJournal...\n");
+
+	MockFileSystem::Reset();
+	MockFileSystem::sFileContents = true;
+
+	SessionJournal journal((BPath(kSnapshotPath)), BPath(kJournalPath));
+	check(journal.Start() == B_OK, "the journal is started");
+
+	recordWindow(journal, 1, 10, "https://www.haiku-os.org/", false);
+	recordWindow(journal, 2, 20, "https://private.example/", true);
+	journal.Record(makeEvent(SessionJournal::kTabNavigated, 2, 20,
+		"https://private.example/inbox", true));
+	journal.Record(makeEvent(SessionJournal::kWindowChanged, 2, 0, NULL,
+		true));
+	check(journal.CountPendingRecords() == 3,
+		"only the events of the normal window are recorded");
+	check(onDisk("haiku-os.org") && !onDisk("private.example"),
+		"nothing of the private window is written");
+
+	// After a crash
+	SessionJournal recovered((BPath(kSnapshotPath)), BPath(kJournalPath));
+	BMessage session;
+	check(recovered.HasSession() && recovered.Recover(session) == B_OK,
+		"the session is recovered from the journal");
+	BMessage window;
+	BMessage tab;
+	check(countWindows(session) == 1
+		&& session.FindMessage("window", 0, &window) == B_OK
+		&& window.GetUInt32("window id", 0) == 1
+		&& window.FindMessage("tab state", 0, &tab) == B_OK
+		&& BString(tab.GetString("url", "")) == "https://www.haiku-os.org/",
+		"only the normal window comes back");
+
+	// Compacting writes the session as a snapshot
+	check(journal.Compact() == B_OK && journal.CountPendingRecords() == 0,
+		"the journal is compacted");
+	journal.Record(makeEvent(SessionJournal::kTabNavigated, 2, 20,
+		"https://private.example/settings", true));
+	check(journal.CountPendingRecords() == 0 && !onDisk("private.example"),
+		"the private window stays out of the snapshot and journal");
+	session.MakeEmpty();
+	check(recovered.Recover(session) == B_OK && countWindows(session) == 1,
+		"the snapshot holds the normal window");
+
+	return checkResult();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+
+#include "../support/TabDiscardPolicy.cpp"
+
+
+static const uint64 kMiB = 1024 * 1024;
+
+
+static TabDiscardPolicy::TabInfo
+makeTab(uint32 id, bigtime_t lastActivation, uint64 cost)
+{
+	TabDiscardPolicy::TabInfo tab;
+	tab.id = id;
+	tab.lastActivation = lastActivation;
+	tab.estimatedCost = cost;
+	return tab;
+}
+
+
+static bool
+contains(const std::vector<uint32>& ids, uint32 id)
+{
+	return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+
+int
+main()
+{
+	printf("Testing TabDiscardPolicy...\n");
+
+	TabDiscardPolicy policy;
+	check(policy.IsUnderPressure(95, 100), "95% used is pressure");
+	check(!policy.IsUnderPressure(85, 100), "85% used is no pressure");
+	check(policy.TargetBytes(1000 * kMiB) == 800 * kMiB, "default target");
+
+	std::vector<TabDiscardPolicy::TabInfo> tabs;
+	tabs.push_back(makeTab(1, 500, 100 * kMiB));
+	tabs.push_back(makeTab(2, 100, 100 * kMiB));
+	tabs.push_back(makeTab(3, 300, 100 * kMiB));
+	tabs.push_back(makeTab(4, 200, 100 * kMiB));
+
+	// 150 MiB over target: the two least recently activated tabs go
+	std::vector<uint32> victims = policy.SelectVictims(tabs, 950 * kMiB,
+		800 * kMiB);
+	check(victims.size() == 2, "discards only as many tabs as needed");
+	check(victims.size() == 2 && victims[0] == 2 && victims[1] == 4,
+		"discards least recently activated tabs first");
+
+	victims = policy.SelectVictims(tabs, 700 * kMiB, 800 * kMiB);
+	check(victims.empty(), "nothing is discarded below the target");
+
+	// Protected tabs are skipped in favor of newer ones
+	tabs[1].pinned = true;
+	tabs[3].playingMedia = true;
+	tabs[2].dirtyForm = true;
+	victims = policy.SelectVictims(tabs, 950 * kMiB, 800 * kMiB);
+	check(victims.size() == 1 && victims[0] == 1,
+		"pinned, playing and edited tabs are kept");
+
+	tabs[0].current = true;
+	victims = policy.SelectVictims(tabs, 950 * kMiB, 800 * kMiB);
+	check(victims.empty(), "the current tab is kept");
+
+	// Unloaded or loading tabs do not free anything
+	TabDiscardPolicy::TabInfo lazy = makeTab(5, 0, 100 * kMiB);
+	lazy.loaded = false;
+	TabDiscardPolicy::TabInfo loading = makeTab(6, 0, 100 * kMiB);
+	loading.loading = true;
+	tabs.push_back(lazy);
+	tabs.push_back(loading);
+	victims = policy.SelectVictims(tabs, 950 * kMiB, 800 * kMiB);
+	check(!contains(victims, 5) && !contains(victims, 6),
+		"unloaded and loading tabs are skipped");
+
+	// A target of zero unloads every tab that may be unloaded
+	tabs.clear();
+	for (uint32 id = 1; id <= 10; id++)
+		tabs.push_back(makeTab(id, id, TabDiscardPolicy::EstimateCost(1000)));
+	victims = policy.SelectVictims(tabs, 2000 * kMiB, 0);
+	check(victims.size() == 10, "zero target discards all candidates");
+
+	policy.SetTargetPercent(95);
+	check(policy.TriggerPercent() >= policy.TargetPercent(),
+		"trigger never lies below the target");
+
+	return checkResult();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+
+#include "../support/TabDiscardPolicy.cpp"
+#include "../support/TabRegistry.cpp"
+
+
+static const uint64 kMiB = 1024 * 1024;
+
+
+static TabDiscardPolicy::TabInfo
+makeTab(uint32 id, bigtime_t lastActivation, uint64 cost)
+{
+	TabDiscardPolicy::TabInfo tab;
+	tab.id = id;
+	tab.lastActivation = lastActivation;
+	tab.estimatedCost = cost;
+	return tab;
+}
+
+
+int
+main()
+{
+	printf("Testing TabRegistry...\n");
+
+	TabRegistry registry;
+
+	// A window with a few old tabs, and a busy one with many recent ones
+	registry.Update(1, makeTab(10, 100, 50 * kMiB));
+	registry.Update(1, makeTab(11, 200, 50 * kMiB));
+	for (uint32 id = 20; id < 30; id++)
+		registry.Update(2, makeTab(id, 1000 + id, 100 * kMiB));
+	check(registry.CountTabs() == 12, "tabs of all windows are known");
+	check(registry.EstimatedUsage() == 1100 * kMiB, "usage adds up");
+
+	TabDiscardPolicy policy;
+	std::vector<TabRegistry::Victim> victims
+		= registry.SelectVictims(policy, 1000 * kMiB, 850 * kMiB);
+	check(victims.size() == 3, "only as many tabs as needed are unloaded");
+	check(victims.size() == 3 && victims[0].windowId == 1
+		&& victims[0].tabId == 10 && victims[1].tabId == 11
+		&& victims[2].windowId == 2 && victims[2].tabId == 20,
+		"least recently used tabs go first across windows");
+
+	// Updates replace what was known about a tab
+	TabDiscardPolicy::TabInfo tab = makeTab(10, 5000, 50 * kMiB);
+	registry.Update(1, tab);
+	victims = registry.SelectVictims(policy, 1000 * kMiB, 950 * kMiB);
+	check(victims.size() == 1 && victims[0].tabId == 11,
+		"activating a tab moves it to the back of the line");
+
+	tab.loaded = false;
+	registry.Update(1, tab);
+	check(registry.CountLoadedTabs() == 11, "unloaded tabs are counted apart");
+
+	registry.Remove(11);
+	check(registry.CountTabs() == 11, "closed tab is forgotten");
+
+	registry.RemoveWindow(2);
+	check(registry.CountTabs() == 1, "closed window takes its tabs along");
+	victims = registry.SelectVictims(policy, 1000 * kMiB, 0);
+	check(victims.empty(), "nothing left to unload");
+
+	return checkResult();
+}
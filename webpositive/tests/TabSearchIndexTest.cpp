@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+
+#include "Check.h"
+#include "mocks/SupportDefs.h"
+
+#include "../support/TabSearchIndex.cpp"
+
+
+static TabSearchIndex::Tab
+makeTab(uint32 id, const char* title, const char* url)
+{
+	TabSearchIndex::Tab tab;
+	tab.windowId = 0;
+	tab.tabId = id;
+	tab.title = title;
+	tab.url = url;
+	return tab;
+}
+
+
+int
+main()
+{
+	printf("Testing TabSearchIndex...\n");
+
+	TabSearchIndex index;
+
+	std::vector<TabSearchIndex::Tab> first;
+	first.push_back(makeTab(1, "Haiku Project", "https://www.haiku-os.org/"));
+	first.push_back(makeTab(2, "Bug tracker", "https://dev.haiku-os.org/"));
+	first.push_back(makeTab(3, "News", "https://news.example.com/"));
+	index.SetWindowTabs(1, first);
+
+	std::vector<TabSearchIndex::Tab> second;
+	second.push_back(makeTab(4, "WebKit documentation", "https://webkit.org/"));
+	second.push_back(makeTab(5, "Weather", "https://weather.example.com/"));
+	index.SetWindowTabs(2, second);
+	check(index.CountTabs() == 5, "tabs of all windows are indexed");
+
+	std::vector<TabSearchIndex::Match> matches = index.Search("");
+	check(matches.size() == 5, "an empty query lists every tab");
+	check(index.TabAt(matches[0].index).tabId == 1
+		&& index.TabAt(matches[4].index).tabId == 5,
+		"an empty query keeps the window and tab order");
+
+	matches = index.Search("HAIKU");
+	check(matches.size() == 2, "matching ignores case");
+	check(index.TabAt(matches[0].index).tabId == 1,
+		"a title match ranks above a URL match");
+
+	// Fuzzy matching: the characters only need to appear in order
+	matches = index.Search("wkd");
+	check(matches.size() == 1 && index.TabAt(matches[0].index).tabId == 4,
+		"word starts are matched fuzzily");
+
+	check(TabSearchIndex::Score("bug tracker", "bug")
+		> TabSearchIndex::Score("buzzing", "bug"),
+		"consecutive characters score higher");
+	check(TabSearchIndex::Score("news", "nwx") < 0,
+		"missing characters do not match");
+
+	// Extending the query only searches the previous matches again
+	matches = index.Search("we");
+	int32 wideMatches = matches.size();
+	check(index.LastCandidateCount() == 5, "a new query searches every tab");
+	matches = index.Search("wea");
+	check(index.LastCandidateCount() == wideMatches,
+		"an extended query only searches the previous matches");
+	check(index.TabAt(matches[0].index).tabId == 5,
+		"the closest match comes first");
+
+	TabSearchIndex fresh;
+	fresh.SetWindowTabs(1, first);
+	fresh.SetWindowTabs(2, second);
+	std::vector<TabSearchIndex::Match> full = fresh.Search("wea");
+	bool same = full.size() == matches.size();
+	for (size_t i = 0; same && i < full.size(); i++) {
+		same = full[i].index == matches[i].index
+			&& full[i].score == matches[i].score;
+	}
+	check(same, "narrowing gives the same result as a full search");
+
+	matches = index.Search("w");
+	check(index.LastCandidateCount() == 5,
+		"a shortened query searches every tab again");
+
+	// Replacing a window's tabs invalidates the previous matches
+	index.Search("ne");
+	std::vector<TabSearchIndex::Tab> replaced;
+	replaced.push_back(makeTab(6, "Networking", "https://example.net/"));
+	index.SetWindowTabs(2, replaced);
+	matches = index.Search("new");
+	check(index.LastCandidateCount() == 4,
+		"changed tabs are searched after an update");
+	check(matches.size() == 2, "new tabs are found after an update");
+	check(index.TabAt(0).windowId == 1 && index.TabAt(3).windowId == 2,
+		"an updated window keeps its place");
+
+	index.RemoveWindow(1);
+	check(index.CountTabs() == 1, "closed windows are dropped");
+
+	return checkResult();
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2024 Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <vector>
+
+#include "mocks/SupportDefs.h"
+
+#include "../tabview/TabViewIndex.cpp"
+
+
+// Only the addresses of the views matter to the index
+class BView {
+public:
+	int32 dummy;
+};
+
+static const int kLookups = 200000;
+
+
+static double
+now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+// What TabManager::TabForView() used to do: walk the card layout items.
+static int32
+linearIndexOf(const std::vector<const BView*>& views, const BView* view)
+{
+	for (size_t i = 0; i < views.size(); i++) {
+		if (views[i] == view)
+			return (int32)i;
+	}
+	return -1;
+}
+
+
+static bool
+agrees(const TabViewIndex& index, const std::vector<const BView*>& views)
+{
+	if (index.CountViews() != (int32)views.size())
+		return false;
+	for (size_t i = 0; i < views.size(); i++) {
+		if (index.IndexOf(views[i]) != (int32)i)
+			return false;
+	}
+	return true;
+}
+
+
+static bool
+checkConsistency()
+{
+	// Random tab operations, compared against a plain list
+	std::vector<BView> storage(300);
+	std::vector<const BView*> views;
+	TabViewIndex index;
+	size_t nextView = 0;
+
+	srand(42);
+	for (int i = 0; i < 2000; i++) {
+		int operation = rand() % 4;
+		int32 count = (int32)views.size();
+		if ((operation == 0 || count == 0) && nextView < storage.size()) {
+			int32 at = rand() % (count + 1);
+			const BView* view = &storage[nextView++];
+			views.insert(views.begin() + at, view);
+			index.Insert(at, view);
+		} else if (operation == 1 && count > 0) {
+			int32 at = rand() % count;
+			views.erase(views.begin() + at);
+			index.Remove(at);
+		} else if (operation == 2 && count > 1) {
+			int32 from = rand() % count;
+			int32 to = rand() % count;
+			const BView* view = views[from];
+			views.erase(views.begin() + from);
+			views.insert(views.begin() + to, view);
+			index.Move(from, to);
+		} else if (operation == 3 && count > 0 && nextView < storage.size()) {
+			int32 at = rand() % count;
+			const BView* replaced = views[at];
+			views[at] = &storage[nextView++];
+			index.Replace(at, views[at]);
+			if (index.IndexOf(replaced) != -1)
+				return false;
+		}
+		if (!agrees(index, views))
+			return false;
+	}
+	return true;
+}
+
+
+static void
+benchmark(int32 tabCount)
+{
+	std::vector<BView> storage(tabCount);
+	std::vector<const BView*> views;
+	TabViewIndex index;
+	for (int32 i = 0; i < tabCount; i++) {
+		views.push_back(&storage[i]);
+		index.Insert(i, &storage[i]);
+	}
+
+	// Callbacks come from all tabs, but mostly from the ones loading
+	// in the background, so pick them at random.
+	std::vector<const BView*> callers;
+	srand(tabCount);
+	for (int i = 0; i < kLookups; i++)
+		callers.push_back(views[rand() % tabCount]);
+
+	int64 checksum = 0;
+	double start = now();
+	for (int i = 0; i < kLookups; i++)
+		checksum += linearIndexOf(views, callers[i]);
+	double linear = now() - start;
+
+	start = now();
+	for (int i = 0; i < kLookups; i++)
+		checksum -= index.IndexOf(callers[i]);
+	double indexed = now() - start;
+
+	printf("%5d tabs: linear %8.1f ns, indexed %6.1f ns per lookup%s\n",
+		(int)tabCount, linear * 1e9 / kLookups, indexed * 1e9 / kLookups,
+		checksum == 0 ? "" : " (MISMATCH)");
+}
+
+
+int
+main()
+{
+	printf("TabViewIndex benchmark\n");
+
+	bool consistent = checkConsistency();
+	printf("%s: index follows inserts, removals, moves and replacements\n",
+		consistent ? "SUCCESS" : "FAILURE");
+
+	benchmark(10);
+	benchmark(100);
+	benchmark(1000);
+
+	return consistent ? 0 : 1;
+}
@@ -1,27 +1,62 @@
 #ifndef _MOCK_BITMAP_H
 #define _MOCK_BITMAP_H
 #include "SupportDefs.h"
+#include <vector>
+
+class BView;
 
 enum color_space { B_CMAP8, B_RGBA32, B_RGB32 };
 enum { B_BITMAP_NO_SERVER_LINK = 0 };
 
 class BRect {
 public:
-    BRect(float l, float t, float r, float b) {}
-    int32 IntegerWidth() const { return 0; }
+    float left, top, right, bottom;
+    BRect() : left(0), top(0), right(-1), bottom(-1) {}
+    BRect(float l, float t, float r, float b) : left(l), top(t), right(r), bottom(b) {}
+    int32 IntegerWidth() const { return (int32)(right - left); }
+    int32 IntegerHeight() const { return (int32)(bottom - top); }
+    float Width() const { return right - left; }
+    float Height() const { return bottom - top; }
 };
 
 class BBitmap {
 public:
-    BBitmap(BRect bounds, uint32 flags, color_space space) {}
-    BBitmap(BRect bounds, color_space space) {}
+    BBitmap(BRect bounds, uint32 flags, color_space space) { _Init(bounds, space); }
+    BBitmap(BRect bounds, color_space space) { _Init(bounds, space); }
+    BBitmap(BRect bounds, color_space space, bool acceptsViews) { _Init(bounds, space); }
+    BBitmap(const BBitmap* source)
+        : fBounds(source->fBounds), fSpace(source->fSpace),
+          fBytesPerRow(source->fBytesPerRow), fData(source->fData) {}
     status_t InitCheck() { return B_OK; }
-    void* Bits() const { return (void*)buffer; }
-    int32 BitsLength() const { return 0; }
+    bool IsValid() const { return true; }
+    bool Lock() { return true; }
+    void Unlock() {}
+    void AddChild(BView* view) {}
+    bool RemoveChild(BView* view) { return true; }
+    void* Bits() const { return fData.empty() ? (void*)buffer : (void*)fData.data(); }
+    int32 BitsLength() const { return (int32)fData.size(); }
     void SetBits(const void* data, int32 length, int32 offset, color_space space) {}
     status_t ImportBits(const void* data, int32 length, int32 bpr, int32 offset, color_space space) { return B_OK; }
-    int32 BytesPerRow() const { return 0; }
+    int32 BytesPerRow() const { return fBytesPerRow; }
+    BRect Bounds() const { return fBounds; }
+    color_space ColorSpace() const { return fSpace; }
 
     char buffer[100];
+
+private:
+    void _Init(BRect bounds, color_space space) {
+        fBounds = bounds;
+        fSpace = space;
+        int32 width = bounds.IntegerWidth() + 1;
+        int32 height = bounds.IntegerHeight() + 1;
+        fBytesPerRow = space == B_CMAP8 ? (width + 3) & ~3 : width * 4;
+        if (width > 0 && height > 0)
+            fData.resize((size_t)fBytesPerRow * height);
+    }
+
+    BRect fBounds;
+    color_space fSpace;
+    int32 fBytesPerRow;
+    std::vector<uint8> fData;
 };
 #endif
@@ -2,10 +2,13 @@
 #define BOOKMARK_MANAGER_H
 #include "SupportDefs.h"
 #include "Path.h"
+#include "Messenger.h"
 
 class BookmarkManager {
 public:
     static status_t ExportBookmarks(const BPath& path) { return B_OK; }
-    static status_t ImportBookmarks(const BPath& path) { return B_OK; }
+    static status_t ImportBookmarks(const BPath& path,
+        const BMessenger& progressTarget = BMessenger(), bool merge = false)
+        { return B_OK; }
 };
 #endif
@@ -50,8 +50,39 @@ public:
     }
 
     status_t InitCheck() { return B_OK; }
-    status_t Rename(const char* path, bool clobber = false) { return B_OK; }
-    status_t Remove() { return B_OK; }
+    status_t Rename(const char* path, bool clobber = false) {
+        if (!MockFileSystem::sFileContents)
+            return B_OK;
+        std::map<std::string, MockEntryData>::iterator it
+            = MockFileSystem::sEntries.find(fPath);
+        if (it == MockFileSystem::sEntries.end())
+            return B_ENTRY_NOT_FOUND;
+        // A leaf name stays in the same directory
+        std::string target = path;
+        if (target.find('/') == std::string::npos) {
+            size_t slash = fPath.rfind('/');
+            if (slash != std::string::npos)
+                target = fPath.substr(0, slash + 1) + target;
+        }
+        if (!clobber && MockFileSystem::sEntries.count(target) > 0)
+            return B_FILE_EXISTS;
+        MockEntryData data = it->second;
+        MockFileSystem::sEntries.erase(it);
+        data.path = target;
+        data.name = target.substr(target.rfind('/') + 1);
+        MockFileSystem::sEntries[target] = data;
+        MockFileSystem::sRenamed[fPath] = target;
+        fPath = target;
+        fName = data.name;
+        return B_OK;
+    }
+    status_t Remove() {
+        if (!MockFileSystem::sFileContents)
+            return B_OK;
+        fExists = false;
+        return MockFileSystem::sEntries.erase(fPath) > 0
+            ? B_OK : B_ENTRY_NOT_FOUND;
+    }
     BEntry() : fExists(false) {}
     status_t SetTo(const char* path, bool traverse = false) {
         *this = BEntry(path, traverse);
@@ -5,6 +5,7 @@
 #include "String.h"
 #include "Node.h"
 #include "MockFileSystem.h"
+#include "Message.h"
 #include <string>
 
 enum {
@@ -12,38 +13,57 @@ enum {
     B_WRITE_ONLY = 2,
     B_CREATE_FILE = 4,
     B_ERASE_FILE = 8,
-    B_OPEN_AT_END = 16
+    B_OPEN_AT_END = 16,
+    B_FAIL_IF_EXISTS = 32
 };
 
 class BFile : public BNode {
 public:
     off_t fPosition;
 
-    BFile() : BNode(), fPosition(0) {}
+    BFile() : BNode(), fPosition(0), fStatus(B_OK) {}
 
     off_t Seek(off_t offset, uint32 seekMode) {
         if (seekMode == SEEK_SET) fPosition = offset;
         else if (seekMode == SEEK_CUR) fPosition += offset;
-        else if (seekMode == SEEK_END) fPosition = content.length() + offset;
+        else if (seekMode == SEEK_END) fPosition = _Content().length() + offset;
         return fPosition;
     }
 
-    BFile(const char* path, uint32 mode) : BNode(), fPosition(0) {
+    BFile(const char* path, uint32 mode) : BNode(), fPosition(0),
+        fStatus(B_OK) {
         MockFileSystem::sOpenCount++;
         // Load attrs if exists
         MockEntryData data;
-        if (MockFileSystem::GetEntry(path, &data)) {
+        if (MockFileSystem::GetEntry(path, &data)
+            && (mode & B_CREATE_FILE) && (mode & B_FAIL_IF_EXISTS)) {
+            fStatus = B_FILE_EXISTS;
+        } else if (MockFileSystem::GetEntry(path, &data)) {
             fAttributes = data.attributes;
-        }
-        if (mode & B_OPEN_AT_END) fPosition = content.length();
+            fPath = path;
+            if (MockFileSystem::sFileContents && (mode & B_ERASE_FILE))
+                MockFileSystem::sEntries[fPath].content.clear();
+        } else if (mode & B_CREATE_FILE) {
+            // Created files show up in their directory
+            const char* leaf = strrchr(path, '/');
+            data.name = leaf != NULL ? leaf + 1 : path;
+            data.path = path;
+            data.isDirectory = false;
+            MockFileSystem::AddEntry(path, data);
+            fPath = path;
+        } else if (MockFileSystem::sFileContents)
+            fStatus = B_ENTRY_NOT_FOUND;
+        if (mode & B_OPEN_AT_END) fPosition = _Content().length();
     }
 
-    BFile(const BEntry* entry, uint32 mode) : BNode(entry), fPosition(0) {
+    BFile(const BEntry* entry, uint32 mode) : BNode(entry), fPosition(0),
+        fStatus(B_OK) {
         MockFileSystem::sOpenCount++;
         if (mode & B_OPEN_AT_END) fPosition = content.length();
     }
 
-    BFile(const entry_ref* ref, uint32 mode) : BNode(), fPosition(0) {
+    BFile(const entry_ref* ref, uint32 mode) : BNode(), fPosition(0),
+        fStatus(B_OK) {
         MockFileSystem::sOpenCount++;
         if (ref) {
              MockEntryData data;
@@ -54,9 +74,20 @@ public:
         if (mode & B_OPEN_AT_END) fPosition = content.length();
     }
 
-    status_t InitCheck() { return B_OK; }
+    status_t InitCheck() { return fStatus; }
 
     ssize_t Write(const void* buffer, size_t size) {
+        if (MockFileSystem::sFileContents) {
+            if (fStatus != B_OK)
+                return fStatus;
+            std::string& data = _Content();
+            if ((off_t)data.length() < fPosition)
+                data.resize(fPosition);
+            data.replace(fPosition, size, (const char*)buffer, size);
+            fPosition += size;
+            return size;
+        }
+
         // Simple append behavior for Write as commonly used in these tests
         // If we wanted to be strictly correct with fPosition:
         // if (fPosition < content.length()) { replace... } else { append... }
@@ -68,6 +99,7 @@ public:
     }
 
     ssize_t Read(void* buffer, size_t size) {
+        const std::string& content = _Content();
         if (fPosition >= (off_t)content.length()) return 0;
         size_t available = content.length() - fPosition;
         if (size > available) size = available;
@@ -76,16 +108,41 @@ public:
         return size;
     }
 
-    status_t GetSize(off_t* size) { *size = content.length(); return B_OK; }
-    status_t SetTo(const char* path, uint32 mode) { fPosition = 0; return B_OK; }
+    status_t GetSize(off_t* size) { *size = _Content().length(); return B_OK; }
+    status_t SetSize(off_t size) {
+        if (MockFileSystem::sFileContents && fStatus != B_OK)
+            return fStatus;
+        _Content().resize(size);
+        return B_OK;
+    }
+    status_t SetTo(const char* path, uint32 mode) {
+        if (MockFileSystem::sFileContents) {
+            *this = BFile(path, mode);
+            return fStatus;
+        }
+        fPosition = 0;
+        return B_OK;
+    }
     status_t SetTo(const BEntry* entry, uint32 mode) { fPosition = 0; return B_OK; }
-    void Unset() {}
+    void Unset() {
+        if (MockFileSystem::sFileContents) {
+            fPath.clear();
+            fStatus = B_NO_INIT;
+        }
+    }
+    status_t Sync() { return B_OK; }
 
     // Using BNode::ReadAttrString
     using BNode::ReadAttrString;
 
     ssize_t WriteAttrString(const char* name, const BString* data) {
-         if (data) fAttributes[name] = data->String();
+         if (data) {
+             fAttributes[name] = data->String();
+             std::map<std::string, MockEntryData>::iterator it
+                 = MockFileSystem::sEntries.find(fPath);
+             if (!fPath.empty() && it != MockFileSystem::sEntries.end())
+                 it->second.attributes[name] = data->String();
+         }
          return B_OK;
     }
 
@@ -94,5 +151,55 @@ public:
     }
 
     static std::string content;
+
+private:
+    std::string& _Content() {
+        if (!MockFileSystem::sFileContents)
+            return content;
+        std::map<std::string, MockEntryData>::iterator it
+            = MockFileSystem::sEntries.find(fPath);
+        // An open file stays the same when its entry is renamed
+        while (it == MockFileSystem::sEntries.end()
+            && MockFileSystem::sRenamed.count(fPath) > 0) {
+            fPath = MockFileSystem::sRenamed[fPath];
+            it = MockFileSystem::sEntries.find(fPath);
+        }
+        if (fPath.empty() || it == MockFileSystem::sEntries.end()) {
+            static std::string sNoContent;
+            sNoContent.clear();
+            return sNoContent;
+        }
+        return it->second.content;
+    }
+
+    std::string fPath;
+    status_t fStatus;
 };
+
+inline status_t
+BMessage::Flatten(BFile* file) const
+{
+    if (!MockFileSystem::sFileContents)
+        return B_OK;
+    std::string data = _Flatten();
+    ssize_t written = file->Write(data.data(), data.size());
+    return written == (ssize_t)data.size() ? B_OK : B_IO_ERROR;
+}
+
+inline status_t
+BMessage::Unflatten(BFile* file)
+{
+    if (!MockFileSystem::sFileContents)
+        return B_OK;
+    uint32 header[2];
+    if (file->Read(header, sizeof(header)) != (ssize_t)sizeof(header)
+        || header[1] < sizeof(header))
+        return B_BAD_DATA;
+    std::string data((const char*)header, sizeof(header));
+    data.resize(header[1]);
+    ssize_t size = header[1] - sizeof(header);
+    if (file->Read(&data[sizeof(header)], size) != size)
+        return B_BAD_DATA;
+    return Unflatten(data.data());
+}
 #endif
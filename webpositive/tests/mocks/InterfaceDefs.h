@@ -0,0 +1,33 @@
+#ifndef _MOCK_INTERFACE_DEFS_H
+#define _MOCK_INTERFACE_DEFS_H
+#include "SupportDefs.h"
+
+struct rgb_color {
+    uint8 red, green, blue, alpha;
+};
+
+static const rgb_color B_TRANSPARENT_32_BIT = { 0x77, 0x74, 0x77, 0x00 };
+
+enum color_which {
+    B_DOCUMENT_BACKGROUND_COLOR = 1,
+    B_DOCUMENT_TEXT_COLOR = 2
+};
+
+enum drawing_mode { B_OP_COPY, B_OP_ALPHA };
+
+enum {
+    B_FOLLOW_NONE = 0,
+    B_FOLLOW_ALL = 1,
+    B_WILL_DRAW = 2,
+    B_FULL_UPDATE_ON_RESIZE = 4
+};
+
+enum {
+    B_TRUNCATE_END = 0,
+    B_FILTER_BITMAP_BILINEAR = 1
+};
+
+enum pattern { B_SOLID_HIGH, B_SOLID_LOW };
+
+#define B_DARKEN_2_TINT 1.59f
+#endif
@@ -3,8 +3,10 @@
 #include "SupportDefs.h"
 #include "String.h"
 #include "Entry.h"
+#include "Bitmap.h"
 #include <map>
 #include <string>
+#include <string.h>
 #include <vector>
 
 class BFile;
@@ -73,6 +75,60 @@ public:
         int32s[name].push_back(value);
         return B_OK;
     }
+    status_t AddBool(const char* name, bool value) {
+        return AddInt32(name, value ? 1 : 0);
+    }
+    status_t FindBool(const char* name, bool* value) const {
+        int32 intValue;
+        if (FindInt32(name, 0, &intValue) != B_OK)
+            return B_ERROR;
+        *value = intValue != 0;
+        return B_OK;
+    }
+
+    int32 GetInt32(const char* name, int32 defaultValue) const {
+        int32 value;
+        return FindInt32(name, 0, &value) == B_OK ? value : defaultValue;
+    }
+    uint32 GetUInt32(const char* name, uint32 defaultValue) const {
+        uint32 value;
+        return FindUInt32(name, 0, &value) == B_OK ? value : defaultValue;
+    }
+    int64 GetInt64(const char* name, int64 defaultValue) const {
+        int64 value;
+        return FindInt64(name, 0, &value) == B_OK ? value : defaultValue;
+    }
+    bool GetBool(const char* name, bool defaultValue) const {
+        bool value;
+        return FindBool(name, &value) == B_OK ? value : defaultValue;
+    }
+    const char* GetString(const char* name, const char* defaultValue) const {
+        const char* value;
+        return FindString(name, 0, &value) == B_OK ? value : defaultValue;
+    }
+
+    status_t AddRect(const char* name, BRect rect) {
+        rects[name].push_back(rect);
+        return B_OK;
+    }
+    status_t FindRect(const char* name, BRect* rect) const {
+        if (!rects.count(name) || rects.at(name).empty())
+            return B_ERROR;
+        *rect = rects.at(name)[0];
+        return B_OK;
+    }
+    BRect GetRect(const char* name, const BRect& defaultValue) const {
+        BRect rect;
+        return FindRect(name, &rect) == B_OK ? rect : defaultValue;
+    }
+
+    status_t RemoveName(const char* name) {
+        size_t removed = int64s.erase(name) + int32s.erase(name)
+            + uint32s.erase(name) + strings.erase(name)
+            + messages.erase(name) + dataItems.erase(name)
+            + rects.erase(name);
+        return removed > 0 ? B_OK : B_NAME_NOT_FOUND;
+    }
 
     status_t FindUInt32(const char* name, uint32* value) const {
         return FindUInt32(name, 0, value);
@@ -138,8 +194,34 @@ public:
         return B_OK;
     }
 
-    status_t Flatten(BFile* file) { return B_OK; }
-    status_t Unflatten(BFile* file) { return B_OK; }
+    // Only write and read anything with MockFileSystem::sFileContents,
+    // see File.h
+    status_t Flatten(BFile* file) const;
+    status_t Unflatten(BFile* file);
+
+    // A format of its own, which only needs to survive a round trip
+    ssize_t FlattenedSize() const { return (ssize_t)_Flatten().size(); }
+    status_t Flatten(char* buffer, ssize_t size) const {
+        std::string data = _Flatten();
+        if (size < (ssize_t)data.size())
+            return B_BAD_VALUE;
+        memcpy(buffer, data.data(), data.size());
+        return B_OK;
+    }
+    status_t Unflatten(const char* buffer) {
+        uint32 magic;
+        uint32 size;
+        memcpy(&magic, buffer, sizeof(magic));
+        memcpy(&size, buffer + sizeof(magic), sizeof(size));
+        if (magic != kFlattenMagic || size < 2 * sizeof(uint32))
+            return B_BAD_DATA;
+        BMessage message;
+        const char* data = buffer + 2 * sizeof(uint32);
+        if (!message._Unflatten(data, buffer + size))
+            return B_BAD_DATA;
+        *this = message;
+        return B_OK;
+    }
 
     void MakeEmpty() {
         int64s.clear();
@@ -147,6 +229,8 @@ public:
         uint32s.clear();
         strings.clear();
         messages.clear();
+        dataItems.clear();
+        rects.clear();
     }
 
     status_t GetInfo(const char* name, type_code* type, int32* count) const {
@@ -185,5 +269,162 @@ public:
     std::map<std::string, std::vector<std::string> > strings;
     std::map<std::string, std::vector<BMessage> > messages;
     std::map<std::string, std::vector<std::vector<uint8_t> > > dataItems;
+    std::map<std::string, std::vector<BRect> > rects;
+
+private:
+    static constexpr uint32 kFlattenMagic = 'MFLT';
+
+    template<typename T>
+    static void _Put(std::string& data, const T& value) {
+        data.append((const char*)&value, sizeof(value));
+    }
+    static void _PutBytes(std::string& data, const void* bytes, size_t size) {
+        _Put(data, (uint32)size);
+        data.append((const char*)bytes, size);
+    }
+    template<typename T>
+    static void _PutValues(std::string& data,
+        const std::map<std::string, std::vector<T> >& values) {
+        _Put(data, (uint32)values.size());
+        for (const auto& field : values) {
+            _PutBytes(data, field.first.data(), field.first.size());
+            _Put(data, (uint32)field.second.size());
+            for (const T& value : field.second)
+                _Put(data, value);
+        }
+    }
+
+    template<typename T>
+    static bool _Get(const char*& data, const char* end, T& value) {
+        if (end - data < (ssize_t)sizeof(value))
+            return false;
+        memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        return true;
+    }
+    static bool _GetBytes(const char*& data, const char* end,
+        std::string& bytes) {
+        uint32 size;
+        if (!_Get(data, end, size) || (uint32)(end - data) < size)
+            return false;
+        bytes.assign(data, size);
+        data += size;
+        return true;
+    }
+    template<typename T>
+    static bool _GetValues(const char*& data, const char* end,
+        std::map<std::string, std::vector<T> >& values) {
+        uint32 count;
+        if (!_Get(data, end, count))
+            return false;
+        for (uint32 i = 0; i < count; i++) {
+            std::string name;
+            uint32 valueCount;
+            if (!_GetBytes(data, end, name) || !_Get(data, end, valueCount))
+                return false;
+            for (uint32 j = 0; j < valueCount; j++) {
+                T value;
+                if (!_Get(data, end, value))
+                    return false;
+                values[name].push_back(value);
+            }
+        }
+        return true;
+    }
+
+    std::string _Flatten() const {
+        std::string data;
+        _Put(data, what);
+        _PutValues(data, int64s);
+        _PutValues(data, int32s);
+        _PutValues(data, uint32s);
+        _PutValues(data, rects);
+
+        _Put(data, (uint32)strings.size());
+        for (const auto& field : strings) {
+            _PutBytes(data, field.first.data(), field.first.size());
+            _Put(data, (uint32)field.second.size());
+            for (const std::string& value : field.second)
+                _PutBytes(data, value.data(), value.size());
+        }
+        _Put(data, (uint32)dataItems.size());
+        for (const auto& field : dataItems) {
+            _PutBytes(data, field.first.data(), field.first.size());
+            _Put(data, (uint32)field.second.size());
+            for (const std::vector<uint8_t>& value : field.second)
+                _PutBytes(data, value.data(), value.size());
+        }
+        _Put(data, (uint32)messages.size());
+        for (const auto& field : messages) {
+            _PutBytes(data, field.first.data(), field.first.size());
+            _Put(data, (uint32)field.second.size());
+            for (const BMessage& value : field.second) {
+                std::string nested = value._Flatten();
+                _PutBytes(data, nested.data(), nested.size());
+            }
+        }
+
+        std::string header;
+        _Put(header, kFlattenMagic);
+        _Put(header, (uint32)(data.size() + 2 * sizeof(uint32)));
+        return header + data;
+    }
+
+    bool _Unflatten(const char*& data, const char* end) {
+        if (!_Get(data, end, what) || !_GetValues(data, end, int64s)
+            || !_GetValues(data, end, int32s)
+            || !_GetValues(data, end, uint32s)
+            || !_GetValues(data, end, rects)) {
+            return false;
+        }
+
+        uint32 count;
+        if (!_Get(data, end, count))
+            return false;
+        for (uint32 i = 0; i < count; i++) {
+            std::string name;
+            uint32 valueCount;
+            if (!_GetBytes(data, end, name) || !_Get(data, end, valueCount))
+                return false;
+            for (uint32 j = 0; j < valueCount; j++) {
+                std::string value;
+                if (!_GetBytes(data, end, value))
+                    return false;
+                strings[name].push_back(value);
+            }
+        }
+        if (!_Get(data, end, count))
+            return false;
+        for (uint32 i = 0; i < count; i++) {
+            std::string name;
+            uint32 valueCount;
+            if (!_GetBytes(data, end, name) || !_Get(data, end, valueCount))
+                return false;
+            for (uint32 j = 0; j < valueCount; j++) {
+                std::string value;
+                if (!_GetBytes(data, end, value))
+                    return false;
+                dataItems[name].push_back(
+                    std::vector<uint8_t>(value.begin(), value.end()));
+            }
+        }
+        if (!_Get(data, end, count))
+            return false;
+        for (uint32 i = 0; i < count; i++) {
+            std::string name;
+            uint32 valueCount;
+            if (!_GetBytes(data, end, name) || !_Get(data, end, valueCount))
+                return false;
+            for (uint32 j = 0; j < valueCount; j++) {
+                std::string value;
+                BMessage message;
+                if (!_GetBytes(data, end, value)
+                    || message.Unflatten(value.data()) != B_OK)
+                    return false;
+                messages[name].push_back(message);
+            }
+        }
+        return data == end;
+    }
 };
 #endif
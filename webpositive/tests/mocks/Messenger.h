@@ -1,9 +1,12 @@
 #ifndef _MESSENGER_H
 #define _MESSENGER_H
 #include "Handler.h"
+class BMessage;
 class BMessenger {
 public:
+    BMessenger() {}
     BMessenger(BHandler* handler) {}
     status_t SendMessage(uint32 command) { return B_OK; }
+    status_t SendMessage(BMessage* message) { return B_OK; }
 };
 #endif
@@ -20,12 +20,19 @@ public:
     static long sGetNextEntryCount;
     static long sOpenCount;
     static long sReadAttrCount;
+    // With it, every file keeps what is written to it, instead of all of
+    // them sharing BFile::content
+    static inline bool sFileContents = false;
+    // Where renamed entries went, so open files can follow them
+    static inline std::map<std::string, std::string> sRenamed;
 
     static void Reset() {
         sEntries.clear();
         sGetNextEntryCount = 0;
         sOpenCount = 0;
         sReadAttrCount = 0;
+        sFileContents = false;
+        sRenamed.clear();
     }
 
     static void AddEntry(const std::string& path, const MockEntryData& data) {
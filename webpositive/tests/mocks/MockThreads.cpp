@@ -0,0 +1,26 @@
+#include "OS.h"
+
+// Threads run right away when they are spawned, so whatever they do is
+// done by the time spawn_thread() returns.
+#include <map>
+
+static int32 sSpawnedThreads = 0;
+static std::map<thread_id, status_t> sThreadResults;
+
+thread_id spawn_thread(status_t (*func)(void*), const char* name, int32 priority, void* data) {
+    thread_id thread = ++sSpawnedThreads;
+    sThreadResults[thread] = func(data);
+    return thread;
+}
+status_t resume_thread(thread_id thread) { return B_OK; }
+status_t kill_thread(thread_id thread) { return B_OK; }
+status_t wait_for_thread(thread_id thread, status_t* returnValue) {
+    if (returnValue) *returnValue = sThreadResults[thread];
+    return B_OK;
+}
+int32_t atomic_add(int32_t* value, int32_t addvalue) {
+    int32_t old = *value;
+    *value += addvalue;
+    return old;
+}
+int32_t atomic_get(int32_t* value) { return *value; }
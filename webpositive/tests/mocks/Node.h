@@ -13,6 +13,11 @@ public:
     BNode(const BEntry* entry) {
         if (entry) fAttributes = entry->fAttributes;
     }
+    BNode(const char* path) {
+        MockEntryData data;
+        if (path && MockFileSystem::GetEntry(path, &data))
+            fAttributes = data.attributes;
+    }
     BNode(const entry_ref* ref) {
         if (ref) {
              MockEntryData data;
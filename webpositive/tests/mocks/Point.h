@@ -0,0 +1,15 @@
+#ifndef _MOCK_POINT_H
+#define _MOCK_POINT_H
+#include "SupportDefs.h"
+
+class BPoint {
+public:
+    float x, y;
+    BPoint() : x(0), y(0) {}
+    BPoint(float x, float y) : x(x), y(y) {}
+    bool operator==(const BPoint& other) const { return x == other.x && y == other.y; }
+    bool operator!=(const BPoint& other) const { return !(*this == other); }
+};
+
+static const BPoint B_ORIGIN(0, 0);
+#endif
@@ -0,0 +1,4 @@
+#ifndef _MOCK_RECT_H
+#define _MOCK_RECT_H
+#include "Bitmap.h"
+#endif
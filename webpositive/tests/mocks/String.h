@@ -135,7 +135,7 @@ public:
         s.erase(fromOffset, charCount);
     }
 
-    void SetTo(const char* str, int32 length) {
+    void SetTo(const char* str, int32 length = -1) {
         if (str == nullptr) {
             s.clear();
             return;
@@ -25,6 +25,9 @@ const status_t B_BAD_VALUE = -4; // Added B_BAD_VALUE
 const status_t B_ENTRY_NOT_FOUND = -5;
 const status_t B_ALREADY_RUNNING = -6;
 const status_t B_NAME_NOT_FOUND = -7;
+const status_t B_BAD_DATA = -8;
+const status_t B_FILE_EXISTS = -9;
+const status_t B_NO_INIT = -10;
 const uint32 B_NO_REPLY = 0;
 const type_code B_COLOR_8_BIT_TYPE = 1;
 const type_code B_STRING_TYPE = 'CSTR';
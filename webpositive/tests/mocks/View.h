@@ -0,0 +1,50 @@
+#ifndef _MOCK_VIEW_H
+#define _MOCK_VIEW_H
+#include "SupportDefs.h"
+#include "Bitmap.h"
+#include "InterfaceDefs.h"
+#include "Point.h"
+#include "String.h"
+
+struct font_height {
+    float ascent, descent, leading;
+};
+
+class BFont {
+public:
+    void TruncateString(BString* string, uint32 mode, float width) const {}
+    void GetHeight(font_height* height) const
+        { height->ascent = 10; height->descent = 3; height->leading = 0; }
+    float StringWidth(const char* string) const { return 0; }
+};
+
+// Nothing is drawn, views only exist to be told apart
+class BView {
+public:
+    BView(const char* name, uint32 flags) {}
+    BView(BRect frame, const char* name, uint32 resizingMode, uint32 flags)
+        : fBounds(frame) {}
+    virtual ~BView() {}
+
+    virtual void Draw(BRect updateRect) {}
+
+    BRect Bounds() const { return fBounds; }
+    BRect Frame() const { return fBounds; }
+    void Invalidate() {}
+    void Sync() {}
+    void GetFont(BFont* font) const {}
+    void SetViewUIColor(color_which which, float tint = 0) {}
+    void SetLowUIColor(color_which which, float tint = 0) {}
+    void SetHighUIColor(color_which which, float tint = 0) {}
+    void SetHighColor(rgb_color color) {}
+    void SetDrawingMode(drawing_mode mode) {}
+    void FillRect(BRect rect, pattern p = B_SOLID_HIGH) {}
+    void DrawString(const char* string, BPoint where) {}
+    void DrawBitmap(const BBitmap* bitmap, BRect target) {}
+    void DrawBitmap(const BBitmap* bitmap, BRect source, BRect target,
+        uint32 options = 0) {}
+
+private:
+    BRect fBounds;
+};
+#endif
@@ -0,0 +1,24 @@
+#ifndef _MOCK_WEB_VIEW_H
+#define _MOCK_WEB_VIEW_H
+#include "View.h"
+
+class BWebView : public BView {
+public:
+    class UserData {
+    public:
+        virtual ~UserData() {}
+    };
+
+    // Like the real one, the user data is left to whoever set it
+    BWebView(const char* name) : BView(name, 0), fUserData(NULL) {}
+    virtual ~BWebView() {}
+
+    void SetUserData(UserData* userData) { fUserData = userData; }
+    UserData* GetUserData() const { return fUserData; }
+
+    void Shutdown() {}
+
+private:
+    UserData* fUserData;
+};
+#endif
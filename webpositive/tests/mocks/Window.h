@@ -0,0 +1,9 @@
+#ifndef _MOCK_WINDOW_H
+#define _MOCK_WINDOW_H
+#include "SupportDefs.h"
+
+enum {
+    B_CURRENT_WORKSPACE = 0,
+    B_ALL_WORKSPACES = 0xffffffff
+};
+#endif